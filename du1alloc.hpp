@@ -0,0 +1,360 @@
+#ifndef DU1_ALLOC_HPP
+#define DU1_ALLOC_HPP
+
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+//   Allocators for matrix storage
+//   =============================
+//
+//   aligned_allocator<T, Align>
+//     Every buffer starts on an Align byte boundary (64 by default, a cache
+//     line and a full AVX-512 register; page_aligned_allocator uses 4096).
+//
+//   arena_allocator<T> over a monotonic_arena
+//     Allocation bumps a pointer inside large blocks owned by the arena,
+//     deallocation does nothing. monotonic_arena::reset() makes the whole
+//     arena available again (keeping its blocks), which suits request-scoped
+//     temporaries: reset once per request instead of freeing every matrix.
+//
+//   pool_allocator<T> over a buffer_pool
+//     Freed buffers are kept in per-size free lists (sizes are rounded up to
+//     a multiple of a cache line) and handed out again to the next request of
+//     the same size, so matrices of the same shape that are created and
+//     destroyed in every iteration stop hitting malloc after the first one.
+//
+//   All of them return 64-byte aligned storage. The arena and the pool are
+// referenced, not owned, by their allocators and must outlive every matrix
+// using them. Arena and pool allocators propagate on copy assignment, move
+// assignment and swap, so that the storage always stays with the resource it
+// came from.
+//
+namespace du1_detail
+{
+    inline std::size_t checked_bytes(std::size_t n, std::size_t size)
+    {
+        if (n > std::numeric_limits<std::size_t>::max() / size)
+            throw std::bad_array_new_length();
+
+        return n * size;
+    }
+
+    inline std::size_t align_up(std::size_t n, std::size_t alignment)
+    {
+        return (n + alignment - 1) / alignment * alignment;
+    }
+
+    constexpr std::size_t storage_alignment = 64;
+}
+
+template <typename T, std::size_t Align = du1_detail::storage_alignment>
+class aligned_allocator
+{
+    static_assert(Align >= alignof(T) && (Align & (Align - 1)) == 0,
+                  "alignment must be a power of two and at least alignof(T)");
+
+public:
+    typedef T value_type;
+
+    typedef std::true_type is_always_equal;
+
+    template <typename U>
+    struct rebind
+    {
+        typedef aligned_allocator<U, Align> other;
+    };
+
+    aligned_allocator()
+    { }
+
+    template <typename U>
+    aligned_allocator(const aligned_allocator<U, Align>&)
+    { }
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(::operator new(du1_detail::checked_bytes(n, sizeof(T)),
+                                              std::align_val_t(Align)));
+    }
+
+    void deallocate(T* p, std::size_t)
+    {
+        ::operator delete(p, std::align_val_t(Align));
+    }
+
+    template <typename U>
+    bool operator==(const aligned_allocator<U, Align>&) const
+    {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const aligned_allocator<U, Align>&) const
+    {
+        return false;
+    }
+};
+
+template <typename T>
+using page_aligned_allocator = aligned_allocator<T, 4096>;
+
+class monotonic_arena
+{
+public:
+    explicit monotonic_arena(std::size_t block_size = 1 << 20)
+        : blocks_()
+        , block_size_(du1_detail::align_up(block_size > 0 ? block_size : 1,
+                                         du1_detail::storage_alignment))
+        , current_()
+        , offset_()
+    { }
+
+    monotonic_arena(const monotonic_arena&) = delete;
+    monotonic_arena& operator=(const monotonic_arena&) = delete;
+
+    ~monotonic_arena()
+    {
+        for (const block& b : blocks_)
+            ::operator delete(b.memory, std::align_val_t(du1_detail::storage_alignment));
+    }
+
+    void* allocate(std::size_t bytes)
+    {
+        bytes = du1_detail::align_up(bytes > 0 ? bytes : 1, du1_detail::storage_alignment);
+
+        // Move on to the next block (reusing blocks kept by reset()) until
+        // the request fits.
+        while (current_ < blocks_.size() && offset_ + bytes > blocks_[current_].size)
+        {
+            ++current_;
+            offset_ = 0;
+        }
+
+        if (current_ == blocks_.size())
+        {
+            std::size_t size = bytes > block_size_ ? bytes : block_size_;
+            block b = { ::operator new(size, std::align_val_t(du1_detail::storage_alignment)), size };
+
+            blocks_.push_back(b);
+            offset_ = 0;
+
+            // Grow geometrically so that large arenas need few blocks.
+            block_size_ *= 2;
+        }
+
+        void* result = static_cast<char*>(blocks_[current_].memory) + offset_;
+        offset_ += bytes;
+        return result;
+    }
+
+    // Every pointer handed out so far becomes invalid; the memory is kept.
+    void reset()
+    {
+        current_ = 0;
+        offset_ = 0;
+    }
+
+    // Total size of the blocks owned by the arena.
+    std::size_t capacity() const
+    {
+        std::size_t total = 0;
+        for (const block& b : blocks_)
+            total += b.size;
+        return total;
+    }
+
+private:
+    struct block
+    {
+        void*       memory;
+        std::size_t size;
+    };
+
+    std::vector<block> blocks_;
+    std::size_t        block_size_;
+    std::size_t        current_;
+    std::size_t        offset_;
+};
+
+template <typename T>
+class arena_allocator
+{
+    template <typename>
+    friend class arena_allocator;
+
+public:
+    typedef T value_type;
+
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    explicit arena_allocator(monotonic_arena& arena)
+        : arena_(&arena)
+    { }
+
+    template <typename U>
+    arena_allocator(const arena_allocator<U>& other)
+        : arena_(other.arena_)
+    { }
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(arena_->allocate(du1_detail::checked_bytes(n, sizeof(T))));
+    }
+
+    void deallocate(T*, std::size_t)
+    { }
+
+    monotonic_arena& arena() const
+    {
+        return *arena_;
+    }
+
+    template <typename U>
+    bool operator==(const arena_allocator<U>& other) const
+    {
+        return arena_ == other.arena_;
+    }
+
+    template <typename U>
+    bool operator!=(const arena_allocator<U>& other) const
+    {
+        return !(*this == other);
+    }
+
+private:
+    monotonic_arena* arena_;
+};
+
+class buffer_pool
+{
+public:
+    buffer_pool()
+    { }
+
+    buffer_pool(const buffer_pool&) = delete;
+    buffer_pool& operator=(const buffer_pool&) = delete;
+
+    ~buffer_pool()
+    {
+        release();
+    }
+
+    void* allocate(std::size_t bytes)
+    {
+        bytes = size_class(bytes);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::vector<void*>& free = free_[bytes];
+
+            if (!free.empty())
+            {
+                void* p = free.back();
+                free.pop_back();
+                return p;
+            }
+        }
+
+        return ::operator new(bytes, std::align_val_t(du1_detail::storage_alignment));
+    }
+
+    void deallocate(void* p, std::size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_[size_class(bytes)].push_back(p);
+    }
+
+    // Frees all cached buffers. Buffers still in use are not affected.
+    void release()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        for (auto& entry : free_)
+            for (void* p : entry.second)
+                ::operator delete(p, std::align_val_t(du1_detail::storage_alignment));
+
+        free_.clear();
+    }
+
+    // Number of bytes held in the free lists.
+    std::size_t cached() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        std::size_t total = 0;
+        for (const auto& entry : free_)
+            total += entry.first * entry.second.size();
+        return total;
+    }
+
+private:
+    static std::size_t size_class(std::size_t bytes)
+    {
+        return du1_detail::align_up(bytes > 0 ? bytes : 1, du1_detail::storage_alignment);
+    }
+
+    mutable std::mutex                                   mutex_;
+    std::unordered_map<std::size_t, std::vector<void*> > free_;
+};
+
+template <typename T>
+class pool_allocator
+{
+    template <typename>
+    friend class pool_allocator;
+
+public:
+    typedef T value_type;
+
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    explicit pool_allocator(buffer_pool& pool)
+        : pool_(&pool)
+    { }
+
+    template <typename U>
+    pool_allocator(const pool_allocator<U>& other)
+        : pool_(other.pool_)
+    { }
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(pool_->allocate(du1_detail::checked_bytes(n, sizeof(T))));
+    }
+
+    void deallocate(T* p, std::size_t n)
+    {
+        pool_->deallocate(p, n * sizeof(T));
+    }
+
+    buffer_pool& pool() const
+    {
+        return *pool_;
+    }
+
+    template <typename U>
+    bool operator==(const pool_allocator<U>& other) const
+    {
+        return pool_ == other.pool_;
+    }
+
+    template <typename U>
+    bool operator!=(const pool_allocator<U>& other) const
+    {
+        return !(*this == other);
+    }
+
+private:
+    buffer_pool* pool_;
+};
+
+#endif // DU1_ALLOC_HPP
@@ -0,0 +1,417 @@
+#ifndef DU1_BATCH_HPP
+#define DU1_BATCH_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "du1debug.hpp"
+#include "du1matrix.hpp"
+#include "du1parallel.hpp"
+
+//   matrix_batch class template
+//   ===========================
+//
+//   Overview
+//   --------
+//
+//   size() matrices of the same height() * width(), stored interleaved: all
+// elements (0, 0) of the batch come first, one per matrix, then all elements
+// (0, 1), and so on. Element (i, j) of consecutive matrices is therefore
+// contiguous (lane(i, j) returns them as a std::span), which is what lets the
+// batched operations run one SIMD lane per matrix:
+//
+//   multiply(a, b), a * b  - the products of the corresponding matrices
+//   transpose()            - a batch of the transposed matrices
+//   sums(b), mins(b), maxs(b)
+//                          - one value per matrix, as a std::vector
+//
+// all of which optionally take an execution policy of du1parallel.hpp as
+// their first argument (transpose() does not). A thousand 4 * 4 matrices
+// then take a single allocation instead of a thousand, and a product runs
+// through the batch with vector instructions instead of one small matrix at
+// a time.
+//
+//   operator[](k) returns matrix k as a matrix_view, whose rows(), cols(),
+// operator[] and row_t, col_t proxies work as usual (the steps between the
+// elements are just larger). get(k) copies it into a matrix, set(k, m) copies
+// a matrix or a view of the right shape into the batch.
+//
+//   Implementation details
+//   ----------------------
+//
+//   The distance between the lanes of two elements (lane_stride()) is the
+// batch size rounded up to a whole number of cache lines, so with an aligned
+// allocator every lane starts on a cache line boundary. The batched
+// operations process the matrices in blocks of lanes small enough for all
+// the lanes of the operands and the result to stay in L1 (the block size only
+// depends on the shapes), and hand whole blocks to the threads.
+//
+template <typename T, typename Alloc = std::allocator<T>, typename Check = default_checks>
+class matrix_batch
+{
+    typedef matrix_batch<T, Alloc, Check> self;
+
+public:
+    typedef Alloc          allocator_type;
+    typedef T              value_type;
+    typedef T&             reference;
+    typedef T*             pointer;
+    typedef const T&       const_reference;
+    typedef const T*       const_pointer;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::size_t    size_type;
+
+    typedef matrix_view<T, Check>       item_type;
+    typedef matrix_view<const T, Check> const_item_type;
+
+    // Constructors.
+    matrix_batch()
+        : data_()
+        , size_()
+        , height_()
+        , width_()
+        , stride_()
+    { }
+
+    matrix_batch(size_type count, size_type height, size_type width,
+                 const value_type& def = value_type(), const allocator_type& alloc = allocator_type())
+        : data_(alloc)
+        , size_(count)
+        , height_(height)
+        , width_(width)
+        , stride_(lane_stride_for(count))
+    {
+        data_.assign(height * width * stride_, def);
+    }
+
+    // Element (i, j) of matrix k is f(k, i, j).
+    template <typename F, typename = decltype(std::declval<F&>()(size_type(), size_type(), size_type()))>
+    matrix_batch(size_type count, size_type height, size_type width, F f,
+                 const allocator_type& alloc = allocator_type())
+        : matrix_batch(count, height, width, value_type(), alloc)
+    {
+        for (size_type i = 0; i < height_; ++i)
+            for (size_type j = 0; j < width_; ++j)
+            {
+                pointer lane = lane_data(i, j);
+                for (size_type k = 0; k < size_; ++k)
+                    lane[k] = f(k, i, j);
+            }
+    }
+
+    allocator_type get_allocator() const
+    {
+        return data_.get_allocator();
+    }
+
+    // Number of matrices and their extents.
+    size_type size() const
+    {
+        return size_;
+    }
+
+    size_type height() const
+    {
+        return height_;
+    }
+
+    size_type width() const
+    {
+        return width_;
+    }
+
+    // Matrix k of the batch.
+    item_type operator[](size_type k)
+    {
+        du_check(Check::indices, k < size_);
+
+        return item_type(data_.data() + k, height_, width_, row_step(), col_step());
+    }
+
+    const_item_type operator[](size_type k) const
+    {
+        du_check(Check::indices, k < size_);
+
+        return const_item_type(data_.data() + k, height_, width_, row_step(), col_step());
+    }
+
+    matrix<T> get(size_type k) const
+    {
+        return matrix<T>((*this)[k]);
+    }
+
+    // M is a matrix or a matrix_view of height() * width() elements.
+    template <typename M>
+    void set(size_type k, const M& m)
+    {
+        du_check(Check::indices, m.rows().size() == height_ && m.cols().size() == width_);
+
+        item_type item = (*this)[k];
+        for (size_type i = 0; i < height_; ++i)
+            std::copy(m[i].begin(), m[i].end(), item[i].begin());
+    }
+
+    // Element (i, j) of every matrix of the batch.
+    std::span<T> lane(size_type i, size_type j)
+    {
+        du_check(Check::indices, i < height_ && j < width_);
+
+        return std::span<T>(lane_data(i, j), size_);
+    }
+
+    std::span<const T> lane(size_type i, size_type j) const
+    {
+        du_check(Check::indices, i < height_ && j < width_);
+
+        return std::span<const T>(lane_data(i, j), size_);
+    }
+
+    // Raw access: element (i, j) of matrix k is located at
+    // data()[(i * width() + j) * lane_stride() + k].
+    pointer data()
+    {
+        return data_.data();
+    }
+
+    const_pointer data() const
+    {
+        return data_.data();
+    }
+
+    size_type lane_stride() const
+    {
+        return stride_;
+    }
+
+    self transpose() const
+    {
+        self result(size_, width_, height_, value_type(), get_allocator());
+
+        for (size_type i = 0; i < height_; ++i)
+            for (size_type j = 0; j < width_; ++j)
+                std::copy_n(lane_data(i, j), size_, result.lane_data(j, i));
+
+        return result;
+    }
+
+private:
+    template <typename, typename, typename>
+    friend class matrix_batch;
+
+    template <typename Policy, typename U, typename A, typename C, typename F>
+    friend void batch_for(const Policy& policy, const matrix_batch<U, A, C>& batch,
+                          std::size_t lanes_per_item, F f);
+
+    static size_type lane_stride_for(size_type count)
+    {
+        size_type line = sizeof(T) < 64 ? 64 / sizeof(T) : 1;
+        return (count + line - 1) / line * line;
+    }
+
+    difference_type row_step() const
+    {
+        return static_cast<difference_type>(width_ * stride_);
+    }
+
+    difference_type col_step() const
+    {
+        return static_cast<difference_type>(stride_);
+    }
+
+    pointer lane_data(size_type i, size_type j)
+    {
+        return data_.data() + (i * width_ + j) * stride_;
+    }
+
+    const_pointer lane_data(size_type i, size_type j) const
+    {
+        return data_.data() + (i * width_ + j) * stride_;
+    }
+
+    std::vector<value_type, du1_detail::default_init_allocator<allocator_type> > data_;
+    size_type size_;
+    size_type height_;
+    size_type width_;
+    size_type stride_;
+};
+
+// Calls f(first, last) for blocks of matrices [first, last) of the batch,
+// small enough for lanes_per_item lanes of every block to fit into L1.
+template <typename Policy, typename T, typename A, typename C, typename F>
+void batch_for(const Policy& policy, const matrix_batch<T, A, C>& batch, std::size_t lanes_per_item, F f)
+{
+    std::size_t line = sizeof(T) < 64 ? 64 / sizeof(T) : 1;
+    std::size_t block = 32768 / (std::max<std::size_t>(lanes_per_item, 1) * sizeof(T)) / line * line;
+    block = std::max(block, line);
+
+    std::size_t blocks = (batch.size() + block - 1) / block;
+    auto body = [&](std::size_t first, std::size_t last)
+    {
+        for (std::size_t b = first; b < last; ++b)
+            f(b * block, std::min(batch.size(), (b + 1) * block));
+    };
+
+    if constexpr (std::is_same<Policy, matrix_execution::sequenced_policy>::value)
+        body(0, blocks);
+    else
+        policy.get_pool().parallel_for(blocks, 1, body);
+}
+
+// c[k] = a[k] * b[k] for every matrix k; the result has the allocator and
+// the check policy of a.
+template <typename Policy, typename T, typename A1, typename C1, typename A2, typename C2,
+          typename = typename std::enable_if<matrix_execution::is_execution_policy<Policy>::value>::type>
+matrix_batch<T, A1, C1> multiply(const Policy& policy, const matrix_batch<T, A1, C1>& a,
+                                 const matrix_batch<T, A2, C2>& b)
+{
+    du_check(C1::indices || C2::indices, a.size() == b.size() && a.width() == b.height());
+
+    std::size_t m = a.height();
+    std::size_t n = b.width();
+    std::size_t p = a.width();
+
+    matrix_batch<T, A1, C1> c(a.size(), m, n, T(), a.get_allocator());
+
+    const T* ad = a.data();
+    const T* bd = b.data();
+    T* cd = c.data();
+    std::size_t as = a.lane_stride();
+    std::size_t bs = b.lane_stride();
+    std::size_t cs = c.lane_stride();
+
+    batch_for(policy, a, m * p + p * n + m * n, [&](std::size_t first, std::size_t last)
+    {
+        // The sums are accumulated in a local array, which the compiler
+        // knows not to alias the operands, and stored once.
+        constexpr std::size_t width = 64;
+        T acc[width];
+
+        for (std::size_t l0 = first; l0 < last; l0 += width)
+        {
+            std::size_t w = std::min(width, last - l0);
+
+            for (std::size_t i = 0; i < m; ++i)
+                for (std::size_t j = 0; j < n; ++j)
+                {
+                    std::fill_n(acc, w, T());
+
+                    for (std::size_t k = 0; k < p; ++k)
+                    {
+                        const T* x = ad + (i * p + k) * as + l0;
+                        const T* y = bd + (k * n + j) * bs + l0;
+
+                        for (std::size_t l = 0; l < w; ++l)
+                            acc[l] = acc[l] + x[l] * y[l];
+                    }
+
+                    std::copy_n(acc, w, cd + (i * n + j) * cs + l0);
+                }
+        }
+    });
+
+    return c;
+}
+
+template <typename T, typename A1, typename C1, typename A2, typename C2>
+matrix_batch<T, A1, C1> multiply(const matrix_batch<T, A1, C1>& a, const matrix_batch<T, A2, C2>& b)
+{
+    return multiply(matrix_execution::seq, a, b);
+}
+
+template <typename T, typename A1, typename C1, typename A2, typename C2>
+matrix_batch<T, A1, C1> operator*(const matrix_batch<T, A1, C1>& a, const matrix_batch<T, A2, C2>& b)
+{
+    return multiply(a, b);
+}
+
+namespace du1_detail
+{
+    // result[k] = op(...op(op(init, element 0 of matrix k), element 1)...),
+    // elements taken row by row.
+    template <typename Policy, typename T, typename A, typename C, typename Init, typename Op>
+    std::vector<T> batch_reduce(const Policy& policy, const matrix_batch<T, A, C>& batch, Init init, Op op)
+    {
+        std::vector<T> result(batch.size());
+        std::size_t elements = batch.height() * batch.width();
+        if (elements == 0)
+            return result;
+
+        const T* data = batch.data();
+        std::size_t stride = batch.lane_stride();
+
+        batch_for(policy, batch, elements + 1, [&](std::size_t first, std::size_t last)
+        {
+            T* out = result.data();
+
+            for (std::size_t l = first; l < last; ++l)
+                out[l] = init(data[l]);
+
+            for (std::size_t e = 1; e < elements; ++e)
+            {
+                const T* lane = data + e * stride;
+                for (std::size_t l = first; l < last; ++l)
+                    out[l] = op(out[l], lane[l]);
+            }
+        });
+
+        return result;
+    }
+}
+
+// Sum of the elements of every matrix.
+template <typename Policy, typename T, typename A, typename C,
+          typename = typename std::enable_if<matrix_execution::is_execution_policy<Policy>::value>::type>
+std::vector<T> sums(const Policy& policy, const matrix_batch<T, A, C>& batch)
+{
+    return du1_detail::batch_reduce(policy, batch,
+                                    [](const T& x) { return x; },
+                                    [](const T& s, const T& x) { return s + x; });
+}
+
+template <typename T, typename A, typename C>
+std::vector<T> sums(const matrix_batch<T, A, C>& batch)
+{
+    return sums(matrix_execution::seq, batch);
+}
+
+// Smallest and largest element of every matrix; the matrices must not be
+// empty.
+template <typename Policy, typename T, typename A, typename C,
+          typename = typename std::enable_if<matrix_execution::is_execution_policy<Policy>::value>::type>
+std::vector<T> mins(const Policy& policy, const matrix_batch<T, A, C>& batch)
+{
+    du_check(C::indices, batch.height() * batch.width() > 0);
+
+    return du1_detail::batch_reduce(policy, batch,
+                                    [](const T& x) { return x; },
+                                    [](const T& m, const T& x) { return x < m ? x : m; });
+}
+
+template <typename T, typename A, typename C>
+std::vector<T> mins(const matrix_batch<T, A, C>& batch)
+{
+    return mins(matrix_execution::seq, batch);
+}
+
+template <typename Policy, typename T, typename A, typename C,
+          typename = typename std::enable_if<matrix_execution::is_execution_policy<Policy>::value>::type>
+std::vector<T> maxs(const Policy& policy, const matrix_batch<T, A, C>& batch)
+{
+    du_check(C::indices, batch.height() * batch.width() > 0);
+
+    return du1_detail::batch_reduce(policy, batch,
+                                    [](const T& x) { return x; },
+                                    [](const T& m, const T& x) { return m < x ? x : m; });
+}
+
+template <typename T, typename A, typename C>
+std::vector<T> maxs(const matrix_batch<T, A, C>& batch)
+{
+    return maxs(matrix_execution::seq, batch);
+}
+
+#endif // DU1_BATCH_HPP
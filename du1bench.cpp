@@ -0,0 +1,488 @@
+#include "du1matrix.hpp"
+#include "du1multiply.hpp"
+#include "du1expr.hpp"
+#include "du1parallel.hpp"
+#include "du1reduce.hpp"
+#include "du1batch.hpp"
+#include "du1tracked.hpp"
+#include "du1sparse.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+//   Matrix benchmarks
+//   =================
+//
+//   Measures traversal (through proxies and through raw pointers, row by row
+// and column by column), construction, copy and move, and the kernels
+// (multiplication, element-wise expressions, transform, reductions,
+// transposition, sparse matrix-vector product, products of batches of 4 * 4
+// matrices, batched and one by one, refreshing tracked row and column sums
+// after a few writes) for int, double and Complex, on square
+// matrices whose storage is about the size of an L1 cache (16 KiB), an L2
+// cache (256 KiB), a last level cache slice (4 MiB) and larger than any last
+// level cache (64 MiB). The multiplication stops at 4 MiB, the larger size
+// would take minutes per type.
+//
+//   Every benchmark is repeated in batches of growing length until it has
+// run for --min-time seconds; the fastest batch is reported, as time per
+// iteration and items (elements, or multiply-adds for the products) per
+// second. Usage:
+//
+//   du1bench [--json FILE] [--filter TEXT] [--min-time SECONDS] [--max-bytes N]
+//
+//   --json writes the results for du1bench_compare.py, which flags
+// regressions against a stored baseline. --filter runs the benchmarks whose
+// name (e.g. "multiply/double/724") contains TEXT, --max-bytes skips the
+// sizes above N bytes per matrix.
+//
+//   Build with optimizations, DU_NDEBUG and the target instruction set,
+// which the CMake project does for the du1bench target (see CMakeLists.txt):
+//
+//   g++ -std=c++20 -O3 -march=native -DDU_NDEBUG -pthread du1bench.cpp du1matrix.cpp
+
+struct Complex
+{
+    double re;
+    double im;
+};
+
+Complex operator+(const Complex& a, const Complex& b)
+{
+    Complex r = { a.re + b.re, a.im + b.im };
+    return r;
+}
+
+Complex operator*(const Complex& a, const Complex& b)
+{
+    Complex r = { a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re };
+    return r;
+}
+
+bool operator==(const Complex& a, const Complex& b)
+{
+    return a.re == b.re && a.im == b.im;
+}
+
+namespace
+{
+    typedef std::chrono::steady_clock bench_clock;
+
+    // Small values, so that the integer sums do not overflow.
+    template <typename T>
+    T element(std::size_t i, std::size_t j)
+    {
+        return static_cast<T>((i * 31 + j * 17) % 7);
+    }
+
+    template <>
+    Complex element<Complex>(std::size_t i, std::size_t j)
+    {
+        Complex c = { static_cast<double>((i * 31 + j * 17) % 7), static_cast<double>((i + j) % 3) };
+        return c;
+    }
+
+    // About one element in 16 is stored.
+    template <typename T>
+    T sparse_element(std::size_t i, std::size_t j)
+    {
+        return (i + 3 * j) % 16 == 0 ? element<T>(i, j + 1) : T();
+    }
+
+    template <typename T>
+    matrix<T> make_input(std::size_t n)
+    {
+        return matrix<T>(n, n, [](std::size_t i, std::size_t j) { return element<T>(i, j); });
+    }
+
+    // Keeps the optimizer from discarding a computed value.
+    template <typename T>
+    void keep(const T& value)
+    {
+#if defined(__GNUC__)
+        asm volatile("" : : "g"(&value) : "memory");
+#else
+        static const void* volatile sink;
+        sink = &value;
+#endif
+    }
+
+    struct options
+    {
+        options()
+            : json()
+            , filter()
+            , min_time(0.1)
+            , max_bytes(64u << 20)
+        { }
+
+        std::string json;
+        std::string filter;
+        double      min_time;
+        std::size_t max_bytes;
+    };
+
+    struct result
+    {
+        std::string name;
+        std::string type;
+        std::size_t n;
+        std::size_t bytes;
+        std::size_t iterations;
+        double      ns_per_iteration;
+        double      items_per_second;
+    };
+
+    class runner
+    {
+    public:
+        explicit runner(const options& opts)
+            : opts_(opts)
+            , results_()
+        { }
+
+        bool enabled(const std::string& name) const
+        {
+            return opts_.filter.empty() || name.find(opts_.filter) != std::string::npos;
+        }
+
+        // Runs body() repeatedly; items is the amount of work of one call.
+        template <typename F>
+        void run(const char* benchmark, const char* type, std::size_t n, std::size_t bytes,
+                 double items, F body)
+        {
+            std::string name = std::string(benchmark) + "/" + type + "/" + std::to_string(n);
+            if (!enabled(name))
+                return;
+
+            body();
+
+            std::size_t batch = 1;
+            std::size_t iterations = 0;
+            double total = 0.0;
+            double best = std::numeric_limits<double>::infinity();
+
+            while (total < opts_.min_time)
+            {
+                bench_clock::time_point start = bench_clock::now();
+                for (std::size_t r = 0; r < batch; ++r)
+                    body();
+                double seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+
+                best = std::min(best, seconds / static_cast<double>(batch));
+                total += seconds;
+                iterations += batch;
+
+                if (seconds < opts_.min_time / 8)
+                    batch *= 2;
+            }
+
+            result r = { name, type, n, bytes, iterations, best * 1e9, items / best };
+            results_.push_back(r);
+
+            std::printf("%-36s %14.1f ns %12.3f Gitems/s\n",
+                        name.c_str(), r.ns_per_iteration, r.items_per_second * 1e-9);
+            std::fflush(stdout);
+        }
+
+        bool write_json(const std::string& path) const
+        {
+            std::FILE* f = std::fopen(path.c_str(), "w");
+            if (!f)
+                return false;
+
+            std::fprintf(f, "{\n  \"context\": {\"min_time\": %g, \"max_bytes\": %zu},\n",
+                         opts_.min_time, opts_.max_bytes);
+            std::fprintf(f, "  \"benchmarks\": [\n");
+
+            for (std::size_t k = 0; k < results_.size(); ++k)
+            {
+                const result& r = results_[k];
+                std::fprintf(f, "    {\"name\": \"%s\", \"type\": \"%s\", \"n\": %zu, \"bytes\": %zu, "
+                                "\"iterations\": %zu, \"real_time\": %.3f, \"time_unit\": \"ns\", "
+                                "\"items_per_second\": %.6g}%s\n",
+                             r.name.c_str(), r.type.c_str(), r.n, r.bytes, r.iterations,
+                             r.ns_per_iteration, r.items_per_second,
+                             k + 1 < results_.size() ? "," : "");
+            }
+
+            std::fprintf(f, "  ]\n}\n");
+            return std::fclose(f) == 0;
+        }
+
+    private:
+        const options&      opts_;
+        std::vector<result> results_;
+    };
+
+    // Sum of all elements, visited row by row or column by column.
+    template <typename T>
+    void bench_traversal(runner& run, const char* type, std::size_t n, std::size_t bytes)
+    {
+        matrix<T> a = make_input<T>(n);
+        double items = static_cast<double>(n * n);
+
+        run.run("traverse_rows_proxy", type, n, bytes, items, [&]
+        {
+            T sum = T();
+            for (auto row : a.crows())
+                for (const T& x : row)
+                    sum = sum + x;
+            keep(sum);
+        });
+
+        run.run("traverse_cols_proxy", type, n, bytes, items, [&]
+        {
+            T sum = T();
+            for (auto col : a.ccols())
+                for (const T& x : col)
+                    sum = sum + x;
+            keep(sum);
+        });
+
+        run.run("traverse_rows_raw", type, n, bytes, items, [&]
+        {
+            const T* p = a.data();
+            std::ptrdiff_t rs = a.row_step();
+            std::ptrdiff_t cs = a.col_step();
+            T sum = T();
+            for (std::size_t i = 0; i < n; ++i)
+                for (std::size_t j = 0; j < n; ++j)
+                    sum = sum + p[static_cast<std::ptrdiff_t>(i) * rs + static_cast<std::ptrdiff_t>(j) * cs];
+            keep(sum);
+        });
+
+        run.run("traverse_cols_raw", type, n, bytes, items, [&]
+        {
+            const T* p = a.data();
+            std::ptrdiff_t rs = a.row_step();
+            std::ptrdiff_t cs = a.col_step();
+            T sum = T();
+            for (std::size_t j = 0; j < n; ++j)
+                for (std::size_t i = 0; i < n; ++i)
+                    sum = sum + p[static_cast<std::ptrdiff_t>(i) * rs + static_cast<std::ptrdiff_t>(j) * cs];
+            keep(sum);
+        });
+    }
+
+    template <typename T>
+    void bench_construction(runner& run, const char* type, std::size_t n, std::size_t bytes)
+    {
+        matrix<T> a = make_input<T>(n);
+        double items = static_cast<double>(n * n);
+
+        run.run("construct_fill", type, n, bytes, items, [&]
+        {
+            matrix<T> m(n, n, T());
+            keep(*m.data());
+        });
+
+        run.run("construct_generate", type, n, bytes, items, [&]
+        {
+            matrix<T> m(n, n, [](std::size_t i, std::size_t j) { return element<T>(i, j); });
+            keep(*m.data());
+        });
+
+        run.run("copy", type, n, bytes, items, [&]
+        {
+            matrix<T> m(a);
+            keep(*m.data());
+        });
+
+        run.run("move", type, n, bytes, 1.0, [&]
+        {
+            matrix<T> m(std::move(a));
+            a = std::move(m);
+            keep(*a.data());
+        });
+    }
+
+    template <typename T>
+    void bench_kernels(runner& run, const char* type, std::size_t n, std::size_t bytes)
+    {
+        matrix<T> a = make_input<T>(n);
+        matrix<T> b = make_input<T>(n).transpose();
+        matrix<T> c(n, n, T());
+        double items = static_cast<double>(n * n);
+
+        if (bytes <= (4u << 20))
+        {
+            run.run("multiply", type, n, bytes, items * static_cast<double>(n), [&]
+            {
+                matrix<T> p = a * b;
+                keep(*p.data());
+            });
+        }
+
+        run.run("expr_add", type, n, bytes, items, [&]
+        {
+            c = a + b;
+            keep(*c.data());
+        });
+
+        run.run("transform_seq", type, n, bytes, items, [&]
+        {
+            transform(matrix_execution::seq, a, c, [](const T& x) { return x + x; });
+            keep(*c.data());
+        });
+
+        run.run("transform_par", type, n, bytes, items, [&]
+        {
+            transform(matrix_execution::par, a, c, [](const T& x) { return x + x; });
+            keep(*c.data());
+        });
+
+        run.run("sum_seq", type, n, bytes, items, [&]
+        {
+            keep(sum(matrix_execution::seq, a));
+        });
+
+        run.run("sum_par", type, n, bytes, items, [&]
+        {
+            keep(sum(matrix_execution::par, a));
+        });
+
+        run.run("col_sums", type, n, bytes, items, [&]
+        {
+            keep(col_sums(a).front());
+        });
+
+        // 16 writes spread over the matrix, then the sums are read.
+        tracked_matrix<T> tracked(a);
+        tracked.track(aggregate::sum);
+        std::size_t write = 0;
+
+        run.run("tracked_sums", type, n, bytes, items, [&]
+        {
+            for (std::size_t k = 0; k < 16; ++k, ++write)
+                tracked.set(write * 7919 % n, write * 104729 % n, a[k % n][k % n]);
+            keep(tracked.row_sums().front() + tracked.col_sums().front());
+        });
+
+        run.run("transpose", type, n, bytes, items, [&]
+        {
+            matrix<T> t = a.transpose();
+            keep(*t.data());
+        });
+
+        run.run("transpose_inplace", type, n, bytes, items, [&]
+        {
+            c.transpose_inplace();
+            keep(*c.data());
+        });
+
+        // As many 4 * 4 matrices as fit into the storage of one n * n matrix.
+        std::size_t count = n * n / 16;
+        matrix_batch<T> ba(count, 4, 4, [](std::size_t k, std::size_t i, std::size_t j) { return element<T>(k + i, j); });
+        matrix_batch<T> bb = ba.transpose();
+        std::vector<matrix<T> > sa;
+        std::vector<matrix<T> > sb;
+        for (std::size_t k = 0; k < count; ++k)
+        {
+            sa.push_back(ba.get(k));
+            sb.push_back(bb.get(k));
+        }
+
+        run.run("batch_multiply", type, n, bytes, static_cast<double>(count * 64), [&]
+        {
+            matrix_batch<T> p = multiply(matrix_execution::seq, ba, bb);
+            keep(*p.data());
+        });
+
+        run.run("small_multiply", type, n, bytes, static_cast<double>(count * 64), [&]
+        {
+            for (std::size_t k = 0; k < count; ++k)
+            {
+                matrix<T> p = sa[k] * sb[k];
+                keep(*p.data());
+            }
+        });
+
+        sparse_matrix<T> s(matrix<T>(n, n, [](std::size_t i, std::size_t j) { return sparse_element<T>(i, j); }));
+        std::vector<T> x(n, element<T>(1, 2));
+        std::vector<T> y(n);
+
+        run.run("spmv", type, n, bytes, static_cast<double>(s.nonzeros()), [&]
+        {
+            spmv(matrix_execution::seq, s, x, y);
+            keep(y.front());
+        });
+    }
+
+    template <typename T>
+    void bench_type(runner& run, const options& opts, const char* type)
+    {
+        // Storage sizes: L1, L2, last level cache slice, beyond the LLC.
+        const std::size_t targets[] = { 16u << 10, 256u << 10, 4u << 20, 64u << 20 };
+
+        for (std::size_t target : targets)
+        {
+            if (target > opts.max_bytes)
+                break;
+
+            std::size_t n = static_cast<std::size_t>(std::sqrt(static_cast<double>(target / sizeof(T))));
+            std::size_t bytes = n * n * sizeof(T);
+
+            bench_traversal<T>(run, type, n, bytes);
+            bench_construction<T>(run, type, n, bytes);
+            bench_kernels<T>(run, type, n, bytes);
+        }
+    }
+
+    bool parse(int argc, char** argv, options& opts)
+    {
+        for (int k = 1; k < argc; ++k)
+        {
+            std::string arg = argv[k];
+            const char* value = k + 1 < argc ? argv[k + 1] : nullptr;
+
+            if (arg == "--json" && value)
+                opts.json = value;
+            else if (arg == "--filter" && value)
+                opts.filter = value;
+            else if (arg == "--min-time" && value)
+                opts.min_time = std::strtod(value, nullptr);
+            else if (arg == "--max-bytes" && value)
+                opts.max_bytes = std::strtoull(value, nullptr, 10);
+            else
+                return false;
+
+            ++k;
+        }
+
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    options opts;
+
+    if (!parse(argc, argv, opts))
+    {
+        std::fprintf(stderr, "usage: %s [--json FILE] [--filter TEXT] [--min-time SECONDS] "
+                             "[--max-bytes N]\n", argv[0]);
+        return 2;
+    }
+
+    runner run(opts);
+
+    bench_type<int>(run, opts, "int");
+    bench_type<double>(run, opts, "double");
+    bench_type<Complex>(run, opts, "Complex");
+
+    if (!opts.json.empty() && !run.write_json(opts.json))
+    {
+        std::fprintf(stderr, "cannot write %s\n", opts.json.c_str());
+        return 1;
+    }
+
+    return 0;
+}
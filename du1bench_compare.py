@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""Compares two du1bench --json result files.
+
+    du1bench_compare.py BASELINE CURRENT [--threshold 0.10] [--min-ns 1000]
+
+Benchmarks are matched by name. A benchmark whose time per iteration grew by
+more than the threshold (10 % by default) is flagged as a regression, one
+that shrank by more than the threshold as an improvement. Benchmarks faster
+than --min-ns in the baseline are reported but never flagged, their timings
+are dominated by noise. The exit status is 1 if there is any regression, so
+the script can gate a build; store a baseline by keeping the JSON of a run
+on the reference revision (e.g. the bench target of the CMake project).
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    return {b["name"]: b for b in data["benchmarks"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Flag du1bench regressions against a baseline.")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="relative slowdown flagged as a regression (default 0.10)")
+    parser.add_argument("--min-ns", type=float, default=1000.0,
+                        help="baseline times below this are never flagged (default 1000)")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+
+    regressions = 0
+    improvements = 0
+
+    print("%-36s %14s %14s %8s" % ("benchmark", "baseline ns", "current ns", "change"))
+
+    for name, cur in current.items():
+        base = baseline.get(name)
+        if base is None:
+            print("%-36s %14s %14.1f %8s" % (name, "-", cur["real_time"], "new"))
+            continue
+
+        before = base["real_time"]
+        after = cur["real_time"]
+        change = (after - before) / before if before > 0 else 0.0
+
+        mark = ""
+        if before >= args.min_ns:
+            if change > args.threshold:
+                mark = "  REGRESSION"
+                regressions += 1
+            elif change < -args.threshold:
+                mark = "  improved"
+                improvements += 1
+
+        print("%-36s %14.1f %14.1f %+7.1f%%%s" % (name, before, after, change * 100, mark))
+
+    for name in baseline:
+        if name not in current:
+            print("%-36s %14.1f %14s %8s" % (name, baseline[name]["real_time"], "-", "missing"))
+
+    print("\n%d regression(s), %d improvement(s), threshold %.0f%%"
+          % (regressions, improvements, args.threshold * 100))
+
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,466 @@
+#ifndef DU1_COW_HPP
+#define DU1_COW_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include "du1debug.hpp"
+#include "du1matrix.hpp"
+
+//   cow_matrix class template
+//   =========================
+//
+//   Overview
+//   --------
+//
+//   A row_major matrix whose copies share their storage until one of them is
+// modified. The rows are stored in bands of band_height() consecutive rows
+// (by default as many as fit into 64 KiB, at least one), each band being
+// a separately reference counted buffer. Copying a cow_matrix copies
+// a pointer per band; writing into a band that is shared first clones that
+// band only, so changing a row of a huge matrix copies a few KiB instead of
+// the whole matrix. A band height of 1 makes the copying row-granular.
+//
+//   Read access goes through the const members: rows(), operator[] const,
+// band(b). Members that hand out mutable access (operator[], mutable_band(b))
+// unshare the band they refer to, even if nothing is written in the end, so
+// read through a const reference (std::as_const) when the matrix may be
+// shared.
+//
+//   A row or band handed out that way may still be written through after the
+// matrix has been copied, so the band is marked unshareable: copies of the
+// matrix (copy construction and assignment) get their own copy of it instead
+// of sharing it, like the reference counted std::string of old.
+//
+//   auto r = a[1];     // band of row 1 unshared and marked
+//   cow_matrix b = a;  // b copies that band
+//   r[2] = 42;         // b[1][2] is unchanged
+//
+// The mark stays with the band for the lifetime of the matrix (or until it
+// is assigned to), since the matrix cannot tell when the proxies are gone.
+//
+//   Rows are crow_t / row_t proxies of matrix<T>, a band is a matrix_view of
+// band_rows(b) * width() elements; algorithms that work on views can run band
+// by band. Since a column crosses bands, there is no cols().
+//
+//   The reference counts are atomic, so copies may be used (and unshared) by
+// different threads: a band is only written in place once its count has
+// dropped to 1, and an acquire fence after reading the count orders the
+// writes after whatever the other owners did before releasing it. A single
+// cow_matrix object must not be modified concurrently, just like a matrix.
+//
+template <typename T, typename Alloc = std::allocator<T> >
+class cow_matrix
+{
+    typedef cow_matrix<T, Alloc> self;
+
+    typedef std::vector<T, Alloc> band_type;
+
+public:
+    typedef Alloc          allocator_type;
+    typedef T              value_type;
+    typedef T&             reference;
+    typedef T*             pointer;
+    typedef const T&       const_reference;
+    typedef const T*       const_pointer;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::size_t    size_type;
+
+    typedef typename matrix<T>::row_t  row_t;
+    typedef typename matrix<T>::crow_t crow_t;
+
+    static constexpr size_type default_band_bytes = 64 * 1024;
+
+    // Constructors. A band height of 0 selects the default.
+    cow_matrix()
+        : bands_()
+        , unshareable_()
+        , rows_()
+        , cols_()
+        , band_height_(1)
+    { }
+
+    cow_matrix(size_type rows, size_type cols, const value_type& def,
+               size_type band_height = 0, const allocator_type& alloc = allocator_type())
+        : bands_()
+        , unshareable_()
+        , rows_(rows)
+        , cols_(cols)
+        , band_height_(band_height > 0 ? band_height : default_band_height(cols))
+    {
+        for (size_type b = 0; b < band_count(); ++b)
+            bands_.push_back(std::make_shared<band_type>(band_rows(b) * cols_, def, alloc));
+
+        unshareable_.resize(band_count());
+    }
+
+    template <typename Layout, typename MatrixAlloc, typename Check>
+    explicit cow_matrix(const matrix<T, Layout, MatrixAlloc, Check>& m, size_type band_height = 0,
+                        const allocator_type& alloc = allocator_type())
+        : bands_()
+        , unshareable_()
+        , rows_(m.rows().size())
+        , cols_(m.cols().size())
+        , band_height_(band_height > 0 ? band_height : default_band_height(cols_))
+    {
+        for (size_type b = 0; b < band_count(); ++b)
+        {
+            std::shared_ptr<band_type> band = std::make_shared<band_type>(alloc);
+            band->reserve(band_rows(b) * cols_);
+
+            for (size_type i = b * band_height_, end = i + band_rows(b); i < end; ++i)
+                band->insert(band->end(), m[i].begin(), m[i].end());
+
+            bands_.push_back(std::move(band));
+        }
+
+        unshareable_.resize(band_count());
+    }
+
+    // Copies share every band but the unshareable ones, see 'Overview'.
+    cow_matrix(const self& other)
+        : bands_(other.bands_)
+        , unshareable_(other.band_count())
+        , rows_(other.rows_)
+        , cols_(other.cols_)
+        , band_height_(other.band_height_)
+    {
+        for (size_type b = 0; b < band_count(); ++b)
+            if (other.unshareable_[b])
+                bands_[b] = std::make_shared<band_type>(*bands_[b]);
+    }
+
+    cow_matrix(self&&) = default;
+
+    self& operator=(const self& other)
+    {
+        if (this != &other)
+        {
+            self copy(other);
+            *this = std::move(copy);
+        }
+
+        return *this;
+    }
+
+    self& operator=(self&&) = default;
+
+    matrix<T> to_matrix() const
+    {
+        matrix<T> result(rows_, cols_, uninitialized_like());
+
+        for (size_type b = 0; b < band_count(); ++b)
+            std::copy(bands_[b]->begin(), bands_[b]->end(),
+                      result.data() + static_cast<difference_type>(b * band_height_ * cols_));
+
+        return result;
+    }
+
+    class crows_t_iterator;
+
+    // Random access container of crow_t, see the dense rows_t.
+    class crows_t
+    {
+        friend self;
+
+    public:
+        typedef crow_t           value_type;
+        typedef crows_t_iterator iterator;
+        typedef crows_t_iterator const_iterator;
+
+        iterator begin() const
+        {
+            return iterator(m_, 0);
+        }
+
+        const_iterator cbegin() const
+        {
+            return begin();
+        }
+
+        iterator end() const
+        {
+            return iterator(m_, size());
+        }
+
+        const_iterator cend() const
+        {
+            return end();
+        }
+
+        size_type size() const
+        {
+            return m_->rows_;
+        }
+
+        crow_t operator[](size_type n) const
+        {
+            return (*m_)[n];
+        }
+
+    private:
+        explicit crows_t(const self* m)
+            : m_(m)
+        { }
+
+        const self* m_;
+    };
+
+    class crows_t_iterator
+    {
+        friend class crows_t;
+
+    public:
+        typedef crow_t                          value_type;
+        typedef const crow_t&                   reference;
+        typedef const crow_t*                   pointer;
+        typedef std::ptrdiff_t                  difference_type;
+        typedef std::random_access_iterator_tag iterator_category;
+
+        crows_t_iterator()
+            : m_(nullptr)
+            , index_()
+            , row_()
+        { }
+
+        bool operator==(const crows_t_iterator& other) const
+        {
+            return m_ == other.m_ && index_ == other.index_;
+        }
+
+        bool operator!=(const crows_t_iterator& other) const
+        {
+            return !(*this == other);
+        }
+
+        bool operator<(const crows_t_iterator& other) const
+        {
+            return index_ < other.index_;
+        }
+
+        bool operator>(const crows_t_iterator& other) const
+        {
+            return other < *this;
+        }
+
+        bool operator<=(const crows_t_iterator& other) const
+        {
+            return !(other < *this);
+        }
+
+        bool operator>=(const crows_t_iterator& other) const
+        {
+            return !(*this < other);
+        }
+
+        // The row is only materialized on dereference.
+        reference operator*() const
+        {
+            row_.emplace((*m_)[static_cast<size_type>(index_)]);
+            return *row_;
+        }
+
+        pointer operator->() const
+        {
+            return &**this;
+        }
+
+        value_type operator[](difference_type n) const
+        {
+            return *(*this + n);
+        }
+
+        crows_t_iterator& operator++()
+        {
+            return *this += 1;
+        }
+
+        crows_t_iterator operator++(int)
+        {
+            crows_t_iterator copy(*this);
+            ++*this;
+            return copy;
+        }
+
+        crows_t_iterator& operator--()
+        {
+            return *this -= 1;
+        }
+
+        crows_t_iterator operator--(int)
+        {
+            crows_t_iterator copy(*this);
+            --*this;
+            return copy;
+        }
+
+        crows_t_iterator& operator+=(difference_type n)
+        {
+            du_assert(m_ && index_ + n >= 0 && static_cast<size_type>(index_ + n) <= m_->rows_);
+
+            index_ += n;
+            return *this;
+        }
+
+        crows_t_iterator& operator-=(difference_type n)
+        {
+            return *this += -n;
+        }
+
+        crows_t_iterator operator+(difference_type n) const
+        {
+            crows_t_iterator copy(*this);
+            return copy += n;
+        }
+
+        friend crows_t_iterator operator+(difference_type n, const crows_t_iterator& it)
+        {
+            return it + n;
+        }
+
+        crows_t_iterator operator-(difference_type n) const
+        {
+            crows_t_iterator copy(*this);
+            return copy -= n;
+        }
+
+        difference_type operator-(const crows_t_iterator& other) const
+        {
+            return index_ - other.index_;
+        }
+
+    private:
+        crows_t_iterator(const self* m, size_type index)
+            : m_(m)
+            , index_(static_cast<difference_type>(index))
+            , row_()
+        { }
+
+        const self*     m_;
+        difference_type index_;
+
+        // See the dense matrix 'Implementation details'. Rows have no public
+        // default constructor, hence the optional.
+        mutable std::optional<crow_t> row_;
+    };
+
+    // Row views.
+    crows_t rows() const
+    {
+        return crows_t(this);
+    }
+
+    crows_t crows() const
+    {
+        return rows();
+    }
+
+    size_type height() const
+    {
+        return rows_;
+    }
+
+    size_type width() const
+    {
+        return cols_;
+    }
+
+    // Element access via proxy container. The non-const version unshares the
+    // band of row n and marks it unshareable.
+    row_t operator[](size_type n)
+    {
+        du_assert(n < rows_);
+
+        return mutable_band(n / band_height_)[n % band_height_];
+    }
+
+    crow_t operator[](size_type n) const
+    {
+        du_assert(n < rows_);
+
+        return band(n / band_height_)[n % band_height_];
+    }
+
+    // Bands.
+    size_type band_height() const
+    {
+        return band_height_;
+    }
+
+    size_type band_count() const
+    {
+        return (rows_ + band_height_ - 1) / band_height_;
+    }
+
+    // Number of rows in band b (the last band may be shorter).
+    size_type band_rows(size_type b) const
+    {
+        return std::min(band_height_, rows_ - b * band_height_);
+    }
+
+    matrix_view<const T> band(size_type b) const
+    {
+        du_assert(b < band_count());
+
+        return band_view<const T>(bands_[b]->data(), b);
+    }
+
+    // Unshares band b and marks it unshareable, see 'Overview'.
+    matrix_view<T> mutable_band(size_type b)
+    {
+        du_assert(b < band_count());
+
+        if (bands_[b].use_count() > 1)
+            bands_[b] = std::make_shared<band_type>(*bands_[b]);
+        else
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+        unshareable_[b] = true;
+        return band_view<T>(bands_[b]->data(), b);
+    }
+
+    // Whether band b is shared with another cow_matrix.
+    bool shared(size_type b) const
+    {
+        du_assert(b < band_count());
+
+        return bands_[b].use_count() > 1;
+    }
+
+private:
+    static size_type default_band_height(size_type cols)
+    {
+        size_type row_bytes = cols * sizeof(T);
+
+        return row_bytes > 0 && row_bytes < default_band_bytes ? default_band_bytes / row_bytes : 1;
+    }
+
+    // The copy is overwritten right away; trivial types skip initialization.
+    static auto uninitialized_like()
+    {
+        if constexpr (std::is_trivially_default_constructible<T>::value)
+            return uninitialized;
+        else
+            return T();
+    }
+
+    template <typename U>
+    matrix_view<U> band_view(U* data, size_type b) const
+    {
+        return matrix_view<U>(data, band_rows(b), cols_, static_cast<difference_type>(cols_), 1);
+    }
+
+    std::vector<std::shared_ptr<band_type> > bands_;
+    std::vector<bool>                        unshareable_;
+    size_type                                rows_;
+    size_type                                cols_;
+    size_type                                band_height_;
+};
+
+#endif // DU1_COW_HPP
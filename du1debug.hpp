@@ -32,4 +32,9 @@ inline void du_abort( const char * s, const char * f, int l)
     throw du_abort_exception(); 
 }
 
+// du_check(enabled, e) checks e only if the compile-time constant enabled
+// is true, independently of DU_NDEBUG (see the matrix check policies)
+
+#define du_check(enabled, e) ((void)(!(enabled)||(!!(e))||(du_abort((#e),__FILE__,__LINE__),0)))
+
 #endif
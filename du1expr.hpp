@@ -0,0 +1,650 @@
+#ifndef DU1_EXPR_HPP
+#define DU1_EXPR_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "du1debug.hpp"
+#include "du1matrix.hpp"
+
+//   Element-wise expressions
+//   ========================
+//
+//   Overview
+//   --------
+//
+//   Arithmetic on matrices, tiles, rows and columns (and their const
+// variants) builds lazy expression objects instead of temporary matrices.
+// Nothing is computed until the expression is assigned:
+//
+//   matrix<double> r = a * 2.0 + b - c;     // one pass, no temporaries
+//   r = sqrt(abs(r)) / (a + 1.0);
+//   assign(r[0], a[1] - b[2]);              // into a row, column or tile
+//
+//   Supported are binary + - / between two operands or an operand and an
+// arithmetic scalar, * with a scalar (the product of two matrices is the
+// matrix product of du1multiply.hpp; the element-wise product is spelled
+// hadamard(a, b)), unary -, the element-wise math functions abs, sqrt, exp,
+// log, sin, cos and pow, the comparisons < > <= >= == != (which give
+// expressions of bool, usable with select(cond, a, b)) and
+// zip_transform(f, e1, e2, ...) which applies an arbitrary functor to the
+// corresponding elements of any number of operands.
+//
+//   Rows and columns take part as 1 * n operands, so a row can be combined
+// with a column of the same length. All other operands must have the same
+// shape, which is checked when the expression is built (and when it is
+// assigned) if the check policy of any operand checks indices, see 'Bounds
+// checking' in du1matrix.hpp.
+//
+//   Expressions hold references to their operands; they are meant to be
+// assigned right away, not stored. The destination may be one of the
+// operands: it is written in place when it only overlaps operands element for
+// element (m = m * 2.0 + b), and through a temporary otherwise
+// (m = m.transposed() + 0, or a block assigned from an overlapping shifted
+// block).
+//
+//   Implementation details
+//   ----------------------
+//
+//   Every operand is turned into a leaf: a pointer, the shape and the row and
+// column steps (or a scalar). Inner nodes store their children by value and
+// compute a single element on request (at()). Evaluation walks the
+// destination in its storage order; when the destination and every leaf have
+// unit col steps (or all have unit row steps), the leaves are read with
+// a literal unit step, which makes the innermost loop a plain contiguous loop
+// that the compiler vectorizes.
+//
+namespace du1_detail
+{
+    // Access modes used when evaluating expressions; see 'Implementation
+    // details'.
+    enum expr_access
+    {
+        any_step,
+        unit_col_step,
+        unit_row_step
+    };
+
+    // Addresses [lo, hi) spanned by a non-empty rows * cols block.
+    struct byte_range
+    {
+        std::uintptr_t lo;
+        std::uintptr_t hi;
+    };
+
+    template <typename T>
+    byte_range block_range(const T* first, std::size_t rows, std::size_t cols,
+                           std::ptrdiff_t rs, std::ptrdiff_t cs)
+    {
+        std::ptrdiff_t a = static_cast<std::ptrdiff_t>(rows - 1) * rs;
+        std::ptrdiff_t b = static_cast<std::ptrdiff_t>(cols - 1) * cs;
+        std::ptrdiff_t low = std::min<std::ptrdiff_t>(a, 0) + std::min<std::ptrdiff_t>(b, 0);
+        std::ptrdiff_t high = std::max<std::ptrdiff_t>(a, 0) + std::max<std::ptrdiff_t>(b, 0);
+        std::uintptr_t base = reinterpret_cast<std::uintptr_t>(first);
+
+        return { base + static_cast<std::uintptr_t>(low * static_cast<std::ptrdiff_t>(sizeof(T))),
+                 base + static_cast<std::uintptr_t>((high + 1) * static_cast<std::ptrdiff_t>(sizeof(T))) };
+    }
+}
+
+// Common base of all expression nodes (CRTP).
+template <typename Derived>
+class expression
+{
+public:
+    typedef void expression_tag;
+
+    const Derived& derived() const
+    {
+        return static_cast<const Derived&>(*this);
+    }
+
+    // Writes the expression to a rows * cols destination whose element
+    // (i, j) is at dst[i * rs + j * cs].
+    template <typename U>
+    void evaluate(U* dst, std::ptrdiff_t rs, std::ptrdiff_t cs) const
+    {
+        const Derived& e = derived();
+        std::size_t rows = e.nrows();
+        std::size_t cols = e.ncols();
+
+        if (cs == 1 && e.unit_col())
+        {
+            for (std::size_t i = 0; i < rows; ++i)
+            {
+                U* d = dst + static_cast<std::ptrdiff_t>(i) * rs;
+                for (std::size_t j = 0; j < cols; ++j)
+                    d[j] = static_cast<U>(e.template at<du1_detail::unit_col_step>(i, j));
+            }
+        }
+        else if (rs == 1 && e.unit_row())
+        {
+            for (std::size_t j = 0; j < cols; ++j)
+            {
+                U* d = dst + static_cast<std::ptrdiff_t>(j) * cs;
+                for (std::size_t i = 0; i < rows; ++i)
+                    d[i] = static_cast<U>(e.template at<du1_detail::unit_row_step>(i, j));
+            }
+        }
+        else
+        {
+            for (std::size_t i = 0; i < rows; ++i)
+                for (std::size_t j = 0; j < cols; ++j)
+                    dst[static_cast<std::ptrdiff_t>(i) * rs + static_cast<std::ptrdiff_t>(j) * cs] =
+                        static_cast<U>(e.template at<du1_detail::any_step>(i, j));
+        }
+    }
+};
+
+// Leaf referring to elements stored in a matrix, tile or line.
+template <typename T>
+class block_leaf : public expression<block_leaf<T> >
+{
+public:
+    typedef typename std::remove_const<T>::type value_type;
+
+    static constexpr bool is_scalar = false;
+
+    block_leaf(const T* first, std::size_t rows, std::size_t cols,
+               std::ptrdiff_t rs, std::ptrdiff_t cs, bool checked)
+        : first_(first)
+        , rows_(rows)
+        , cols_(cols)
+        , rs_(rs)
+        , cs_(cs)
+        , checked_(checked)
+    { }
+
+    std::size_t nrows() const { return rows_; }
+    std::size_t ncols() const { return cols_; }
+
+    // Whether the operand's check policy checks shapes.
+    bool checked() const { return checked_; }
+
+    bool unit_col() const { return cs_ == 1 || cols_ <= 1; }
+    bool unit_row() const { return rs_ == 1 || rows_ <= 1; }
+
+    // Whether writing the expression to the destination (see evaluate())
+    // may overwrite elements of this leaf before they are read: the leaf
+    // overlaps the destination, but not element for element.
+    template <typename U>
+    bool aliases(const U* dst, std::ptrdiff_t rs, std::ptrdiff_t cs) const
+    {
+        if (rows_ == 0 || cols_ == 0)
+            return false;
+
+        du1_detail::byte_range mine = du1_detail::block_range(first_, rows_, cols_, rs_, cs_);
+        du1_detail::byte_range theirs = du1_detail::block_range(dst, rows_, cols_, rs, cs);
+        if (mine.hi <= theirs.lo || theirs.hi <= mine.lo)
+            return false;
+
+        bool same = static_cast<const void*>(first_) == static_cast<const void*>(dst)
+                 && sizeof(T) == sizeof(U)
+                 && (rows_ <= 1 || rs_ == rs)
+                 && (cols_ <= 1 || cs_ == cs);
+        return !same;
+    }
+
+    template <du1_detail::expr_access Access>
+    const T& at(std::size_t i, std::size_t j) const
+    {
+        std::ptrdiff_t si = static_cast<std::ptrdiff_t>(i);
+        std::ptrdiff_t sj = static_cast<std::ptrdiff_t>(j);
+
+        if (Access == du1_detail::unit_col_step)
+            return first_[(rows_ <= 1 ? 0 : si * rs_) + sj];
+        else if (Access == du1_detail::unit_row_step)
+            return first_[si + (cols_ <= 1 ? 0 : sj * cs_)];
+        else
+            return first_[si * rs_ + sj * cs_];
+    }
+
+private:
+    const T*       first_;
+    std::size_t    rows_;
+    std::size_t    cols_;
+    std::ptrdiff_t rs_;
+    std::ptrdiff_t cs_;
+    bool           checked_;
+};
+
+// Leaf broadcasting a single value.
+template <typename S>
+class scalar_leaf : public expression<scalar_leaf<S> >
+{
+public:
+    typedef S value_type;
+
+    static constexpr bool is_scalar = true;
+
+    explicit scalar_leaf(const S& value)
+        : value_(value)
+    { }
+
+    std::size_t nrows() const { return 0; }
+    std::size_t ncols() const { return 0; }
+
+    bool checked() const { return false; }
+
+    bool unit_col() const { return true; }
+    bool unit_row() const { return true; }
+
+    template <typename U>
+    bool aliases(const U*, std::ptrdiff_t, std::ptrdiff_t) const
+    {
+        return false;
+    }
+
+    template <du1_detail::expr_access>
+    const S& at(std::size_t, std::size_t) const
+    {
+        return value_;
+    }
+
+private:
+    S value_;
+};
+
+namespace du1_detail
+{
+    template <typename...>
+    struct expr_void
+    {
+        typedef void type;
+    };
+
+    template <typename E>
+    struct is_matrix : std::false_type { };
+
+    template <typename T, typename L, typename A, typename C>
+    struct is_matrix<matrix<T, L, A, C> > : std::true_type { };
+
+    template <typename E, typename = void>
+    struct is_line : std::false_type { };
+
+    template <typename E>
+    struct is_line<E, typename expr_void<decltype(std::declval<const E&>().as_span())>::type>
+        : std::true_type { };
+
+    template <typename E, typename = void>
+    struct is_tile : std::false_type { };
+
+    template <typename E>
+    struct is_tile<E, typename expr_void<decltype(std::declval<const E&>().row_step()),
+                                         decltype(std::declval<const E&>().height())>::type>
+        : std::true_type { };
+
+    template <typename E, typename = void>
+    struct is_expression : std::false_type { };
+
+    template <typename E>
+    struct is_expression<E, typename expr_void<typename E::expression_tag>::type>
+        : std::true_type { };
+
+    // Turns an operand into its expression node.
+    template <typename E, typename = void>
+    struct leaf
+    {
+        static constexpr bool operand = false;
+    };
+
+    template <typename E>
+    struct leaf<E, typename std::enable_if<is_expression<E>::value>::type>
+    {
+        static constexpr bool operand = true;
+
+        typedef E type;
+
+        static const E& make(const E& e)
+        {
+            return e;
+        }
+    };
+
+    template <typename E>
+    struct leaf<E, typename std::enable_if<is_matrix<E>::value>::type>
+    {
+        static constexpr bool operand = true;
+
+        typedef block_leaf<typename E::value_type> type;
+
+        static type make(const E& m)
+        {
+            return type(m.data(), m.rows().size(), m.cols().size(), m.row_step(), m.col_step(),
+                        checks_indices<E>::value);
+        }
+    };
+
+    template <typename E>
+    struct leaf<E, typename std::enable_if<is_line<E>::value>::type>
+    {
+        static constexpr bool operand = true;
+
+        typedef block_leaf<typename std::remove_const<typename E::value_type>::type> type;
+
+        static type make(const E& l)
+        {
+            return type(l.data(), 1, l.size(), 0, l.stride(), checks_indices<E>::value);
+        }
+    };
+
+    template <typename E>
+    struct leaf<E, typename std::enable_if<is_tile<E>::value>::type>
+    {
+        static constexpr bool operand = true;
+
+        typedef block_leaf<typename std::remove_const<
+            typename std::remove_pointer<decltype(std::declval<const E&>().data())>::type>::type> type;
+
+        static type make(const E& t)
+        {
+            return type(t.data(), t.height(), t.width(), t.row_step(), t.col_step(), checks_indices<E>::value);
+        }
+    };
+
+    template <typename E>
+    struct leaf<E, typename std::enable_if<std::is_arithmetic<E>::value>::type>
+    {
+        static constexpr bool operand = false;
+
+        typedef scalar_leaf<E> type;
+
+        static type make(const E& s)
+        {
+            return type(s);
+        }
+    };
+
+    template <typename E>
+    using leaf_t = typename leaf<typename std::decay<E>::type>::type;
+
+    template <typename E>
+    leaf_t<E> make_leaf(const E& e)
+    {
+        return leaf<typename std::decay<E>::type>::make(e);
+    }
+
+    template <typename E>
+    struct is_operand : std::integral_constant<bool, leaf<typename std::decay<E>::type>::operand> { };
+
+    template <typename E>
+    struct is_scalar : std::is_arithmetic<typename std::decay<E>::type> { };
+
+    // An operator applies when at least one side is an operand and the
+    // other one is an operand or a scalar.
+    template <typename L, typename R>
+    struct is_operand_pair
+        : std::integral_constant<bool, (is_operand<L>::value && (is_operand<R>::value || is_scalar<R>::value))
+                                    || (is_scalar<L>::value && is_operand<R>::value)>
+    { };
+
+    template <typename L, typename R>
+    struct is_scalar_pair
+        : std::integral_constant<bool, (is_operand<L>::value && is_scalar<R>::value)
+                                    || (is_scalar<L>::value && is_operand<R>::value)>
+    { };
+
+    // Element-wise math functions.
+#define DU1_EXPR_MATH_FUNCTOR(name)                                    \
+    struct name##_fn                                                   \
+    {                                                                  \
+        template <typename A>                                          \
+        auto operator()(const A& a) const -> decltype(std::name(a))    \
+        {                                                              \
+            return std::name(a);                                       \
+        }                                                              \
+    };
+
+    DU1_EXPR_MATH_FUNCTOR(abs)
+    DU1_EXPR_MATH_FUNCTOR(sqrt)
+    DU1_EXPR_MATH_FUNCTOR(exp)
+    DU1_EXPR_MATH_FUNCTOR(log)
+    DU1_EXPR_MATH_FUNCTOR(sin)
+    DU1_EXPR_MATH_FUNCTOR(cos)
+
+#undef DU1_EXPR_MATH_FUNCTOR
+
+    struct pow_fn
+    {
+        template <typename A, typename B>
+        auto operator()(const A& a, const B& b) const -> decltype(std::pow(a, b))
+        {
+            return std::pow(a, b);
+        }
+    };
+
+    struct select_fn
+    {
+        template <typename C, typename A, typename B>
+        typename std::common_type<A, B>::type operator()(const C& c, const A& a, const B& b) const
+        {
+            return c ? a : b;
+        }
+    };
+}
+
+// Node applying a functor to the corresponding elements of its children.
+// Unary and binary operators are the one and two child cases.
+template <typename F, typename... E>
+class map_expr : public expression<map_expr<F, E...> >
+{
+public:
+    typedef typename std::decay<
+        decltype(std::declval<const F&>()(std::declval<const typename E::value_type&>()...))>::type value_type;
+
+    static constexpr bool is_scalar = false;
+
+    explicit map_expr(const F& f, const E&... children)
+        : f_(f)
+        , children_(children...)
+        , rows_()
+        , cols_()
+        , checked_((children.checked() || ...))
+    {
+        bool shaped = false;
+        check_shapes(shaped, children...);
+    }
+
+    std::size_t nrows() const { return rows_; }
+    std::size_t ncols() const { return cols_; }
+
+    bool checked() const { return checked_; }
+
+    bool unit_col() const
+    {
+        return all(std::index_sequence_for<E...>(), [](const auto& c) { return c.unit_col(); });
+    }
+
+    bool unit_row() const
+    {
+        return all(std::index_sequence_for<E...>(), [](const auto& c) { return c.unit_row(); });
+    }
+
+    template <typename U>
+    bool aliases(const U* dst, std::ptrdiff_t rs, std::ptrdiff_t cs) const
+    {
+        return !all(std::index_sequence_for<E...>(), [&](const auto& c) { return !c.aliases(dst, rs, cs); });
+    }
+
+    template <du1_detail::expr_access Access>
+    value_type at(std::size_t i, std::size_t j) const
+    {
+        return apply<Access>(std::index_sequence_for<E...>(), i, j);
+    }
+
+private:
+    template <typename First, typename... Rest>
+    void check_shapes(bool& shaped, const First& first, const Rest&... rest)
+    {
+        if (!First::is_scalar)
+        {
+            if (shaped)
+            {
+                du_check(checked_, first.nrows() == rows_ && first.ncols() == cols_);
+            }
+            else
+            {
+                shaped = true;
+                rows_ = first.nrows();
+                cols_ = first.ncols();
+            }
+        }
+
+        check_shapes(shaped, rest...);
+    }
+
+    void check_shapes(bool&)
+    { }
+
+    template <std::size_t... I, typename P>
+    bool all(std::index_sequence<I...>, P p) const
+    {
+        return (p(std::get<I>(children_)) && ...);
+    }
+
+    template <du1_detail::expr_access Access, std::size_t... I>
+    value_type apply(std::index_sequence<I...>, std::size_t i, std::size_t j) const
+    {
+        return f_(std::get<I>(children_).template at<Access>(i, j)...);
+    }
+
+    F                f_;
+    std::tuple<E...> children_;
+    std::size_t      rows_;
+    std::size_t      cols_;
+    bool             checked_;
+};
+
+template <typename F, typename... E>
+map_expr<F, du1_detail::leaf_t<E>...> zip_transform(const F& f, const E&... operands)
+{
+    return map_expr<F, du1_detail::leaf_t<E>...>(f, du1_detail::make_leaf(operands)...);
+}
+
+#define DU1_EXPR_BINARY_OPERATOR(op, fn, pair)                                      \
+    template <typename L, typename R,                                               \
+              typename = typename std::enable_if<du1_detail::pair<L, R>::value>::type> \
+    map_expr<fn, du1_detail::leaf_t<L>, du1_detail::leaf_t<R> >                     \
+    operator op(const L& l, const R& r)                                             \
+    {                                                                               \
+        return zip_transform(fn(), l, r);                                           \
+    }
+
+DU1_EXPR_BINARY_OPERATOR(+,  std::plus<>,          is_operand_pair)
+DU1_EXPR_BINARY_OPERATOR(-,  std::minus<>,         is_operand_pair)
+DU1_EXPR_BINARY_OPERATOR(*,  std::multiplies<>,    is_scalar_pair)
+DU1_EXPR_BINARY_OPERATOR(/,  std::divides<>,       is_operand_pair)
+DU1_EXPR_BINARY_OPERATOR(<,  std::less<>,          is_operand_pair)
+DU1_EXPR_BINARY_OPERATOR(>,  std::greater<>,       is_operand_pair)
+DU1_EXPR_BINARY_OPERATOR(<=, std::less_equal<>,    is_operand_pair)
+DU1_EXPR_BINARY_OPERATOR(>=, std::greater_equal<>, is_operand_pair)
+DU1_EXPR_BINARY_OPERATOR(==, std::equal_to<>,      is_operand_pair)
+DU1_EXPR_BINARY_OPERATOR(!=, std::not_equal_to<>,  is_operand_pair)
+
+#undef DU1_EXPR_BINARY_OPERATOR
+
+template <typename E, typename = typename std::enable_if<du1_detail::is_operand<E>::value>::type>
+map_expr<std::negate<>, du1_detail::leaf_t<E> > operator-(const E& e)
+{
+    return zip_transform(std::negate<>(), e);
+}
+
+template <typename L, typename R,
+          typename = typename std::enable_if<du1_detail::is_operand_pair<L, R>::value>::type>
+map_expr<std::multiplies<>, du1_detail::leaf_t<L>, du1_detail::leaf_t<R> > hadamard(const L& l, const R& r)
+{
+    return zip_transform(std::multiplies<>(), l, r);
+}
+
+#define DU1_EXPR_UNARY_FUNCTION(name)                                                     \
+    template <typename E, typename = typename std::enable_if<du1_detail::is_operand<E>::value>::type> \
+    map_expr<du1_detail::name##_fn, du1_detail::leaf_t<E> > name(const E& e)              \
+    {                                                                                     \
+        return zip_transform(du1_detail::name##_fn(), e);                                 \
+    }
+
+DU1_EXPR_UNARY_FUNCTION(abs)
+DU1_EXPR_UNARY_FUNCTION(sqrt)
+DU1_EXPR_UNARY_FUNCTION(exp)
+DU1_EXPR_UNARY_FUNCTION(log)
+DU1_EXPR_UNARY_FUNCTION(sin)
+DU1_EXPR_UNARY_FUNCTION(cos)
+
+#undef DU1_EXPR_UNARY_FUNCTION
+
+template <typename L, typename R,
+          typename = typename std::enable_if<du1_detail::is_operand_pair<L, R>::value>::type>
+map_expr<du1_detail::pow_fn, du1_detail::leaf_t<L>, du1_detail::leaf_t<R> > pow(const L& l, const R& r)
+{
+    return zip_transform(du1_detail::pow_fn(), l, r);
+}
+
+template <typename C, typename A, typename B,
+          typename = typename std::enable_if<du1_detail::is_operand<C>::value>::type>
+map_expr<du1_detail::select_fn, du1_detail::leaf_t<C>, du1_detail::leaf_t<A>, du1_detail::leaf_t<B> >
+select(const C& cond, const A& a, const B& b)
+{
+    return zip_transform(du1_detail::select_fn(), cond, a, b);
+}
+
+namespace du1_detail
+{
+    // Evaluates expr into dst, through a temporary when an operand overlaps
+    // the destination (see block_leaf::aliases()).
+    template <typename U, typename E>
+    void evaluate_into(const E& expr, U* dst, std::ptrdiff_t rs, std::ptrdiff_t cs)
+    {
+        if (!expr.aliases(dst, rs, cs))
+        {
+            expr.evaluate(dst, rs, cs);
+            return;
+        }
+
+        std::size_t rows = expr.nrows();
+        std::size_t cols = expr.ncols();
+        std::vector<U> tmp(rows * cols);
+        expr.evaluate(tmp.data(), static_cast<std::ptrdiff_t>(cols), 1);
+
+        for (std::size_t i = 0; i < rows; ++i)
+            for (std::size_t j = 0; j < cols; ++j)
+                dst[static_cast<std::ptrdiff_t>(i) * rs + static_cast<std::ptrdiff_t>(j) * cs] =
+                    std::move(tmp[i * cols + j]);
+    }
+}
+
+// Assignment of an expression into a row, column or tile. Matrices can be
+// assigned directly with operator=. The destination may appear among the
+// operands, also shifted or transposed.
+template <typename Dst, typename E,
+          typename = typename std::enable_if<du1_detail::is_line<Dst>::value
+                                          && du1_detail::is_operand<E>::value>::type>
+void assign(const Dst& dst, const E& e)
+{
+    du1_detail::leaf_t<E> expr = du1_detail::make_leaf(e);
+    du_check(du1_detail::checks_indices<Dst>::value || expr.checked(),
+             expr.nrows() == 1 && expr.ncols() == dst.size());
+
+    du1_detail::evaluate_into(expr, dst.data(), 0, dst.stride());
+}
+
+template <typename Dst, typename E,
+          typename = typename std::enable_if<du1_detail::is_tile<Dst>::value
+                                          && du1_detail::is_operand<E>::value>::type,
+          typename = void>
+void assign(const Dst& dst, const E& e)
+{
+    du1_detail::leaf_t<E> expr = du1_detail::make_leaf(e);
+    du_check(du1_detail::checks_indices<Dst>::value || expr.checked(),
+             expr.nrows() == dst.height() && expr.ncols() == dst.width());
+
+    du1_detail::evaluate_into(expr, dst.data(), dst.row_step(), dst.col_step());
+}
+
+#endif // DU1_EXPR_HPP
@@ -0,0 +1,808 @@
+#ifndef DU1_IO_HPP
+#define DU1_IO_HPP
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "du1debug.hpp"
+#include "du1matrix.hpp"
+
+//   Binary matrix files
+//   ===================
+//
+//   save_matrix(path, m) writes a matrix into a file consisting of a fixed
+// 64 byte header followed (at data_offset) by the raw storage of the matrix,
+// exactly as it is laid out in memory, padding included:
+//
+//   offset  size  field
+//   ------------------------------------------------------------------
+//        0     8  magic "DU1MATRX"
+//        8     4  format version (currently 1)
+//       12     4  byte order mark 0x01020304, as written by the host
+//       16     8  rows
+//       24     8  columns
+//       32     8  leading dimension (in elements)
+//       40     8  data_offset (in bytes, a multiple of alignment)
+//       48     4  alignment of the data (in bytes, 4096)
+//       52     4  element size (in bytes)
+//       56     1  element kind: 'i', 'u', 'f' (signed, unsigned, floating
+//                 point arithmetic type) or 'b' (any other trivially
+//                 copyable type)
+//       57     1  layout: 0 row_major, 1 column_major
+//       58     6  reserved, zero
+//
+//   matrix_mmap<T>::open(path) maps such a file into memory and offers the
+// usual rows(), cols(), operator[] and view() directly over the mapping, so
+// opening costs a few system calls no matter how large the matrix is; pages
+// are read on first access (and can be dropped again by the kernel). The data
+// starts on a page boundary, so the mapped elements are as aligned as those
+// of an aligned_allocator. The mapping is read-only by default. With
+// map_mode::copy_on_write, mutable_view() allows modifications, which stay
+// private to the process and never reach the file.
+//
+//   Files are not portable between hosts with different byte order; opening
+// such a file (as well as a file with a different element type, a newer
+// version, or one that is truncated) throws matrix_io_error. Failing system
+// calls throw std::system_error.
+//
+//   Only POSIX systems are supported.
+//
+class matrix_io_error : public std::runtime_error
+{
+public:
+    explicit matrix_io_error(const std::string& what)
+        : std::runtime_error(what)
+    { }
+};
+
+enum class map_mode
+{
+    read_only,
+    copy_on_write
+};
+
+struct matrix_file_header
+{
+    char          magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint64_t rows;
+    std::uint64_t cols;
+    std::uint64_t leading_dimension;
+    std::uint64_t data_offset;
+    std::uint32_t alignment;
+    std::uint32_t element_size;
+    char          element_kind;
+    std::uint8_t  layout;
+    std::uint8_t  reserved[6];
+};
+
+static_assert(sizeof(matrix_file_header) == 64, "unexpected header padding");
+
+namespace du1_detail
+{
+    constexpr char          matrix_file_magic[8] = { 'D', 'U', '1', 'M', 'A', 'T', 'R', 'X' };
+    constexpr std::uint32_t matrix_file_version = 1;
+    constexpr std::uint32_t matrix_file_byte_order = 0x01020304;
+    constexpr std::uint32_t matrix_file_alignment = 4096;
+
+    template <typename T>
+    constexpr char element_kind()
+    {
+        return std::is_floating_point<T>::value ? 'f'
+             : std::is_integral<T>::value && std::is_signed<T>::value ? 'i'
+             : std::is_integral<T>::value ? 'u'
+             : 'b';
+    }
+
+    template <typename Layout>
+    struct layout_code;
+
+    template <>
+    struct layout_code<row_major> : std::integral_constant<std::uint8_t, 0> { };
+
+    template <>
+    struct layout_code<column_major> : std::integral_constant<std::uint8_t, 1> { };
+
+    [[noreturn]] inline void throw_errno(const std::string& what)
+    {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+}
+
+template <typename T, typename Layout, typename Alloc, typename Check>
+void save_matrix(const std::string& path, const matrix<T, Layout, Alloc, Check>& m)
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "only trivially copyable elements can be stored");
+
+    std::size_t rows = m.rows().size();
+    std::size_t cols = m.cols().size();
+    std::size_t size = Layout::storage_size(rows, cols, m.leading_dimension());
+
+    matrix_file_header header = { };
+    std::memcpy(header.magic, du1_detail::matrix_file_magic, sizeof(header.magic));
+    header.version = du1_detail::matrix_file_version;
+    header.byte_order = du1_detail::matrix_file_byte_order;
+    header.rows = rows;
+    header.cols = cols;
+    header.leading_dimension = m.leading_dimension();
+    header.data_offset = du1_detail::matrix_file_alignment;
+    header.alignment = du1_detail::matrix_file_alignment;
+    header.element_size = sizeof(T);
+    header.element_kind = du1_detail::element_kind<T>();
+    header.layout = du1_detail::layout_code<Layout>::value;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+        throw matrix_io_error("cannot create " + path);
+
+    static const char zeros[du1_detail::matrix_file_alignment] = { };
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(zeros, static_cast<std::streamsize>(header.data_offset - sizeof(header)));
+    out.write(reinterpret_cast<const char*>(m.data()),
+              static_cast<std::streamsize>(size * sizeof(T)));
+
+    if (!out.flush())
+        throw matrix_io_error("cannot write " + path);
+}
+
+//   matrix_mmap class template
+//   ==========================
+//
+//   Owner of a mapping created by open(); see 'Binary matrix files'. It can
+// be moved but not copied, views obtained from it are valid as long as it
+// lives.
+//
+template <typename T>
+class matrix_mmap
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "only trivially copyable elements can be mapped");
+
+public:
+    typedef T              value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::size_t    size_type;
+
+    typedef typename matrix_view<const T>::ccols_t ccols_t;
+    typedef typename matrix_view<const T>::crows_t crows_t;
+    typedef typename matrix_view<const T>::crow_t  crow_t;
+
+    matrix_mmap()
+        : mapping_(nullptr)
+        , length_()
+        , mode_(map_mode::read_only)
+        , view_()
+    { }
+
+    matrix_mmap(const matrix_mmap&) = delete;
+    matrix_mmap& operator=(const matrix_mmap&) = delete;
+
+    matrix_mmap(matrix_mmap&& other) noexcept
+        : mapping_(std::exchange(other.mapping_, nullptr))
+        , length_(std::exchange(other.length_, 0))
+        , mode_(other.mode_)
+        , view_(std::exchange(other.view_, matrix_view<T>()))
+    { }
+
+    matrix_mmap& operator=(matrix_mmap&& other) noexcept
+    {
+        if (this != &other)
+        {
+            unmap();
+
+            mapping_ = std::exchange(other.mapping_, nullptr);
+            length_ = std::exchange(other.length_, 0);
+            mode_ = other.mode_;
+            view_ = std::exchange(other.view_, matrix_view<T>());
+        }
+
+        return *this;
+    }
+
+    ~matrix_mmap()
+    {
+        unmap();
+    }
+
+    static matrix_mmap open(const std::string& path, map_mode mode = map_mode::read_only)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            du1_detail::throw_errno("cannot open " + path);
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            int error = errno;
+            ::close(fd);
+            errno = error;
+            du1_detail::throw_errno("cannot stat " + path);
+        }
+
+        std::size_t length = static_cast<std::size_t>(st.st_size);
+        void* mapping = length > 0
+            ? ::mmap(nullptr, length,
+                     mode == map_mode::read_only ? PROT_READ : PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE, fd, 0)
+            : MAP_FAILED;
+        int error = errno;
+
+        // The mapping keeps its own reference to the file.
+        ::close(fd);
+
+        if (length == 0)
+            throw matrix_io_error(path + " is not a matrix file");
+
+        if (mapping == MAP_FAILED)
+        {
+            errno = error;
+            du1_detail::throw_errno("cannot map " + path);
+        }
+
+        matrix_mmap result;
+        result.mapping_ = mapping;
+        result.length_ = length;
+        result.mode_ = mode;
+        result.view_ = validate(path, static_cast<char*>(mapping), length);
+        return result;
+    }
+
+    map_mode mode() const
+    {
+        return mode_;
+    }
+
+    matrix_view<const T> view() const
+    {
+        return view_;
+    }
+
+    matrix_view<T> mutable_view() const
+    {
+        du_assert(mode_ == map_mode::copy_on_write);
+
+        return view_;
+    }
+
+    ccols_t cols() const
+    {
+        return view().cols();
+    }
+
+    crows_t rows() const
+    {
+        return view().rows();
+    }
+
+    crow_t operator[](size_type n) const
+    {
+        return view()[n];
+    }
+
+    const T* data() const
+    {
+        return view_.data();
+    }
+
+    difference_type row_step() const
+    {
+        return view_.row_step();
+    }
+
+    difference_type col_step() const
+    {
+        return view_.col_step();
+    }
+
+private:
+    static matrix_view<T> validate(const std::string& path, char* mapping, std::size_t length)
+    {
+        matrix_file_header header;
+
+        if (length < sizeof(header))
+            throw matrix_io_error(path + " is not a matrix file");
+
+        std::memcpy(&header, mapping, sizeof(header));
+
+        if (std::memcmp(header.magic, du1_detail::matrix_file_magic, sizeof(header.magic)) != 0)
+            throw matrix_io_error(path + " is not a matrix file");
+        if (header.byte_order != du1_detail::matrix_file_byte_order)
+            throw matrix_io_error(path + " was written with a different byte order");
+        if (header.version > du1_detail::matrix_file_version)
+            throw matrix_io_error(path + " has an unsupported format version");
+        if (header.element_size != sizeof(T) || header.element_kind != du1_detail::element_kind<T>())
+            throw matrix_io_error(path + " has a different element type");
+        if (header.layout > 1 || header.data_offset % alignof(T) != 0)
+            throw matrix_io_error(path + " has an invalid header");
+
+        std::uint64_t lines = header.layout == 0 ? header.rows : header.cols;
+        std::uint64_t line = header.layout == 0 ? header.cols : header.rows;
+
+        if (header.data_offset > length
+            || header.leading_dimension < line
+            || (lines > 0 && header.leading_dimension > (length - header.data_offset) / sizeof(T) / lines))
+            throw matrix_io_error(path + " is truncated");
+
+        difference_type ld = static_cast<difference_type>(header.leading_dimension);
+
+        return matrix_view<T>(reinterpret_cast<T*>(mapping + header.data_offset),
+                              static_cast<size_type>(header.rows),
+                              static_cast<size_type>(header.cols),
+                              header.layout == 0 ? ld : 1,
+                              header.layout == 0 ? 1 : ld);
+    }
+
+    void unmap()
+    {
+        if (mapping_)
+            ::munmap(mapping_, length_);
+    }
+
+    void*          mapping_;
+    std::size_t    length_;
+    map_mode       mode_;
+    matrix_view<T> view_;
+};
+
+//   Matrix streams
+//   ==============
+//
+//   write_matrix(out, m) and read_matrix<T>(in) transfer a matrix (or a view)
+// through a std::ostream / std::istream or a file descriptor, which may be
+// a pipe or a socket. The stream starts with a 64 byte header:
+//
+//   offset  size  field
+//   ------------------------------------------------------------------
+//        0     8  magic "DU1MSTRM"
+//        8     4  format version (currently 1)
+//       12     4  byte order mark 0x01020304, as written by the host
+//       16     8  rows
+//       24     8  columns
+//       32     8  rows per chunk
+//       40     4  element size (in bytes)
+//       44     1  element kind, see 'Binary matrix files'
+//       45     1  1 if every chunk is followed by a checksum, 0 otherwise
+//       46    18  reserved, zero
+//
+// followed by the rows in chunks of "rows per chunk" rows (the last one may
+// be shorter), each row being cols elements without padding, no matter what
+// the layout of the matrix is. With checksums enabled, each chunk is
+// followed by a 64 bit checksum of its bytes; a mismatch makes the reader
+// throw matrix_io_error.
+//
+//   The chunk size follows from stream_options::buffer_size (1 MiB by
+// default): the writer gathers rows into a buffer of at most that many bytes
+// (at least one row), or writes them straight from the storage when they are
+// contiguous. The reader only ever holds a single chunk, so row_reader<T>,
+// which hands out the rows one at a time as crow_t proxies, can process
+// matrices that do not fit into memory.
+//
+struct stream_options
+{
+    stream_options()
+        : buffer_size(1 << 20)
+        , checksums(false)
+    { }
+
+    std::size_t buffer_size;
+    bool        checksums;
+};
+
+struct matrix_stream_header
+{
+    char          magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint64_t rows;
+    std::uint64_t cols;
+    std::uint64_t chunk_rows;
+    std::uint32_t element_size;
+    char          element_kind;
+    std::uint8_t  checksums;
+    std::uint8_t  reserved[18];
+};
+
+static_assert(sizeof(matrix_stream_header) == 64, "unexpected header padding");
+
+namespace du1_detail
+{
+    constexpr char matrix_stream_magic[8] = { 'D', 'U', '1', 'M', 'S', 'T', 'R', 'M' };
+
+    class ostream_sink
+    {
+    public:
+        explicit ostream_sink(std::ostream& out)
+            : out_(out)
+        { }
+
+        void write(const void* data, std::size_t bytes)
+        {
+            if (!out_.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes)))
+                throw matrix_io_error("cannot write to the stream");
+        }
+
+    private:
+        std::ostream& out_;
+    };
+
+    class fd_sink
+    {
+    public:
+        explicit fd_sink(int fd)
+            : fd_(fd)
+        { }
+
+        void write(const void* data, std::size_t bytes)
+        {
+            const char* p = static_cast<const char*>(data);
+
+            while (bytes > 0)
+            {
+                ssize_t n = ::write(fd_, p, bytes);
+                if (n < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    throw_errno("cannot write to the file descriptor");
+                }
+
+                p += n;
+                bytes -= static_cast<std::size_t>(n);
+            }
+        }
+
+    private:
+        int fd_;
+    };
+
+    // Reads from either a std::istream or a file descriptor.
+    class byte_source
+    {
+    public:
+        explicit byte_source(std::istream& in)
+            : in_(&in)
+            , fd_(-1)
+        { }
+
+        explicit byte_source(int fd)
+            : in_(nullptr)
+            , fd_(fd)
+        { }
+
+        void read(void* data, std::size_t bytes)
+        {
+            char* p = static_cast<char*>(data);
+
+            if (in_)
+            {
+                if (!in_->read(p, static_cast<std::streamsize>(bytes)))
+                    throw matrix_io_error("unexpected end of the matrix stream");
+                return;
+            }
+
+            while (bytes > 0)
+            {
+                ssize_t n = ::read(fd_, p, bytes);
+                if (n < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    throw_errno("cannot read from the file descriptor");
+                }
+                if (n == 0)
+                    throw matrix_io_error("unexpected end of the matrix stream");
+
+                p += n;
+                bytes -= static_cast<std::size_t>(n);
+            }
+        }
+
+    private:
+        std::istream* in_;
+        int           fd_;
+    };
+
+    // FNV-1a over 64 bit words (bytes for the tail).
+    inline std::uint64_t stream_checksum(const void* data, std::size_t bytes)
+    {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        std::uint64_t hash = 0xcbf29ce484222325ull;
+
+        for (; bytes >= 8; p += 8, bytes -= 8)
+        {
+            std::uint64_t word;
+            std::memcpy(&word, p, 8);
+            hash = (hash ^ word) * 0x100000001b3ull;
+        }
+
+        for (; bytes > 0; ++p, --bytes)
+            hash = (hash ^ *p) * 0x100000001b3ull;
+
+        return hash;
+    }
+
+    template <typename Sink, typename M>
+    void write_matrix(Sink& sink, const M& m, const stream_options& options)
+    {
+        typedef typename M::value_type T;
+
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "only trivially copyable elements can be streamed");
+
+        std::size_t rows = m.rows().size();
+        std::size_t cols = m.cols().size();
+        std::size_t row_bytes = cols * sizeof(T);
+
+        matrix_stream_header header = { };
+        std::memcpy(header.magic, matrix_stream_magic, sizeof(header.magic));
+        header.version = matrix_file_version;
+        header.byte_order = matrix_file_byte_order;
+        header.rows = rows;
+        header.cols = cols;
+        header.chunk_rows = row_bytes > 0 ? std::max<std::size_t>(1, options.buffer_size / row_bytes)
+                                          : std::max<std::size_t>(1, rows);
+        header.element_size = sizeof(T);
+        header.element_kind = element_kind<T>();
+        header.checksums = options.checksums ? 1 : 0;
+
+        sink.write(&header, sizeof(header));
+
+        bool contiguous = m.col_step() == 1
+                       && static_cast<std::size_t>(m.row_step()) == cols;
+        std::vector<T> buffer;
+
+        for (std::size_t first = 0; first < rows; first += header.chunk_rows)
+        {
+            std::size_t count = std::min<std::size_t>(header.chunk_rows, rows - first);
+            const T* chunk = m.data() + static_cast<std::ptrdiff_t>(first) * m.row_step();
+
+            if (!contiguous)
+            {
+                buffer.resize(count * cols);
+
+                T* dst = buffer.data();
+                for (std::size_t i = first; i < first + count; ++i)
+                    for (auto x : m.rows()[i])
+                        *dst++ = x;
+
+                chunk = buffer.data();
+            }
+
+            sink.write(chunk, count * row_bytes);
+
+            if (options.checksums)
+            {
+                std::uint64_t sum = stream_checksum(chunk, count * row_bytes);
+                sink.write(&sum, sizeof(sum));
+            }
+        }
+    }
+
+    template <typename T>
+    matrix_stream_header read_stream_header(byte_source& source)
+    {
+        matrix_stream_header header;
+        source.read(&header, sizeof(header));
+
+        if (std::memcmp(header.magic, matrix_stream_magic, sizeof(header.magic)) != 0)
+            throw matrix_io_error("not a matrix stream");
+        if (header.byte_order != matrix_file_byte_order)
+            throw matrix_io_error("the matrix stream was written with a different byte order");
+        if (header.version > matrix_file_version)
+            throw matrix_io_error("unsupported matrix stream version");
+        if (header.element_size != sizeof(T) || header.element_kind != element_kind<T>())
+            throw matrix_io_error("the matrix stream has a different element type");
+        if (header.chunk_rows == 0)
+            throw matrix_io_error("the matrix stream has an invalid header");
+
+        // The matrix and a chunk must be addressable, in bytes.
+        std::uint64_t max_elements = std::numeric_limits<std::size_t>::max() / sizeof(T);
+        std::uint64_t max_rows = header.cols > 0 ? max_elements / header.cols : max_elements;
+
+        if (header.rows > max_rows || header.chunk_rows > max_rows)
+            throw matrix_io_error("the matrix stream has an invalid header");
+
+        return header;
+    }
+
+    // Reads a chunk of the given number of bytes (and its checksum).
+    inline void read_chunk(byte_source& source, const matrix_stream_header& header,
+                           void* data, std::size_t bytes)
+    {
+        source.read(data, bytes);
+
+        if (header.checksums)
+        {
+            std::uint64_t sum;
+            source.read(&sum, sizeof(sum));
+
+            if (sum != stream_checksum(data, bytes))
+                throw matrix_io_error("matrix stream checksum mismatch");
+        }
+    }
+
+    template <typename T, typename Layout, typename Alloc>
+    matrix<T, Layout, Alloc> read_matrix(byte_source& source, const Alloc& alloc)
+    {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "only trivially copyable elements can be streamed");
+
+        matrix_stream_header header = read_stream_header<T>(source);
+
+        std::size_t rows = static_cast<std::size_t>(header.rows);
+        std::size_t cols = static_cast<std::size_t>(header.cols);
+        matrix<T, Layout, Alloc> m(rows, cols, T(), alloc);
+
+        // Row-major chunks land directly in the storage.
+        bool contiguous = m.col_step() == 1;
+        std::vector<T> buffer;
+
+        for (std::size_t first = 0; first < rows; first += header.chunk_rows)
+        {
+            std::size_t count = std::min<std::size_t>(header.chunk_rows, rows - first);
+
+            if (contiguous)
+            {
+                read_chunk(source, header, m.data() + first * cols, count * cols * sizeof(T));
+            }
+            else
+            {
+                buffer.resize(count * cols);
+                read_chunk(source, header, buffer.data(), count * cols * sizeof(T));
+
+                const T* src = buffer.data();
+                for (std::size_t i = first; i < first + count; ++i)
+                    for (auto& x : m[i])
+                        x = *src++;
+            }
+        }
+
+        return m;
+    }
+}
+
+template <typename M>
+void write_matrix(std::ostream& out, const M& m, const stream_options& options = stream_options())
+{
+    du1_detail::ostream_sink sink(out);
+    du1_detail::write_matrix(sink, m, options);
+}
+
+template <typename M>
+void write_matrix(int fd, const M& m, const stream_options& options = stream_options())
+{
+    du1_detail::fd_sink sink(fd);
+    du1_detail::write_matrix(sink, m, options);
+}
+
+template <typename T, typename Layout = row_major, typename Alloc = std::allocator<T> >
+matrix<T, Layout, Alloc> read_matrix(std::istream& in, const Alloc& alloc = Alloc())
+{
+    du1_detail::byte_source source(in);
+    return du1_detail::read_matrix<T, Layout, Alloc>(source, alloc);
+}
+
+template <typename T, typename Layout = row_major, typename Alloc = std::allocator<T> >
+matrix<T, Layout, Alloc> read_matrix(int fd, const Alloc& alloc = Alloc())
+{
+    du1_detail::byte_source source(fd);
+    return du1_detail::read_matrix<T, Layout, Alloc>(source, alloc);
+}
+
+//   row_reader class template
+//   =========================
+//
+//   Reads a matrix stream row by row, keeping a single chunk in memory:
+//
+//   row_reader<double> reader(std::cin);
+//   while (reader.next())
+//       f(reader.row());
+//
+//   The row stays valid until the next call to next().
+//
+template <typename T>
+class row_reader
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "only trivially copyable elements can be streamed");
+
+public:
+    typedef std::size_t                             size_type;
+    typedef typename matrix_view<const T>::crow_t   crow_t;
+
+    explicit row_reader(std::istream& in)
+        : source_(in)
+        , header_(du1_detail::read_stream_header<T>(source_))
+        , chunk_()
+        , next_()
+        , chunk_first_()
+        , chunk_rows_()
+    { }
+
+    explicit row_reader(int fd)
+        : source_(fd)
+        , header_(du1_detail::read_stream_header<T>(source_))
+        , chunk_()
+        , next_()
+        , chunk_first_()
+        , chunk_rows_()
+    { }
+
+    // Shape of the whole matrix.
+    size_type rows() const
+    {
+        return static_cast<size_type>(header_.rows);
+    }
+
+    size_type cols() const
+    {
+        return static_cast<size_type>(header_.cols);
+    }
+
+    // Moves to the next row (the first one on the first call). Returns false
+    // once all rows have been read.
+    bool next()
+    {
+        if (next_ == rows())
+            return false;
+
+        if (next_ == chunk_first_ + chunk_rows_)
+        {
+            chunk_first_ = next_;
+            chunk_rows_ = std::min<size_type>(static_cast<size_type>(header_.chunk_rows),
+                                              rows() - next_);
+
+            chunk_.resize(chunk_rows_ * cols());
+            du1_detail::read_chunk(source_, header_, chunk_.data(), chunk_.size() * sizeof(T));
+        }
+
+        ++next_;
+        return true;
+    }
+
+    // Index of the current row.
+    size_type index() const
+    {
+        du_assert(next_ > 0);
+
+        return next_ - 1;
+    }
+
+    crow_t row() const
+    {
+        du_assert(next_ > 0);
+
+        matrix_view<const T> chunk(chunk_.data(), chunk_rows_, cols(), static_cast<std::ptrdiff_t>(cols()), 1);
+        return chunk[index() - chunk_first_];
+    }
+
+private:
+    du1_detail::byte_source source_;
+    matrix_stream_header    header_;
+    std::vector<T>          chunk_;
+    size_type               next_;
+    size_type               chunk_first_;
+    size_type               chunk_rows_;
+};
+
+#endif // DU1_IO_HPP
@@ -4,11 +4,291 @@
 #ifndef DU1_MATRIX_HPP
 #define DU1_MATRIX_HPP
 
+#include <algorithm>
+#include <initializer_list>
 #include <iterator>
+#include <memory>
+#include <numeric>
+#include <ranges>
+#include <span>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#include <xmmintrin.h>
+#endif
+
 #include "du1debug.hpp"
+#include "du1profile.hpp"
+
+//   Storage layouts
+//   ---------------
+//
+//   The second template parameter of matrix decides how elements are placed
+// in memory. A layout describes the minimal leading dimension of a rows * cols
+// matrix, how far apart vertically (row_step) and horizontally (col_step)
+// adjacent elements are for a given leading dimension, and how many elements
+// the storage takes. Since every proxy and iterator is a pointer plus
+// a step, they all work with any such layout and the public interface does
+// not change.
+//
+//   row_major    - rows are contiguous (the default)
+//   column_major - columns are contiguous, cols() is the cheap direction
+//
+struct row_major
+{
+    static constexpr std::size_t leading_dimension(std::size_t, std::size_t cols)
+    {
+        return cols;
+    }
+
+    static constexpr std::size_t storage_size(std::size_t rows, std::size_t, std::size_t ld)
+    {
+        return rows * ld;
+    }
+
+    static constexpr std::ptrdiff_t row_step(std::size_t ld)
+    {
+        return static_cast<std::ptrdiff_t>(ld);
+    }
+
+    static constexpr std::ptrdiff_t col_step(std::size_t)
+    {
+        return 1;
+    }
+};
+
+struct column_major
+{
+    static constexpr std::size_t leading_dimension(std::size_t rows, std::size_t)
+    {
+        return rows;
+    }
+
+    static constexpr std::size_t storage_size(std::size_t, std::size_t cols, std::size_t ld)
+    {
+        return cols * ld;
+    }
+
+    static constexpr std::ptrdiff_t row_step(std::size_t)
+    {
+        return 1;
+    }
+
+    static constexpr std::ptrdiff_t col_step(std::size_t ld)
+    {
+        return static_cast<std::ptrdiff_t>(ld);
+    }
+};
+
+//   Padding
+//   -------
+//
+//   By default consecutive rows (columns for column_major) follow each other
+// directly. Passing a padding to the constructor makes the leading dimension
+// larger than that, either a given value (padding(ld)) or one chosen
+// automatically (padding::automatic()): the smallest one that makes every
+// line span a whole number of cache lines, bumped by one more cache line when
+// it would be a multiple of 4 KiB (where lines alias in the L1 cache and
+// confuse store forwarding). Together with an aligned allocator, every line
+// then starts on a cache line boundary, so aligned SIMD loads are possible and
+// threads writing neighbouring lines do not share cache lines.
+//
+struct padding
+{
+    // Zero means automatic.
+    explicit padding(std::size_t ld)
+        : leading_dimension(ld)
+    { }
+
+    static padding automatic()
+    {
+        return padding(0);
+    }
+
+    std::size_t leading_dimension;
+};
+
+//   Bounds checking
+//   ---------------
+//
+//   The fourth template parameter of matrix (the second one of matrix_view)
+// is the check policy, deciding which preconditions the matrix, its proxies
+// and iterators verify:
+//
+//   unchecked    - nothing
+//   cheap_checks - indices passed to operator[] (a single unsigned comparison
+//                  per access) and the arguments of members that create views
+//                  or change the shape. Iterators are not checked: a loop from
+//                  begin() to end() cannot leave its line, so the range is
+//                  validated once where it is created rather than on every
+//                  step
+//   full_checks  - in addition, every dereference, increment, decrement and
+//                  jump of an iterator, and comparisons of iterators into
+//                  different lines
+//
+//   A failed check calls du_abort, whether DU_NDEBUG is defined or not.
+// default_checks, which matrix<T> and matrix_view<T> use, is full_checks, or
+// unchecked with DU_NDEBUG, just like du_assert. Since the policy is part of
+// the type, hardened matrices on untrusted input paths and unchecked ones in
+// inner kernels live side by side in one program. Operations combining
+// several operands (products, element-wise expressions, batches) check their
+// shapes when any operand's policy checks indices. The explicit converting
+// constructor of matrix copies between policies, a matrix_view converts
+// implicitly to a view with any policy.
+//
+//   A policy is any type with the static constexpr bool members indices and
+// iterators.
+//
+struct unchecked
+{
+    static constexpr bool indices = false;
+    static constexpr bool iterators = false;
+};
+
+struct cheap_checks
+{
+    static constexpr bool indices = true;
+    static constexpr bool iterators = false;
+};
+
+struct full_checks
+{
+    static constexpr bool indices = true;
+    static constexpr bool iterators = true;
+};
+
+#ifndef DU_NDEBUG
+typedef full_checks default_checks;
+#else
+typedef unchecked default_checks;
+#endif
+
+//   Construction without initialization
+//   -----------------------------------
+//
+//   matrix(rows, cols, uninitialized) allocates the storage of a matrix of
+// a trivially default constructible type without writing to it, for matrices
+// that are overwritten right away. matrix(rows, cols, f) fills the matrix
+// with f(i, j) in a single pass over the storage.
+//
+//   Both constructors take an optional execution policy (see du1parallel.hpp).
+// With a parallel policy the storage is split into page-aligned chunks of
+// lines, and every worker touches (or generates) its own chunks first, so on
+// NUMA machines the pages of each chunk end up on the node of the worker
+// that touched them.
+//
+struct uninitialized_t
+{ };
+
+constexpr uninitialized_t uninitialized = { };
+
+//   Growing and reshaping
+//   ---------------------
+//
+//   append_row(range) and append_rows(m) add rows at the bottom of
+// a matrix, resize(rows, cols) changes both extents (keeping the overlapping
+// elements), reserve_rows(n) makes room for n rows in advance and
+// row_capacity() tells how many rows fit without reallocation.
+//
+//   A row_major matrix grows like a std::vector: the storage capacity is
+// doubled when it runs out, so appending costs amortized O(cols) per row.
+// A column_major matrix instead keeps spare rows at the end of every column
+// (as padding, its leading dimension is doubled when they run out), so that
+// appending a row writes one element per column and does not move the
+// others. As long as no reallocation happens, proxies, iterators and data()
+// stay valid. A row being appended may come from the matrix itself.
+//
+//   reshape(rows, cols) reinterprets the storage of an unpadded matrix as
+// another shape with the same number of elements, in storage order, without
+// copying anything.
+//
+
+namespace du1_detail
+{
+    // Allocator adaptor which default-initializes instead of
+    // value-initializing, so that resizing the storage of a trivially
+    // default constructible type does not touch the memory.
+    template <typename A>
+    class default_init_allocator : public A
+    {
+        typedef std::allocator_traits<A> traits;
+
+    public:
+        template <typename U>
+        struct rebind
+        {
+            typedef default_init_allocator<typename traits::template rebind_alloc<U> > other;
+        };
+
+        default_init_allocator()
+        { }
+
+        default_init_allocator(const A& a)
+            : A(a)
+        { }
+
+        template <typename B>
+        default_init_allocator(const default_init_allocator<B>& a)
+            : A(static_cast<const B&>(a))
+        { }
+
+        default_init_allocator select_on_container_copy_construction() const
+        {
+            return traits::select_on_container_copy_construction(*this);
+        }
+
+        template <typename U>
+        void construct(U* p)
+        {
+            ::new (static_cast<void*>(p)) U;
+        }
+
+        template <typename U, typename... Args>
+        void construct(U* p, Args&&... args)
+        {
+            traits::construct(static_cast<A&>(*this), p, std::forward<Args>(args)...);
+        }
+    };
+
+    // Base of the proxy containers (lines, line and tile grids), which are
+    // views borrowing the storage of a matrix, see 'Ranges'.
+    struct proxy_range : std::ranges::view_base
+    { };
+
+    // Whether the check policy of a matrix, view or proxy checks indices (and
+    // thereby the shapes of operations combining it with others); false for
+    // types without a check policy.
+    template <typename M, typename = void>
+    struct checks_indices : std::false_type { };
+
+    template <typename M>
+    struct checks_indices<M, std::void_t<typename M::check_type> >
+        : std::integral_constant<bool, M::check_type::indices> { };
+
+    // a * b mod m for a < m, without overflowing.
+    inline std::size_t mul_mod(std::size_t a, std::size_t b, std::size_t m)
+    {
+#ifdef __SIZEOF_INT128__
+        return static_cast<std::size_t>(static_cast<unsigned __int128>(a) * b % m);
+#else
+        std::size_t result = 0;
+        for (; b > 0; b >>= 1)
+        {
+            if (b & 1)
+                result = result >= m - a ? result - (m - a) : result + a;
+            a = a >= m - a ? a - (m - a) : a + a;
+        }
+        return result;
+#endif
+    }
+}
+
+template <typename R>
+    requires std::derived_from<R, du1_detail::proxy_range>
+inline constexpr bool std::ranges::enable_borrowed_range<R> = true;
 
 //   matrix class template
 //   =====================
@@ -33,8 +313,65 @@
 // inside the matrix) or indirectly via iterator (again, through member
 // functions begin() and end() and their const variants).
 //
-//   At the moment, all exposed iterators are forward iterators only. All
-// iterators also support iterator to const iterator conversion.
+//   All exposed iterators are random access iterators. All iterators also
+// support iterator to const iterator conversion. The proxy containers are
+// standard ranges, see 'Ranges'.
+//
+//   The underlying storage is exposed for code that needs to work on raw
+// memory (memcpy, SIMD loads, C APIs). matrix::data() gives a pointer to the
+// first element, row_step() and col_step() the distance between vertically
+// and horizontally adjacent elements. Every row and column proxy offers data()
+// and stride() with the same meaning for a single line; contiguous lines (rows
+// of a row_major matrix, columns of a column_major one) can also be viewed as
+// a std::span via as_span().
+//
+//   For column-oriented algorithms on wide matrices, tiles(), ctiles() split
+// the matrix into rectangular blocks (tile_t, ctile_t). Each tile again offers
+// rows(), cols() and operator[], so walking the columns of one tile after
+// another keeps the working set inside L1/L2 instead of touching a new cache
+// line (and often a new page) on every step. The default tile extents are
+// derived from sizeof(T) and the cache line size.
+//
+//   transpose() returns a physically transposed copy, transpose_inplace()
+// transposes the matrix itself without allocating a second buffer. Both keep
+// the storage layout.
+//
+//   block(), transposed(), every() and diagonal() return a matrix_view, which
+// refers to (a part of) the elements of the matrix without copying them.
+//
+//   Rows can be appended and the matrix can be resized or reshaped, see
+// 'Growing and reshaping'.
+//
+//   The third template parameter is the allocator used for the element
+// storage; du1alloc.hpp offers aligned, arena and pool allocators. The fourth
+// one selects the precondition checks, see 'Bounds checking'.
+//
+//   Built with DU1_PROFILE, every matrix counts the proxies and element
+// accesses made through them and profile() suggests a layout or tiling that
+// fits the observed pattern, see du1profile.hpp. Without it, the counting
+// compiles away.
+//
+//   Arithmetic is provided by separate headers: du1multiply.hpp for the
+// matrix product, du1expr.hpp for lazy element-wise expressions, which
+// a matrix can be constructed from and assigned.
+//
+//   Ranges
+//   ------
+//
+//   Lines (row_t, col_t, ...), line containers (rows_t, cols_t, ...) and
+// tile grids (tiles_t, ctiles_t) model std::ranges::random_access_range,
+// sized_range and common_range (end() has the iterator type), and, since
+// they are a pointer and a few extents borrowing the storage of the matrix,
+// std::ranges::view and borrowed_range. So they work with the std::ranges
+// algorithms, iterators into a temporary proxy (m.rows()[i]) do not dangle,
+// and range adaptors (views::filter, views::transform, views::reverse, ...)
+// copy the proxy instead of materializing anything:
+//
+//   for (auto total : m.rows() | std::views::transform(row_sum))
+//
+//   The stride of a line is only known at run time (a row of a transposed
+// view is not contiguous), so lines are not contiguous ranges. Where it is 1,
+// as_span() gives the line as a std::span, which is a contiguous_range.
 //
 //   Example usage
 //   -------------
@@ -52,10 +389,9 @@
 //   Implementation details
 //   ----------------------
 //
-//   The following diagram represents the structure of column non-const and
-// const row and rows views and their respective iterators. Note that
-// the implementation of column views is symmetric, with the exception of
-// matrix::operator[].
+//   The following diagram represents the structure of non-const and const row
+// and rows views and their respective iterators. Note that column views share
+// the implementation with row views, with the exception of matrix::operator[].
 //
 //  ///////////////////////////////////////////////////////////////////////
 //  //                                                                   //
@@ -121,6 +457,12 @@
 //           const_col_element_base | ccols_t
 //                 row_element_base | rows_t
 //           const_row_element_base | crows_t
+//                tile_element_base | tile_t
+//          const_tile_element_base | ctile_t
+//               tile_iterator_base | tiles_t_iterator
+//         const_tile_iterator_base | ctiles_t_iterator
+//               tiles_element_base | tiles_t
+//         const_tiles_element_base | ctiles_t
 //
 //
 //   This design helps to reduce code duplication by shifting the const vs.
@@ -129,49 +471,76 @@
 // type parameter. So, for example, col_t and ccol_t are actually typedefs for
 // the following classes:
 //
-//   typedef col_t_base<      c_element_base> col_t;
-//   typedef col_t_base<const_c_element_base> ccol_t;
+//   typedef line_t_base<      c_element_base> col_t;
+//   typedef line_t_base<const_c_element_base> ccol_t;
 //
-//   cols_t, ccols_t, rows_t and crows_t only contain a (const) pointer to
-// the matrix. begin() returns an iterator with zero offset, end() with the
-// offset being the number of columns (or rows, respectively). operator[]
-// returns col_t, row_t (and their const variants respectively) directly
-// focusing specific column or row.
+//   A row and a column differ only in the distance between two consecutive
+// elements (the stride), so both are served by the same class templates. The
+// row and column structs are kept apart so that row_t and col_t remain
+// distinct types. Column and row iterators, on the other hand, are the same
+// type.
+//
+//   cols_t, ccols_t, rows_t and crows_t contain a (const) pointer to the first
+// element of the first line, the number of lines, the distance between the
+// first elements of two consecutive lines (the step), and the length and
+// stride of a single line. begin() returns an iterator with zero offset, end()
+// with the offset being the number of columns (or rows, respectively).
+// operator[] returns col_t, row_t (and their const variants respectively)
+// directly focusing specific column or row.
 //
 //   cols_t_iterator, ccols_t_iterator, rows_t_iterator and crows_t_iterator
 // contain col_t, ccol_t, row_t and crow_t respectively. Since current row or
-// column have no direct representation inside the matrix, operators * and ->
-// return a (non-constant) reference and pointer to an object representing
-// current line inside the iterator.
+// column have no direct representation inside the matrix, operator * returns
+// the line by value: the reference type of these iterators (and of the
+// containers) is the proxy itself, like the bit reference of
+// std::vector<bool>. A reference bound to a field of the iterator would
+// change whenever the iterator moves, which breaks the equality and
+// multi-pass guarantees of std::forward_iterator. operator[] returns the
+// line by value for the same reason.
 //
 //   Digression:
 //
-//   Since row_t, crow_t, col_t and ccol_t offer no public
-// operations that mutate its state, the field inside the iterators mentioned
-// above is declared mutable. This allows to keep logically constant operations
-// (such as operator * and ->) const while still allowing us to return a
-// non-constant reference or pointer.
+//   operator -> still has to return a pointer, so it returns one to
+// a copy of the current line kept inside the iterator. Since row_t, crow_t,
+// col_t and ccol_t offer no public operations that mutate its state,
+// operator -> casts the constness of that field away, which keeps it const
+// while still returning a non-constant pointer. (A mutable field would do the
+// same, but would keep the iterators out of constant expressions.) The
+// pointer is only meant for immediate member access (it->begin()); it follows
+// the iterator when it moves.
 //
-//   Other options include marking * and -> as non-const or forcing them
-// to return a constant reference or pointer. All these options are viable,
-// but the last one might force certain typedefs which should not be const, to
-// become const. For simplicity and consistency, a mutable field is used.
+//   col_t, ccol_t, row_t and crow_t contain a pointer to the first element of
+// the line, its length and its stride. begin() and end() return an iterator
+// capable of directly accessing the values stored inside the matrix.
+// operator[] also gives direct access to the matrix.
 //
-//   col_t, ccol_t, row_t and crow_t contain a pointer to the matrix and the
-// number of current line. begin() and end() return an iterator capable of
-// directly accessing the values stored inside the matrix. operator[] also gives
-// direct access to the matrix.
+//   tile_t and ctile_t contain a pointer to their top left element, their
+// extents and the leading dimension of the matrix. tiles_t and ctiles_t
+// describe the whole grid of tiles; their iterators keep a copy of the grid and
+// the index of the current tile, which is only turned into a tile_t when
+// dereferenced (and stored in a mutable field for operator ->, see above).
 //
 //   col_t_iterator, ccol_t_iterator, row_t_iterator, crow_t_iterator contain
-// a pointer to the matrix, the number of the current line and the current
-// offset.
+// a pointer to the current element and the stride, so that moving along
+// a column costs a single addition no matter how wide the matrix is. The first
+// element and the length of the line are only kept for debugging checks.
+// Strides are always positive, which allows iterators to be ordered simply by
+// comparing the pointers.
 //
-template <typename T>
+template <typename T, typename Check = default_checks>
+class matrix_view;
+
+template <typename T, std::size_t Rows, std::size_t Cols, typename Layout, typename Check>
+class static_matrix;
+
+template <typename T, typename Layout = row_major, typename Alloc = std::allocator<T>,
+          typename Check = default_checks>
 class matrix
 {
-    typedef matrix<T>      self;
+    typedef matrix<T, Layout, Alloc, Check> self;
 
 public:
+    typedef Alloc          allocator_type;
     typedef T              value_type;
     typedef T&             reference;
     typedef T*             pointer;
@@ -179,51 +548,223 @@ public:
     typedef const T*       const_pointer;
     typedef std::ptrdiff_t difference_type;
     typedef std::size_t    size_type;
+    typedef Check          check_type;
 
     // Constructors.
     matrix()
         : data_()
         , rows_()
         , cols_()
+        , ld_()
+    { }
+
+    explicit matrix(const allocator_type& alloc)
+        : data_(alloc)
+        , rows_()
+        , cols_()
+        , ld_()
     { }
 
-    matrix(size_type rows, size_type cols, const value_type& def)
-        : data_(rows * cols, def)
+    matrix(size_type rows, size_type cols, const value_type& def,
+           const allocator_type& alloc = allocator_type())
+        : data_(rows * cols, def, alloc)
         , rows_(rows)
         , cols_(cols)
+        , ld_(Layout::leading_dimension(rows, cols))
     { }
 
+    // Padded storage, see 'Padding'. The padding elements are initialized
+    // with def as well.
+    matrix(size_type rows, size_type cols, const value_type& def, padding pad,
+           const allocator_type& alloc = allocator_type())
+        : data_(alloc)
+        , rows_(rows)
+        , cols_(cols)
+        , ld_(padded_leading_dimension(rows, cols, pad))
+    {
+        data_.assign(Layout::storage_size(rows, cols, ld_), def);
+    }
+
+    // The allocator is propagated on copy, move and swap according to
+    // std::allocator_traits, just like in the standard containers.
     matrix(const self&) = default;
     matrix(self&&) = default;
 
+    // Uninitialized storage, see 'Construction without initialization'.
+    matrix(size_type rows, size_type cols, uninitialized_t,
+           const allocator_type& alloc = allocator_type())
+        : data_(alloc)
+        , rows_(rows)
+        , cols_(cols)
+        , ld_(Layout::leading_dimension(rows, cols))
+    {
+        static_assert(std::is_trivially_default_constructible<T>::value,
+                      "uninitialized storage requires a trivially default constructible type");
+
+        data_.resize(Layout::storage_size(rows, cols, ld_));
+    }
+
+    template <typename Policy,
+              typename = typename std::enable_if<!std::is_convertible<Policy, allocator_type>::value>::type>
+    matrix(size_type rows, size_type cols, uninitialized_t u, const Policy& policy,
+           const allocator_type& alloc = allocator_type())
+        : matrix(rows, cols, u, alloc)
+    {
+        // One element per page is enough to place the page.
+        size_type per_page = std::max<size_type>(1, 4096 / sizeof(T));
+
+        for_storage_lines(policy, [this, per_page](size_type first, size_type last)
+        {
+            pointer begin = data() + first * ld_;
+            pointer end = data() + last * ld_;
+
+            for (pointer p = begin; p < end; p += per_page)
+                *p = T();
+        });
+    }
+
+    // Generated contents, element (i, j) is f(i, j).
+    template <typename F,
+              typename = typename std::enable_if<std::is_invocable_r<T, F&, size_type, size_type>::value>::type>
+    matrix(size_type rows, size_type cols, F f, const allocator_type& alloc = allocator_type())
+        : matrix(rows, cols, f, matrix_sequential(), alloc)
+    { }
+
+    template <typename F, typename Policy,
+              typename = typename std::enable_if<std::is_invocable_r<T, F&, size_type, size_type>::value
+                                              && !std::is_convertible<Policy, allocator_type>::value>::type>
+    matrix(size_type rows, size_type cols, F f, const Policy& policy,
+           const allocator_type& alloc = allocator_type())
+        : data_(alloc)
+        , rows_(rows)
+        , cols_(cols)
+        , ld_(Layout::leading_dimension(rows, cols))
+    {
+        data_.resize(Layout::storage_size(rows, cols, ld_));
+
+        // Lines of the storage are rows for row_major, columns otherwise (the
+        // steps cannot tell when a dimension is 1).
+        constexpr bool by_rows = rows_are_lines;
+        size_type length = by_rows ? cols_ : rows_;
+
+        for_storage_lines(policy, [&](size_type first, size_type last)
+        {
+            for (size_type k = first; k < last; ++k)
+            {
+                pointer line = data() + k * ld_;
+
+                for (size_type e = 0; e < length; ++e)
+                    line[e] = by_rows ? f(k, e) : f(e, k);
+            }
+        });
+    }
+
+    matrix(const self& other, const allocator_type& alloc)
+        : data_(other.data_, alloc)
+        , rows_(other.rows_)
+        , cols_(other.cols_)
+        , ld_(other.ld_)
+    { }
+
+    matrix(self&& other, const allocator_type& alloc)
+        : data_(std::move(other.data_), alloc)
+        , rows_(other.rows_)
+        , cols_(other.cols_)
+        , ld_(other.ld_)
+    { }
+
+    // Conversion from a matrix with a different storage layout, allocator or
+    // check policy.
+    template <typename OtherLayout, typename OtherAlloc, typename OtherCheck>
+    explicit matrix(const matrix<T, OtherLayout, OtherAlloc, OtherCheck>& other,
+                    const allocator_type& alloc = allocator_type())
+        : data_(alloc)
+        , rows_(other.rows().size())
+        , cols_(other.cols().size())
+        , ld_(Layout::leading_dimension(rows_, cols_))
+    {
+        copy_lines(other);
+    }
+
+    // Copy of the elements of a view (see matrix_view).
+    template <typename U, typename ViewCheck,
+              typename = typename std::enable_if<std::is_same<typename std::remove_const<U>::type, T>::value>::type>
+    explicit matrix(const matrix_view<U, ViewCheck>& view, const allocator_type& alloc = allocator_type())
+        : data_(alloc)
+        , rows_(view.height())
+        , cols_(view.width())
+        , ld_(Layout::leading_dimension(rows_, cols_))
+    {
+        copy_lines(view);
+    }
+
+    // Evaluation of lazy element-wise expressions (see du1expr.hpp). Any type
+    // with a nested expression_tag providing nrows(), ncols() and evaluate()
+    // is accepted; see operator= for aliases().
+    template <typename Expr, typename = typename Expr::expression_tag>
+    matrix(const Expr& e, const allocator_type& alloc = allocator_type())
+        : data_(e.nrows() * e.ncols(), alloc)
+        , rows_(e.nrows())
+        , cols_(e.ncols())
+        , ld_(Layout::leading_dimension(rows_, cols_))
+    {
+        e.evaluate(data(), row_step(), col_step());
+    }
+
     // Assignment.
     self& operator=(const self&) = default;
     self& operator=(self&&) = default;
 
-    // Forward declaration of helper class templates.
-    template <typename Base>
-    class col_t_iterator_base;
+    allocator_type get_allocator() const
+    {
+        return allocator_type(data_.get_allocator());
+    }
+
+    // The expression is evaluated in place when the shapes match and no
+    // operand overlaps the matrix other than element for element (the matrix
+    // itself, or a view of it with the same origin and steps); e.aliases()
+    // tells. Otherwise, as for expressions without aliases(), it is evaluated
+    // into a new matrix, so the matrix may appear in the expression in any
+    // form (m = m.transposed() + 0).
+    template <typename Expr, typename = typename Expr::expression_tag>
+    self& operator=(const Expr& e)
+    {
+        bool in_place = e.nrows() == rows_ && e.ncols() == cols_;
+
+        if constexpr (requires { e.aliases(data(), row_step(), col_step()); })
+            in_place = in_place && !e.aliases(data(), row_step(), col_step());
+        else
+            in_place = false;
+
+        if (in_place)
+            e.evaluate(data(), row_step(), col_step());
+        else
+            *this = self(e, get_allocator());
+
+        return *this;
+    }
 
+    // Forward declaration of helper class templates.
     template <typename Base>
-    class col_t_base;
+    class line_t_iterator_base;
 
     template <typename Base>
-    class cols_t_iterator_base;
+    class line_t_base;
 
     template <typename Base>
-    class cols_t_base;
+    class lines_t_iterator_base;
 
     template <typename Base>
-    class row_t_iterator_base;
+    class lines_t_base;
 
     template <typename Base>
-    class row_t_base;
+    class tile_t_base;
 
     template <typename Base>
-    class rows_t_iterator_base;
+    class tiles_t_iterator_base;
 
     template <typename Base>
-    class rows_t_base;
+    class tiles_t_base;
 
     // Structs containing proxy container and iterator type definitions.
 private:
@@ -232,8 +773,6 @@ private:
         typedef T  value_type;
         typedef T& reference;
         typedef T* pointer;
-
-        typedef self* matrix_pointer;
     };
 
     struct const_element_iterator_base
@@ -241,19 +780,17 @@ private:
         typedef const T  value_type;
         typedef const T& reference;
         typedef const T* pointer;
-
-        typedef const self* matrix_pointer;
     };
 
 public:
-    typedef col_t_iterator_base<element_iterator_base>       col_t_iterator;
-    typedef col_t_iterator_base<const_element_iterator_base> ccol_t_iterator;
+    typedef line_t_iterator_base<element_iterator_base>       col_t_iterator;
+    typedef line_t_iterator_base<const_element_iterator_base> ccol_t_iterator;
 
-    typedef row_t_iterator_base<element_iterator_base>       row_t_iterator;
-    typedef row_t_iterator_base<const_element_iterator_base> crow_t_iterator;
+    typedef line_t_iterator_base<element_iterator_base>       row_t_iterator;
+    typedef line_t_iterator_base<const_element_iterator_base> crow_t_iterator;
 
 private:
-    struct c_element_base
+    struct c_element_base : du1_detail::proxy_range
     {
         typedef T        value_type;
         typedef T&       reference;
@@ -263,11 +800,9 @@ private:
 
         typedef col_t_iterator  iterator;
         typedef ccol_t_iterator const_iterator;
-
-        typedef self* matrix_pointer;
     };
 
-    struct const_c_element_base
+    struct const_c_element_base : du1_detail::proxy_range
     {
         typedef const T  value_type;
         typedef const T& reference;
@@ -277,11 +812,9 @@ private:
 
         typedef ccol_t_iterator iterator;
         typedef ccol_t_iterator const_iterator;
-
-        typedef const self* matrix_pointer;
     };
 
-    struct r_element_base
+    struct r_element_base : du1_detail::proxy_range
     {
         typedef T        value_type;
         typedef T&       reference;
@@ -291,11 +824,9 @@ private:
 
         typedef row_t_iterator  iterator;
         typedef crow_t_iterator const_iterator;
-
-        typedef self* matrix_pointer;
     };
 
-    struct const_r_element_base
+    struct const_r_element_base : du1_detail::proxy_range
     {
         typedef const T  value_type;
         typedef const T& reference;
@@ -305,425 +836,425 @@ private:
 
         typedef crow_t_iterator iterator;
         typedef crow_t_iterator const_iterator;
-
-        typedef const self* matrix_pointer;
     };
 
 public:
-    typedef col_t_base<c_element_base>       col_t;
-    typedef col_t_base<const_c_element_base> ccol_t;
+    typedef line_t_base<c_element_base>       col_t;
+    typedef line_t_base<const_c_element_base> ccol_t;
 
-    typedef row_t_base<r_element_base>       row_t;
-    typedef row_t_base<const_r_element_base> crow_t;
+    typedef line_t_base<r_element_base>       row_t;
+    typedef line_t_base<const_r_element_base> crow_t;
 
 private:
     struct col_element_iterator_base
     {
         typedef col_t  value_type;
-        typedef col_t& reference;
+        typedef col_t  reference;
         typedef col_t* pointer;
 
         typedef col_t line_type;
-        typedef self* matrix_pointer;
+        typedef T*    element_pointer;
     };
 
     struct const_col_element_iterator_base
     {
         typedef ccol_t  value_type;
-        typedef ccol_t& reference;
+        typedef ccol_t  reference;
         typedef ccol_t* pointer;
 
-        typedef ccol_t      line_type;
-        typedef const self* matrix_pointer;
+        typedef ccol_t   line_type;
+        typedef const T* element_pointer;
     };
 
     struct row_element_iterator_base
     {
         typedef row_t  value_type;
-        typedef row_t& reference;
+        typedef row_t  reference;
         typedef row_t* pointer;
 
         typedef row_t line_type;
-        typedef self* matrix_pointer;
+        typedef T*    element_pointer;
     };
 
     struct const_row_element_iterator_base
     {
         typedef crow_t  value_type;
-        typedef crow_t& reference;
+        typedef crow_t  reference;
         typedef crow_t* pointer;
 
-        typedef crow_t      line_type;
-        typedef const self* matrix_pointer;
+        typedef crow_t   line_type;
+        typedef const T* element_pointer;
     };
 
 public:
-    typedef cols_t_iterator_base<col_element_iterator_base>       cols_t_iterator;
-    typedef cols_t_iterator_base<const_col_element_iterator_base> ccols_t_iterator;
+    typedef lines_t_iterator_base<col_element_iterator_base>       cols_t_iterator;
+    typedef lines_t_iterator_base<const_col_element_iterator_base> ccols_t_iterator;
 
-    typedef rows_t_iterator_base<row_element_iterator_base>       rows_t_iterator;
-    typedef rows_t_iterator_base<const_row_element_iterator_base> crows_t_iterator;
+    typedef lines_t_iterator_base<row_element_iterator_base>       rows_t_iterator;
+    typedef lines_t_iterator_base<const_row_element_iterator_base> crows_t_iterator;
 
 private:
-    struct col_element_base
+    struct col_element_base : du1_detail::proxy_range
     {
         typedef col_t   value_type;
-        typedef col_t&  reference;
+        typedef col_t   reference;
         typedef col_t*  pointer;
-        typedef ccol_t& const_reference;
+        typedef ccol_t  const_reference;
         typedef ccol_t* const_pointer;
 
         typedef cols_t_iterator  iterator;
         typedef ccols_t_iterator const_iterator;
 
-        typedef self* matrix_pointer;
+        typedef T* element_pointer;
     };
 
-    struct const_col_element_base
+    struct const_col_element_base : du1_detail::proxy_range
     {
         typedef ccol_t  value_type;
-        typedef ccol_t& reference;
+        typedef ccol_t  reference;
         typedef ccol_t* pointer;
-        typedef ccol_t& const_reference;
+        typedef ccol_t  const_reference;
         typedef ccol_t* const_pointer;
 
         typedef ccols_t_iterator iterator;
         typedef ccols_t_iterator const_iterator;
 
-        typedef const self* matrix_pointer;
+        typedef const T* element_pointer;
     };
 
-    struct row_element_base
+    struct row_element_base : du1_detail::proxy_range
     {
         typedef row_t   value_type;
-        typedef row_t&  reference;
+        typedef row_t   reference;
         typedef row_t*  pointer;
-        typedef crow_t& const_reference;
+        typedef crow_t  const_reference;
         typedef crow_t* const_pointer;
 
         typedef rows_t_iterator  iterator;
         typedef crows_t_iterator const_iterator;
 
-        typedef self* matrix_pointer;
+        typedef T* element_pointer;
     };
 
-    struct const_row_element_base
+    struct const_row_element_base : du1_detail::proxy_range
     {
         typedef crow_t  value_type;
-        typedef crow_t& reference;
+        typedef crow_t  reference;
         typedef crow_t* pointer;
-        typedef crow_t& const_reference;
+        typedef crow_t  const_reference;
         typedef crow_t* const_pointer;
 
         typedef crows_t_iterator iterator;
         typedef crows_t_iterator const_iterator;
 
-        typedef const self* matrix_pointer;
+        typedef const T* element_pointer;
     };
 
 public:
-    typedef cols_t_base<col_element_base>       cols_t;
-    typedef cols_t_base<const_col_element_base> ccols_t;
+    typedef lines_t_base<col_element_base>       cols_t;
+    typedef lines_t_base<const_col_element_base> ccols_t;
 
-    typedef rows_t_base<row_element_base>       rows_t;
-    typedef rows_t_base<const_row_element_base> crows_t;
+    typedef lines_t_base<row_element_base>       rows_t;
+    typedef lines_t_base<const_row_element_base> crows_t;
 
-    // Row and column proxies and iterator helper class templates.
-    template <typename Base>
-    class col_t_iterator_base : public Base
+private:
+    struct tile_element_base
     {
-        friend col_t;
-        friend ccol_t;
+        typedef rows_t rows_type;
+        typedef cols_t cols_type;
+        typedef row_t  line_type;
 
-        // Friend declaration to allow conversion operations.
-        template <typename>
-        friend class col_t_iterator_base;
+        typedef T* element_pointer;
+    };
 
-        using typename Base::matrix_pointer;
+    struct const_tile_element_base
+    {
+        typedef crows_t rows_type;
+        typedef ccols_t cols_type;
+        typedef crow_t  line_type;
 
-    public:
-        using typename Base::value_type;
-        using typename Base::reference;
-        using typename Base::pointer;
+        typedef const T* element_pointer;
+    };
 
-        typedef std::ptrdiff_t            difference_type;
-        typedef std::forward_iterator_tag iterator_category;
+public:
+    typedef tile_t_base<tile_element_base>       tile_t;
+    typedef tile_t_base<const_tile_element_base> ctile_t;
 
-        col_t_iterator_base()
-            : matrix_(nullptr)
-            , cur_col_()
-            , offset_()
-        { }
+private:
+    struct tiles_element_base;
+    struct const_tiles_element_base;
 
-        // Copy and conversion constructor.
-        template <typename U>
-        col_t_iterator_base(const col_t_iterator_base<U>& other)
-            : matrix_(other.matrix_)
-            , cur_col_(other.cur_col_)
-            , offset_(other.offset_)
-        { }
+    struct tile_iterator_base
+    {
+        typedef tile_t  value_type;
+        typedef tile_t  reference;
+        typedef tile_t* pointer;
 
-        // Copy and conversion assignment operator.
-        template <typename U>
-        col_t_iterator_base& operator=(const col_t_iterator_base<U>& other)
-        {
-            matrix_ = other.matrix_;
-            cur_col_ = other.cur_col_;
-            offset_ = other.offset_;
+        typedef tiles_t_base<tiles_element_base> grid_type;
+    };
 
-            return *this;
-        }
+    struct const_tile_iterator_base
+    {
+        typedef ctile_t  value_type;
+        typedef ctile_t  reference;
+        typedef ctile_t* pointer;
 
-        bool operator==(const col_t_iterator_base& other) const
-        {
-            return matrix_ == other.matrix_
-                && cur_col_ == other.cur_col_
-                && offset_ == other.offset_;
-        }
+        typedef tiles_t_base<const_tiles_element_base> grid_type;
+    };
 
-        bool operator!=(const col_t_iterator_base& other) const
-        {
-            return !(*this == other);
-        }
+public:
+    typedef tiles_t_iterator_base<tile_iterator_base>       tiles_t_iterator;
+    typedef tiles_t_iterator_base<const_tile_iterator_base> ctiles_t_iterator;
 
-        reference operator*() const
-        {
-            du_assert(matrix_ && offset_  >= 0 && offset_  < matrix_->rows_
-                              && cur_col_ >= 0 && cur_col_ < matrix_->cols_);
+private:
+    struct tiles_element_base : du1_detail::proxy_range
+    {
+        typedef tile_t   value_type;
+        typedef tile_t   reference;
+        typedef tile_t*  pointer;
+        typedef ctile_t  const_reference;
+        typedef ctile_t* const_pointer;
 
+        typedef tiles_t_iterator  iterator;
+        typedef ctiles_t_iterator const_iterator;
 
-            return matrix_->data_[cur_col_ + matrix_->cols_ * offset_];
-        }
+        typedef T* element_pointer;
+    };
 
-        pointer operator->() const
-        {
-            return &**this;
-        }
+    struct const_tiles_element_base : du1_detail::proxy_range
+    {
+        typedef ctile_t  value_type;
+        typedef ctile_t  reference;
+        typedef ctile_t* pointer;
+        typedef ctile_t  const_reference;
+        typedef ctile_t* const_pointer;
 
-        col_t_iterator_base& operator++()
-        {
-            du_assert(matrix_ && offset_  <= matrix_->rows_
-                              && cur_col_ >= 0 && cur_col_ < matrix_->cols_);
+        typedef ctiles_t_iterator iterator;
+        typedef ctiles_t_iterator const_iterator;
 
+        typedef const T* element_pointer;
+    };
 
-            ++offset_;
-            return *this;
-        }
+public:
+    typedef tiles_t_base<tiles_element_base>       tiles_t;
+    typedef tiles_t_base<const_tiles_element_base> ctiles_t;
 
-        col_t_iterator_base operator++(int)
-        {
-            col_t_iterator_base copy(*this);
-            ++*this;
-            return copy;
-        }
+    // Default tile extents. A tile row spans a few whole cache lines and
+    // a tile is sized to occupy about half of a typical 32 KiB L1 cache.
+    static constexpr size_type cache_line_size = 64;
 
-    private:
-        col_t_iterator_base(matrix_pointer matrix, difference_type cur_col, difference_type offset)
-            : matrix_(matrix)
-            , cur_col_(cur_col)
-            , offset_(offset)
-        { }
+    static constexpr size_type default_tile_width =
+        (sizeof(T) < cache_line_size ? cache_line_size / sizeof(T) : 1) * 4;
 
-        matrix_pointer  matrix_;
-        difference_type cur_col_;
-        difference_type offset_;
-    };
+    static constexpr size_type default_tile_height =
+        16384 / (default_tile_width * sizeof(T)) > 0
+            ? 16384 / (default_tile_width * sizeof(T))
+            : 1;
 
+    // Row and column proxies and iterator helper class templates.
     template <typename Base>
-    class row_t_iterator_base : public Base
+    class line_t_iterator_base : public Base
     {
-        friend row_t;
-        friend crow_t;
+        template <typename>
+        friend class line_t_base;
 
         // Friend declaration to allow conversion operations.
         template <typename>
-        friend class row_t_iterator_base;
-
-        using typename Base::matrix_pointer;
+        friend class line_t_iterator_base;
 
     public:
         using typename Base::value_type;
         using typename Base::reference;
         using typename Base::pointer;
 
-        typedef std::ptrdiff_t            difference_type;
-        typedef std::forward_iterator_tag iterator_category;
+        typedef std::ptrdiff_t                  difference_type;
+        typedef std::random_access_iterator_tag iterator_category;
 
-        row_t_iterator_base()
-            : matrix_(nullptr)
-            , cur_row_()
-            , offset_()
+        constexpr line_t_iterator_base()
+            : ptr_(nullptr)
+            , stride_(1)
+            , first_(nullptr)
+            , size_()
+            , probe_()
         { }
 
         // Copy and conversion constructor.
         template <typename U>
-        row_t_iterator_base(const row_t_iterator_base<U>& other)
-            : matrix_(other.matrix_)
-            , cur_row_(other.cur_row_)
-            , offset_(other.offset_)
+        constexpr line_t_iterator_base(const line_t_iterator_base<U>& other)
+            : ptr_(other.ptr_)
+            , stride_(other.stride_)
+            , first_(other.first_)
+            , size_(other.size_)
+            , probe_(other.probe_)
         { }
 
         // Copy and conversion assignment operator.
         template <typename U>
-        row_t_iterator_base& operator=(const row_t_iterator_base<U>& other)
+        constexpr line_t_iterator_base& operator=(const line_t_iterator_base<U>& other)
         {
-            matrix_ = other.matrix_;
-            cur_row_ = other.cur_row_;
-            offset_ = other.offset_;
+            ptr_ = other.ptr_;
+            stride_ = other.stride_;
+            first_ = other.first_;
+            size_ = other.size_;
+            probe_ = other.probe_;
 
             return *this;
         }
 
-        bool operator==(const row_t_iterator_base& other) const
+        constexpr bool operator==(const line_t_iterator_base& other) const
         {
-            return matrix_ == other.matrix_
-                && cur_row_ == other.cur_row_
-                && offset_ == other.offset_;
+            return ptr_ == other.ptr_;
         }
 
-        bool operator!=(const row_t_iterator_base& other) const
+        constexpr bool operator!=(const line_t_iterator_base& other) const
         {
             return !(*this == other);
         }
 
-        reference operator*() const
+        constexpr bool operator<(const line_t_iterator_base& other) const
         {
-            du_assert(matrix_ && offset_  >= 0 && offset_  < matrix_->cols_
-                              && cur_row_ >= 0 && cur_row_ < matrix_->rows_);
+            du_check(Check::iterators, first_ == other.first_);
 
-            return matrix_->data_[cur_row_ * matrix_->cols_ + offset_];
+            return ptr_ < other.ptr_;
         }
 
-        pointer operator->() const
+        constexpr bool operator>(const line_t_iterator_base& other) const
+        {
+            return other < *this;
+        }
+
+        constexpr bool operator<=(const line_t_iterator_base& other) const
+        {
+            return !(other < *this);
+        }
+
+        constexpr bool operator>=(const line_t_iterator_base& other) const
+        {
+            return !(*this < other);
+        }
+
+        constexpr reference operator*() const
+        {
+            du_check(Check::iterators, ptr_ && position() < size_);
+
+            probe_.access(stride_ * static_cast<difference_type>(sizeof(value_type)));
+            return *ptr_;
+        }
+
+        constexpr pointer operator->() const
         {
             return &**this;
         }
 
-        row_t_iterator_base& operator++()
+        constexpr reference operator[](difference_type n) const
+        {
+            return *(*this + n);
+        }
+
+        constexpr line_t_iterator_base& operator++()
         {
-            du_assert(matrix_ && offset_  <= matrix_->cols_
-                              && cur_row_ >= 0 && cur_row_ < matrix_->rows_);
+            du_check(Check::iterators, ptr_ && position() < size_);
 
-            ++offset_;
+            ptr_ += stride_;
             return *this;
         }
 
-        row_t_iterator_base operator++(int)
+        constexpr line_t_iterator_base operator++(int)
         {
-            row_t_iterator_base copy(*this);
+            line_t_iterator_base copy(*this);
             ++*this;
             return copy;
         }
 
-    private:
-        row_t_iterator_base(matrix_pointer matrix, difference_type cur_row, difference_type offset)
-            : matrix_(matrix)
-            , cur_row_(cur_row)
-            , offset_(offset)
-        { }
+        constexpr line_t_iterator_base& operator--()
+        {
+            du_check(Check::iterators, ptr_ && ptr_ != first_);
 
-        matrix_pointer  matrix_;
-        difference_type cur_row_;
-        difference_type offset_;
-    };
-
-    template <typename Base>
-    class col_t_base : public Base
-    {
-        friend cols_t;
-        friend cols_t_iterator;
-
-        friend ccols_t;
-        friend ccols_t_iterator;
-
-        // Friend declaration to allow conversion operations.
-        template <typename>
-        friend class col_t_base;
-
-        using typename Base::matrix_pointer;
-
-    public:
-        using typename Base::value_type;
-        using typename Base::reference;
-        using typename Base::pointer;
-        using typename Base::const_reference;
-        using typename Base::const_pointer;
-
-        typedef std::ptrdiff_t difference_type;
-        typedef std::size_t    size_type;
-
-        using typename Base::iterator;
-        using typename Base::const_iterator;
+            ptr_ -= stride_;
+            return *this;
+        }
 
-        // Copy and conversion constructor.
-        template <typename U>
-        col_t_base(const col_t_base<U>& other)
-            : matrix_(other.matrix_)
-            , cur_col_(other.cur_col_)
-        { }
+        constexpr line_t_iterator_base operator--(int)
+        {
+            line_t_iterator_base copy(*this);
+            --*this;
+            return copy;
+        }
 
-        iterator begin() const
+        constexpr line_t_iterator_base& operator+=(difference_type n)
         {
-            return iterator(matrix_, cur_col_, 0);
+            du_check(Check::iterators, ptr_ && position() + n <= size_);
+
+            ptr_ += n * stride_;
+            return *this;
         }
 
-        const_iterator cbegin() const
+        constexpr line_t_iterator_base& operator-=(difference_type n)
         {
-            return const_iterator(matrix_, cur_col_, 0);
+            return *this += -n;
         }
 
-        iterator end() const
+        constexpr line_t_iterator_base operator+(difference_type n) const
         {
-            return iterator(matrix_, cur_col_, matrix_->rows_);
+            line_t_iterator_base copy(*this);
+            return copy += n;
         }
 
-        const_iterator cend() const
+        friend constexpr line_t_iterator_base operator+(difference_type n, const line_t_iterator_base& it)
         {
-            return const_iterator(matrix_, cur_col_, matrix_->rows_);
+            return it + n;
         }
 
-        size_type size() const
+        constexpr line_t_iterator_base operator-(difference_type n) const
         {
-            return matrix_->rows_;
+            line_t_iterator_base copy(*this);
+            return copy -= n;
         }
 
-        reference operator[](size_type n) const
+        constexpr difference_type operator-(const line_t_iterator_base& other) const
         {
-            du_assert(n < matrix_->rows_ && cur_col_ >= 0
-                                         && cur_col_ < matrix_->cols_);
+            du_check(Check::iterators, first_ == other.first_);
 
-            return matrix_->data_[cur_col_ + matrix_->cols_ * n];
+            return (ptr_ - other.ptr_) / stride_;
         }
 
     private:
-        col_t_base(matrix_pointer matrix, difference_type cur_col)
-            : matrix_(matrix)
-            , cur_col_(cur_col)
+        constexpr line_t_iterator_base(pointer first, size_type size, difference_type stride, size_type offset,
+                                       du1_profile::line_probe probe)
+            : ptr_(first + static_cast<difference_type>(offset) * stride)
+            , stride_(stride)
+            , first_(first)
+            , size_(size)
+            , probe_(probe)
         { }
 
-        col_t_base()
-            : matrix_(nullptr)
-            , cur_col_()
-        { }
+        // Offset of the current element, only used by debugging checks.
+        constexpr size_type position() const
+        {
+            return static_cast<size_type>((ptr_ - first_) / stride_);
+        }
 
-        matrix_pointer  matrix_;
-        difference_type cur_col_;
+        pointer         ptr_;
+        difference_type stride_;
+        pointer         first_;
+        size_type       size_;
+
+        // Counts the element accesses with DU1_PROFILE, empty otherwise.
+        [[no_unique_address]] du1_profile::line_probe probe_;
     };
 
     template <typename Base>
-    class row_t_base : public Base
+    class line_t_base : public Base
     {
-        friend rows_t;
-        friend rows_t_iterator;
+        template <typename>
+        friend class lines_t_base;
 
-        friend crows_t;
-        friend crows_t_iterator;
+        template <typename>
+        friend class lines_t_iterator_base;
 
         // Friend declaration to allow conversion operations.
         template <typename>
-        friend class row_t_base;
-
-        using typename Base::matrix_pointer;
+        friend class line_t_base;
 
     public:
         using typename Base::value_type;
@@ -734,426 +1265,1697 @@ public:
 
         typedef std::ptrdiff_t difference_type;
         typedef std::size_t    size_type;
+        typedef Check          check_type;
 
         using typename Base::iterator;
         using typename Base::const_iterator;
 
         // Copy and conversion constructor.
         template <typename U>
-        row_t_base(const row_t_base<U>& other)
-            : matrix_(other.matrix_)
-            , cur_row_(other.cur_row_)
+        constexpr line_t_base(const line_t_base<U>& other)
+            : first_(other.first_)
+            , size_(other.size_)
+            , stride_(other.stride_)
+            , probe_(other.probe_)
         { }
 
-        iterator begin() const
+        constexpr iterator begin() const
         {
-            return iterator(matrix_, cur_row_, 0);
+            return iterator(first_, size_, stride_, 0, probe_);
         }
 
-        const_iterator cbegin() const
+        constexpr const_iterator cbegin() const
         {
-            return const_iterator(matrix_, cur_row_, 0);
+            return const_iterator(first_, size_, stride_, 0, probe_);
         }
 
-        iterator end() const
+        constexpr iterator end() const
         {
-            return iterator(matrix_, cur_row_, matrix_->cols_);
+            return iterator(first_, size_, stride_, size_, probe_);
         }
 
-        const_iterator cend() const
+        constexpr const_iterator cend() const
         {
-            return const_iterator(matrix_, cur_row_, matrix_->cols_);
+            return const_iterator(first_, size_, stride_, size_, probe_);
         }
 
-        size_type size() const
+        constexpr size_type size() const
+        {
+            return size_;
+        }
+
+        // Raw access to the line. Consecutive elements are stride() elements
+        // apart.
+        constexpr pointer data() const
+        {
+            return first_;
+        }
+
+        constexpr difference_type stride() const
+        {
+            return stride_;
+        }
+
+        // Contiguous view of the line, only available when stride() is 1
+        // (rows in row_major, columns in column_major layout).
+        constexpr std::span<value_type> as_span() const
         {
-            return matrix_->cols_;
+            du_check(Check::indices, stride_ == 1 || size_ <= 1);
+
+            return std::span<value_type>(first_, size_);
         }
 
-        reference operator[](size_type n) const
+        constexpr reference operator[](size_type n) const
         {
-            du_assert(n < matrix_->cols_ && cur_row_ >= 0
-                                         && cur_row_ < matrix_->rows_);
+            du_check(Check::indices, n < size_);
 
-            return matrix_->data_[cur_row_ * matrix_->cols_ + n];
+            probe_.access(stride_ * static_cast<difference_type>(sizeof(value_type)));
+            return first_[static_cast<difference_type>(n) * stride_];
         }
 
     private:
-        row_t_base(matrix_pointer matrix, difference_type cur_row)
-            : matrix_(matrix)
-            , cur_row_(cur_row)
+        constexpr line_t_base(pointer first, size_type size, difference_type stride,
+                              du1_profile::line_probe probe = du1_profile::line_probe())
+            : first_(first)
+            , size_(size)
+            , stride_(stride)
+            , probe_(probe)
         { }
 
-        row_t_base()
-            : matrix_(nullptr)
-            , cur_row_()
+        constexpr line_t_base()
+            : first_(nullptr)
+            , size_()
+            , stride_(1)
+            , probe_()
         { }
 
-        matrix_pointer  matrix_;
-        difference_type cur_row_;
+        pointer         first_;
+        size_type       size_;
+        difference_type stride_;
+
+        // See du1profile.hpp.
+        [[no_unique_address]] du1_profile::line_probe probe_;
     };
 
     template <typename Base>
-    class cols_t_iterator_base : public Base
+    class lines_t_iterator_base : public Base
     {
-        friend cols_t;
-        friend ccols_t;
+        template <typename>
+        friend class lines_t_base;
 
         // Friend declaration to allow conversion operations.
         template <typename>
-        friend class cols_t_iterator_base;
+        friend class lines_t_iterator_base;
 
         using typename Base::line_type;
-        using typename Base::matrix_pointer;
+        using typename Base::element_pointer;
 
     public:
         using typename Base::value_type;
         using typename Base::reference;
         using typename Base::pointer;
 
-        typedef std::ptrdiff_t            difference_type;
-        typedef std::forward_iterator_tag iterator_category;
+        typedef std::ptrdiff_t                  difference_type;
+        typedef std::random_access_iterator_tag iterator_category;
 
-        cols_t_iterator_base() = default;
+        constexpr lines_t_iterator_base()
+            : it_()
+            , step_()
+            , index_()
+            , size_()
+        { }
 
         // Copy and conversion constructor.
         template <typename U>
-        cols_t_iterator_base(const cols_t_iterator_base<U>& other)
+        constexpr lines_t_iterator_base(const lines_t_iterator_base<U>& other)
             : it_(other.it_)
+            , step_(other.step_)
+            , index_(other.index_)
+            , size_(other.size_)
         { }
 
         // Copy and conversion assignment operator.
         template <typename U>
-        cols_t_iterator_base& operator=(const cols_t_iterator_base<U>& other)
+        constexpr lines_t_iterator_base& operator=(const lines_t_iterator_base<U>& other)
         {
             it_ = other.it_;
+            step_ = other.step_;
+            index_ = other.index_;
+            size_ = other.size_;
 
             return *this;
         }
 
-        bool operator==(const cols_t_iterator_base& other) const
+        constexpr bool operator==(const lines_t_iterator_base& other) const
         {
-            return it_.matrix_ == other.it_.matrix_
-                && it_.cur_col_ == other.it_.cur_col_;
+            return it_.first_ == other.it_.first_
+                && index_ == other.index_;
         }
 
-        bool operator!=(const cols_t_iterator_base& other) const
+        constexpr bool operator!=(const lines_t_iterator_base& other) const
         {
             return !(*this == other);
         }
 
-        reference operator*() const
+        constexpr bool operator<(const lines_t_iterator_base& other) const
+        {
+            return index_ < other.index_;
+        }
+
+        constexpr bool operator>(const lines_t_iterator_base& other) const
+        {
+            return other < *this;
+        }
+
+        constexpr bool operator<=(const lines_t_iterator_base& other) const
+        {
+            return !(other < *this);
+        }
+
+        constexpr bool operator>=(const lines_t_iterator_base& other) const
         {
-            du_assert(it_.matrix_ && it_.cur_col_ >= 0
-                                  && it_.cur_col_ < it_.matrix_->cols_);
+            return !(*this < other);
+        }
+
+        constexpr reference operator*() const
+        {
+            du_check(Check::iterators, it_.first_ && index_ >= 0
+                                           && static_cast<size_type>(index_) < size_);
 
+            it_.probe_.proxy();
             return it_;
         }
 
-        pointer operator->() const
+        // See 'Implementation details'.
+        constexpr pointer operator->() const
         {
-            return &**this;
+            du_check(Check::iterators, it_.first_ && index_ >= 0
+                                           && static_cast<size_type>(index_) < size_);
+
+            it_.probe_.proxy();
+            return const_cast<line_type*>(&it_);
+        }
+
+        // See 'Implementation details'.
+        constexpr value_type operator[](difference_type n) const
+        {
+            return *(*this + n);
         }
 
-        cols_t_iterator_base& operator++()
+        constexpr lines_t_iterator_base& operator++()
         {
-            du_assert(it_.matrix_ && it_.cur_col_ <= it_.matrix_->cols_);
+            du_check(Check::iterators, it_.first_ && static_cast<size_type>(index_) < size_);
 
-            ++it_.cur_col_;
+            ++index_;
+            it_.first_ += step_;
             return *this;
         }
 
-        cols_t_iterator_base operator++(int)
+        constexpr lines_t_iterator_base operator++(int)
         {
-            cols_t_iterator_base copy(*this);
+            lines_t_iterator_base copy(*this);
             ++*this;
             return copy;
         }
 
+        constexpr lines_t_iterator_base& operator--()
+        {
+            du_check(Check::iterators, it_.first_ && index_ > 0);
+
+            --index_;
+            it_.first_ -= step_;
+            return *this;
+        }
+
+        constexpr lines_t_iterator_base operator--(int)
+        {
+            lines_t_iterator_base copy(*this);
+            --*this;
+            return copy;
+        }
+
+        constexpr lines_t_iterator_base& operator+=(difference_type n)
+        {
+            du_check(Check::iterators, it_.first_ && index_ + n >= 0
+                                           && static_cast<size_type>(index_ + n) <= size_);
+
+            index_ += n;
+            it_.first_ += n * step_;
+            return *this;
+        }
+
+        constexpr lines_t_iterator_base& operator-=(difference_type n)
+        {
+            return *this += -n;
+        }
+
+        constexpr lines_t_iterator_base operator+(difference_type n) const
+        {
+            lines_t_iterator_base copy(*this);
+            return copy += n;
+        }
+
+        friend constexpr lines_t_iterator_base operator+(difference_type n, const lines_t_iterator_base& it)
+        {
+            return it + n;
+        }
+
+        constexpr lines_t_iterator_base operator-(difference_type n) const
+        {
+            lines_t_iterator_base copy(*this);
+            return copy -= n;
+        }
+
+        constexpr difference_type operator-(const lines_t_iterator_base& other) const
+        {
+            return index_ - other.index_;
+        }
 
     private:
-        cols_t_iterator_base(matrix_pointer matrix, difference_type offset)
-            : it_(matrix, offset)
+        constexpr lines_t_iterator_base(element_pointer first, size_type size, difference_type step,
+                                        size_type length, difference_type stride, size_type offset,
+                                        du1_profile::line_probe probe)
+            : it_(first + static_cast<difference_type>(offset) * step, length, stride, probe)
+            , step_(step)
+            , index_(offset)
+            , size_(size)
         { }
 
-        // See 'Implementation details'.
-        mutable line_type it_;
+        // The current line; see 'Implementation details'.
+        line_type       it_;
+        difference_type step_;
+        difference_type index_;
+        size_type       size_;
     };
 
     template <typename Base>
-    class rows_t_iterator_base : public Base
+    class lines_t_base : public Base
     {
-        friend rows_t;
-        friend crows_t;
+        friend self;
+
+        // Views and static matrices borrow the proxies of matrix<T>.
+        template <typename, typename>
+        friend class ::matrix_view;
+
+        template <typename, std::size_t, std::size_t, typename, typename>
+        friend class ::static_matrix;
+
+        template <typename>
+        friend class tile_t_base;
 
         // Friend declaration to allow conversion operations.
         template <typename>
-        friend class rows_t_iterator_base;
+        friend class lines_t_base;
 
-        using typename Base::line_type;
-        using typename Base::matrix_pointer;
+        using typename Base::element_pointer;
 
     public:
         using typename Base::value_type;
         using typename Base::reference;
         using typename Base::pointer;
+        using typename Base::const_reference;
+        using typename Base::const_pointer;
 
-        typedef std::ptrdiff_t            difference_type;
-        typedef std::forward_iterator_tag iterator_category;
+        typedef std::ptrdiff_t difference_type;
+        typedef std::size_t    size_type;
 
-        rows_t_iterator_base() = default;
+        using typename Base::iterator;
+        using typename Base::const_iterator;
 
         // Copy and conversion constructor.
         template <typename U>
-        rows_t_iterator_base(const rows_t_iterator_base<U>& other)
-            : it_(other.it_)
+        constexpr lines_t_base(const lines_t_base<U>& other)
+            : first_(other.first_)
+            , size_(other.size_)
+            , step_(other.step_)
+            , length_(other.length_)
+            , stride_(other.stride_)
+            , probe_(other.probe_)
         { }
 
-        // Copy and conversion assignment operator.
-        template <typename U>
-        rows_t_iterator_base& operator=(const rows_t_iterator_base<U>& other)
+        constexpr iterator begin() const
         {
-            it_ = other.it_;
-
-            return *this;
+            return iterator(first_, size_, step_, length_, stride_, 0, probe_);
         }
 
-        bool operator==(const rows_t_iterator_base& other) const
+        constexpr const_iterator cbegin() const
         {
-            return it_.matrix_ == other.it_.matrix_
-                && it_.cur_row_ == other.it_.cur_row_;
+            return const_iterator(first_, size_, step_, length_, stride_, 0, probe_);
         }
 
-        bool operator!=(const rows_t_iterator_base& other) const
+        constexpr iterator end() const
         {
-            return !(*this == other);
+            return iterator(first_, size_, step_, length_, stride_, size_, probe_);
         }
 
-        reference operator*() const
+        constexpr const_iterator cend() const
         {
-            du_assert(it_.matrix_ && it_.cur_row_ >= 0
-                                  && it_.cur_row_ < it_.matrix_->rows_);
-
-            return it_;
+            return const_iterator(first_, size_, step_, length_, stride_, size_, probe_);
         }
 
-        pointer operator->() const
+        constexpr size_type size() const
         {
-            return &**this;
+            return size_;
         }
 
-        rows_t_iterator_base& operator++()
+        constexpr value_type operator[](size_type n) const
         {
-            du_assert(it_.matrix_ && it_.cur_row_ <= it_.matrix_->rows_);
+            du_check(Check::indices, n < size_);
 
-            ++it_.cur_row_;
-            return *this;
-        }
-
-        rows_t_iterator_base operator++(int)
-        {
-            rows_t_iterator_base copy(*this);
-            ++*this;
-            return copy;
+            probe_.proxy();
+            return value_type(first_ + static_cast<difference_type>(n) * step_, length_, stride_, probe_);
         }
 
-
     private:
-        rows_t_iterator_base(matrix_pointer matrix, difference_type offset)
-            : it_(matrix, offset)
+        constexpr lines_t_base(element_pointer first, size_type size, difference_type step,
+                               size_type length, difference_type stride,
+                               du1_profile::line_probe probe = du1_profile::line_probe())
+            : first_(first)
+            , size_(size)
+            , step_(step)
+            , length_(length)
+            , stride_(stride)
+            , probe_(probe)
         { }
 
-        // See 'Implementation details'.
-        mutable line_type it_;
+        element_pointer first_;
+        size_type       size_;
+        difference_type step_;
+        size_type       length_;
+        difference_type stride_;
+
+        // See du1profile.hpp; counts into the rows or the columns of the
+        // matrix.
+        [[no_unique_address]] du1_profile::line_probe probe_;
     };
 
     template <typename Base>
-    class cols_t_base : public Base
+    class tile_t_base : public Base
     {
-        friend self;
+        template <typename>
+        friend class tiles_t_base;
+
+        template <typename>
+        friend class tiles_t_iterator_base;
 
         // Friend declaration to allow conversion operations.
         template <typename>
-        friend class cols_t_base;
+        friend class tile_t_base;
 
-        using typename Base::matrix_pointer;
+        using typename Base::element_pointer;
 
     public:
-        using typename Base::value_type;
-        using typename Base::reference;
-        using typename Base::pointer;
-        using typename Base::const_reference;
-        using typename Base::const_pointer;
+        using typename Base::rows_type;
+        using typename Base::cols_type;
+        using typename Base::line_type;
 
         typedef std::ptrdiff_t difference_type;
         typedef std::size_t    size_type;
-
-        using typename Base::iterator;
-        using typename Base::const_iterator;
+        typedef Check          check_type;
 
         // Copy and conversion constructor.
         template <typename U>
-        cols_t_base(const cols_t_base<U>& other)
-            : matrix_(other.matrix_)
+        tile_t_base(const tile_t_base<U>& other)
+            : first_(other.first_)
+            , height_(other.height_)
+            , width_(other.width_)
+            , row_step_(other.row_step_)
+            , col_step_(other.col_step_)
+            , row_(other.row_)
+            , col_(other.col_)
+            , probe_(other.probe_)
         { }
 
-        iterator begin() const
+        rows_type rows() const
         {
-            return iterator(matrix_, 0);
+            return rows_type(first_, height_, row_step_, width_, col_step_, probe_.rows());
         }
 
-        const_iterator cbegin() const
+        cols_type cols() const
         {
-            return const_iterator(matrix_, 0);
+            return cols_type(first_, width_, col_step_, height_, row_step_, probe_.cols());
         }
 
-        iterator end() const
+        line_type operator[](size_type n) const
         {
-            return iterator(matrix_, matrix_->cols_);
+            return rows()[n];
         }
 
-        const_iterator cend() const
+        size_type height() const
         {
-            return const_iterator(matrix_, matrix_->cols_);
+            return height_;
         }
 
-        size_type size() const
+        size_type width() const
         {
-            return matrix_->cols_;
+            return width_;
         }
 
-        value_type operator[](size_type n) const
+        // Position of the top left element of the tile inside the matrix.
+        size_type first_row() const
+        {
+            return row_;
+        }
+
+        size_type first_col() const
+        {
+            return col_;
+        }
+
+        element_pointer data() const
+        {
+            return first_;
+        }
+
+        // Distance between vertically and horizontally adjacent elements.
+        difference_type row_step() const
         {
-            du_assert(n < matrix_->cols_);
+            return row_step_;
+        }
 
-            return value_type(matrix_, n);
+        difference_type col_step() const
+        {
+            return col_step_;
         }
 
     private:
-        cols_t_base(matrix_pointer matrix)
-            : matrix_(matrix)
+        tile_t_base(element_pointer first, size_type height, size_type width,
+                    difference_type row_step, difference_type col_step,
+                    size_type row, size_type col,
+                    du1_profile::matrix_probe probe = du1_profile::matrix_probe())
+            : first_(first)
+            , height_(height)
+            , width_(width)
+            , row_step_(row_step)
+            , col_step_(col_step)
+            , row_(row)
+            , col_(col)
+            , probe_(probe)
+        { }
+
+        tile_t_base()
+            : first_(nullptr)
+            , height_()
+            , width_()
+            , row_step_()
+            , col_step_()
+            , row_()
+            , col_()
+            , probe_()
         { }
 
-        matrix_pointer matrix_;
+        element_pointer first_;
+        size_type       height_;
+        size_type       width_;
+        difference_type row_step_;
+        difference_type col_step_;
+        size_type       row_;
+        size_type       col_;
+
+        // See du1profile.hpp.
+        [[no_unique_address]] du1_profile::matrix_probe probe_;
     };
 
     template <typename Base>
-    class rows_t_base : public Base
+    class tiles_t_iterator_base : public Base
     {
-        friend self;
+        template <typename>
+        friend class tiles_t_base;
 
         // Friend declaration to allow conversion operations.
         template <typename>
-        friend class rows_t_base;
+        friend class tiles_t_iterator_base;
 
-        using typename Base::matrix_pointer;
+        using typename Base::grid_type;
 
     public:
         using typename Base::value_type;
         using typename Base::reference;
         using typename Base::pointer;
-        using typename Base::const_reference;
-        using typename Base::const_pointer;
 
-        typedef std::ptrdiff_t difference_type;
-        typedef std::size_t    size_type;
+        typedef std::ptrdiff_t                  difference_type;
+        typedef std::random_access_iterator_tag iterator_category;
 
-        using typename Base::iterator;
-        using typename Base::const_iterator;
+        tiles_t_iterator_base()
+            : grid_()
+            , index_()
+            , tile_()
+        { }
 
         // Copy and conversion constructor.
         template <typename U>
-        rows_t_base(const rows_t_base<U>& other)
-            : matrix_(other.matrix_)
+        tiles_t_iterator_base(const tiles_t_iterator_base<U>& other)
+            : grid_(other.grid_)
+            , index_(other.index_)
+            , tile_(other.tile_)
         { }
 
-        iterator begin() const
+        // Copy and conversion assignment operator.
+        template <typename U>
+        tiles_t_iterator_base& operator=(const tiles_t_iterator_base<U>& other)
         {
-            return iterator(matrix_, 0);
+            grid_ = other.grid_;
+            index_ = other.index_;
+            tile_ = other.tile_;
+
+            return *this;
         }
 
-        const_iterator cbegin() const
+        bool operator==(const tiles_t_iterator_base& other) const
         {
-            return const_iterator(matrix_, 0);
+            return grid_.first_ == other.grid_.first_
+                && index_ == other.index_;
         }
 
-        iterator end() const
+        bool operator!=(const tiles_t_iterator_base& other) const
         {
-            return iterator(matrix_, matrix_->rows_);
+            return !(*this == other);
         }
 
-        const_iterator cend() const
+        bool operator<(const tiles_t_iterator_base& other) const
         {
-            return const_iterator(matrix_, matrix_->rows_);
+            return index_ < other.index_;
         }
 
-        size_type size() const
+        bool operator>(const tiles_t_iterator_base& other) const
         {
-            return matrix_->rows_;
+            return other < *this;
         }
 
-        value_type operator[](size_type n) const
+        bool operator<=(const tiles_t_iterator_base& other) const
         {
-            du_assert(n < matrix_->rows_);
+            return !(other < *this);
+        }
 
-            return value_type(matrix_, n);
+        bool operator>=(const tiles_t_iterator_base& other) const
+        {
+            return !(*this < other);
         }
 
-    private:
-        rows_t_base(matrix_pointer matrix)
-            : matrix_(matrix)
-        { }
+        // The tile is only materialized on dereference, moving the iterator
+        // is a plain index update.
+        reference operator*() const
+        {
+            du_check(Check::iterators, grid_.first_ && index_ >= 0
+                                             && static_cast<size_type>(index_) < grid_.size());
 
-        matrix_pointer matrix_;
-    };
+            return grid_[static_cast<size_type>(index_)];
+        }
 
-    // Column views.
-    cols_t cols()
-    {
-        return cols_t(this);
-    }
+        // See 'Implementation details'.
+        pointer operator->() const
+        {
+            tile_ = **this;
+            return &tile_;
+        }
 
-    ccols_t cols() const
-    {
-        return ccols_t(this);
-    }
+        // See 'Implementation details'.
+        value_type operator[](difference_type n) const
+        {
+            return *(*this + n);
+        }
 
-    ccols_t ccols() const
-    {
-        return cols();
-    }
+        tiles_t_iterator_base& operator++()
+        {
+            return *this += 1;
+        }
 
-    // Row views.
-    rows_t rows()
-    {
-        return rows_t(this);
-    }
+        tiles_t_iterator_base operator++(int)
+        {
+            tiles_t_iterator_base copy(*this);
+            ++*this;
+            return copy;
+        }
 
-    crows_t rows() const
-    {
-        return crows_t(this);
-    }
+        tiles_t_iterator_base& operator--()
+        {
+            return *this -= 1;
+        }
 
-    crows_t crows() const
-    {
-        return rows();
-    }
+        tiles_t_iterator_base operator--(int)
+        {
+            tiles_t_iterator_base copy(*this);
+            --*this;
+            return copy;
+        }
 
-    // Element access via proxy container.
-    row_t operator[](size_type n)
-    {
-        return rows()[n];
-    }
+        tiles_t_iterator_base& operator+=(difference_type n)
+        {
+            du_check(Check::iterators, grid_.first_ && index_ + n >= 0
+                                             && static_cast<size_type>(index_ + n) <= grid_.size());
 
-    crow_t operator[](size_type n) const
-    {
-        return rows()[n];
-    }
+            index_ += n;
+            return *this;
+        }
+
+        tiles_t_iterator_base& operator-=(difference_type n)
+        {
+            return *this += -n;
+        }
+
+        tiles_t_iterator_base operator+(difference_type n) const
+        {
+            tiles_t_iterator_base copy(*this);
+            return copy += n;
+        }
+
+        friend tiles_t_iterator_base operator+(difference_type n, const tiles_t_iterator_base& it)
+        {
+            return it + n;
+        }
+
+        tiles_t_iterator_base operator-(difference_type n) const
+        {
+            tiles_t_iterator_base copy(*this);
+            return copy -= n;
+        }
+
+        difference_type operator-(const tiles_t_iterator_base& other) const
+        {
+            return index_ - other.index_;
+        }
+
+    private:
+        tiles_t_iterator_base(const grid_type& grid, size_type offset)
+            : grid_(grid)
+            , index_(offset)
+            , tile_()
+        { }
+
+        grid_type       grid_;
+        difference_type index_;
+
+        // See 'Implementation details'.
+        mutable value_type tile_;
+    };
+
+    template <typename Base>
+    class tiles_t_base : public Base
+    {
+        friend self;
+
+        // Views borrow the proxies of matrix<T>.
+        template <typename, typename>
+        friend class ::matrix_view;
+
+        template <typename>
+        friend class tiles_t_iterator_base;
+
+        // Friend declaration to allow conversion operations.
+        template <typename>
+        friend class tiles_t_base;
+
+        using typename Base::element_pointer;
+
+    public:
+        using typename Base::value_type;
+        using typename Base::reference;
+        using typename Base::pointer;
+        using typename Base::const_reference;
+        using typename Base::const_pointer;
+
+        typedef std::ptrdiff_t difference_type;
+        typedef std::size_t    size_type;
+
+        using typename Base::iterator;
+        using typename Base::const_iterator;
+
+        // Copy and conversion constructor.
+        template <typename U>
+        tiles_t_base(const tiles_t_base<U>& other)
+            : first_(other.first_)
+            , rows_(other.rows_)
+            , cols_(other.cols_)
+            , row_step_(other.row_step_)
+            , col_step_(other.col_step_)
+            , height_(other.height_)
+            , width_(other.width_)
+            , probe_(other.probe_)
+        { }
+
+        iterator begin() const
+        {
+            return iterator(*this, 0);
+        }
+
+        const_iterator cbegin() const
+        {
+            return const_iterator(*this, 0);
+        }
+
+        iterator end() const
+        {
+            return iterator(*this, size());
+        }
+
+        const_iterator cend() const
+        {
+            return const_iterator(*this, size());
+        }
+
+        // Number of tiles in the vertical and horizontal direction.
+        size_type tile_rows() const
+        {
+            return (rows_ + height_ - 1) / height_;
+        }
+
+        size_type tile_cols() const
+        {
+            return (cols_ + width_ - 1) / width_;
+        }
+
+        size_type size() const
+        {
+            return tile_rows() * tile_cols();
+        }
+
+        // Tiles are numbered row by row. Tiles along the bottom and right
+        // edges are clipped to the matrix.
+        value_type operator[](size_type n) const
+        {
+            du_check(Check::indices, n < size());
+
+            size_type row = n / tile_cols() * height_;
+            size_type col = n % tile_cols() * width_;
+
+            probe_.tile();
+            return value_type(first_ + static_cast<difference_type>(row) * row_step_
+                                     + static_cast<difference_type>(col) * col_step_,
+                              std::min(height_, rows_ - row),
+                              std::min(width_, cols_ - col),
+                              row_step_, col_step_, row, col, probe_);
+        }
+
+    private:
+        tiles_t_base(element_pointer first, size_type rows, size_type cols,
+                     difference_type row_step, difference_type col_step,
+                     size_type height, size_type width,
+                     du1_profile::matrix_probe probe = du1_profile::matrix_probe())
+            : first_(first)
+            , rows_(rows)
+            , cols_(cols)
+            , row_step_(row_step)
+            , col_step_(col_step)
+            , height_(height)
+            , width_(width)
+            , probe_(probe)
+        {
+            du_check(Check::indices, height > 0 && width > 0);
+        }
+
+        tiles_t_base()
+            : first_(nullptr)
+            , rows_()
+            , cols_()
+            , row_step_()
+            , col_step_()
+            , height_(1)
+            , width_(1)
+            , probe_()
+        { }
+
+        element_pointer first_;
+        size_type       rows_;
+        size_type       cols_;
+        difference_type row_step_;
+        difference_type col_step_;
+        size_type       height_;
+        size_type       width_;
+
+        // See du1profile.hpp.
+        [[no_unique_address]] du1_profile::matrix_probe probe_;
+    };
+
+    // Column views.
+    cols_t cols()
+    {
+        return cols_t(data_.data(), cols_, col_step(), rows_, row_step(), profile_.probe().cols());
+    }
+
+    ccols_t cols() const
+    {
+        return ccols_t(data_.data(), cols_, col_step(), rows_, row_step(), profile_.probe().cols());
+    }
+
+    ccols_t ccols() const
+    {
+        return cols();
+    }
+
+    // Row views.
+    rows_t rows()
+    {
+        return rows_t(data_.data(), rows_, row_step(), cols_, col_step(), profile_.probe().rows());
+    }
+
+    crows_t rows() const
+    {
+        return crows_t(data_.data(), rows_, row_step(), cols_, col_step(), profile_.probe().rows());
+    }
+
+    crows_t crows() const
+    {
+        return rows();
+    }
+
+    // Tile views. The matrix is split into blocks of height * width elements
+    // (smaller at the edges), each of which offers its own rows() and cols().
+    tiles_t tiles(size_type height = default_tile_height,
+                  size_type width = default_tile_width)
+    {
+        return tiles_t(data_.data(), rows_, cols_, row_step(), col_step(), height, width,
+                       profile_.probe());
+    }
+
+    ctiles_t tiles(size_type height = default_tile_height,
+                   size_type width = default_tile_width) const
+    {
+        return ctiles_t(data_.data(), rows_, cols_, row_step(), col_step(), height, width,
+                        profile_.probe());
+    }
+
+    ctiles_t ctiles(size_type height = default_tile_height,
+                    size_type width = default_tile_width) const
+    {
+        return tiles(height, width);
+    }
+
+    // Element access via proxy container.
+    row_t operator[](size_type n)
+    {
+        return rows()[n];
+    }
+
+    crow_t operator[](size_type n) const
+    {
+        return rows()[n];
+    }
+
+    // Raw access to the storage. Element (i, j) is located at
+    // data()[i * row_step() + j * col_step()], leading_dimension() being the
+    // larger of the two steps (including padding, if any).
+    pointer data()
+    {
+        return data_.data();
+    }
+
+    const_pointer data() const
+    {
+        return data_.data();
+    }
+
+    size_type leading_dimension() const
+    {
+        return ld_;
+    }
+
+    bool padded() const
+    {
+        return ld_ != Layout::leading_dimension(rows_, cols_);
+    }
+
+    difference_type row_step() const
+    {
+        return Layout::row_step(leading_dimension());
+    }
+
+    difference_type col_step() const
+    {
+        return Layout::col_step(leading_dimension());
+    }
+
+    // Views, see matrix_view. Nothing is copied.
+    matrix_view<T, Check> block(size_type row, size_type col, size_type height, size_type width)
+    {
+        return matrix_view<T, Check>(*this).block(row, col, height, width);
+    }
+
+    matrix_view<const T, Check> block(size_type row, size_type col, size_type height, size_type width) const
+    {
+        return matrix_view<const T, Check>(*this).block(row, col, height, width);
+    }
+
+    matrix_view<T, Check> transposed()
+    {
+        return matrix_view<T, Check>(*this).transposed();
+    }
+
+    matrix_view<const T, Check> transposed() const
+    {
+        return matrix_view<const T, Check>(*this).transposed();
+    }
+
+    matrix_view<T, Check> every(size_type row_stride, size_type col_stride)
+    {
+        return matrix_view<T, Check>(*this).every(row_stride, col_stride);
+    }
+
+    matrix_view<const T, Check> every(size_type row_stride, size_type col_stride) const
+    {
+        return matrix_view<const T, Check>(*this).every(row_stride, col_stride);
+    }
+
+    matrix_view<T, Check> diagonal()
+    {
+        return matrix_view<T, Check>(*this).diagonal();
+    }
+
+    matrix_view<const T, Check> diagonal() const
+    {
+        return matrix_view<const T, Check>(*this).diagonal();
+    }
+
+    // Physical transposition. Both versions keep the storage layout, so
+    // a row_major matrix stays row_major. A padded matrix gets automatic
+    // padding for its new shape; transposing it in place then needs
+    // a temporary copy.
+    self transpose() const
+    {
+        self result(get_allocator());
+        result.rows_ = cols_;
+        result.cols_ = rows_;
+        result.ld_ = padded() ? padded_leading_dimension(cols_, rows_, padding::automatic())
+                              : Layout::leading_dimension(cols_, rows_);
+        if (padded())
+            result.data_.resize(Layout::storage_size(cols_, rows_, result.ld_), T());
+        else
+            result.data_.resize(Layout::storage_size(cols_, rows_, result.ld_));
+
+        transpose_copy(data(), row_step(), col_step(),
+                       result.data(), result.row_step(), result.col_step(),
+                       rows_, cols_);
+        return result;
+    }
+
+    void transpose_inplace()
+    {
+        if (rows_ == cols_)
+        {
+            transpose_square(data(), row_step(), col_step(), rows_);
+        }
+        else if (padded())
+        {
+            *this = transpose();
+        }
+        else
+        {
+            if (ld_ > 0)
+                transpose_cycles(data(), data_.size() / ld_, ld_);
+
+            std::swap(rows_, cols_);
+            ld_ = Layout::leading_dimension(rows_, cols_);
+        }
+    }
+
+
+    // Growing and reshaping, see 'Growing and reshaping'.
+    size_type row_capacity() const
+    {
+        if constexpr (rows_are_lines)
+            return ld_ > 0 ? data_.capacity() / ld_ : rows_;
+        else
+            return ld_;
+    }
+
+    void reserve_rows(size_type n)
+    {
+        if (n <= row_capacity())
+            return;
+
+        if constexpr (rows_are_lines)
+        {
+            data_.reserve(n * ld_);
+        }
+        else
+        {
+            storage_type grown = relayout(n, cols_, cols_, value_type());
+            data_.swap(grown);
+            ld_ = n;
+        }
+    }
+
+    // The range must have cols() elements, unless the matrix is empty
+    // (0 * 0), in which case it decides the number of columns.
+    template <typename Range>
+    void append_row(const Range& range)
+    {
+        using std::begin;
+        using std::end;
+
+        auto first = begin(range);
+        auto last = end(range);
+        size_type n = static_cast<size_type>(std::distance(first, last));
+
+        if (rows_ == 0 && cols_ == 0)
+        {
+            cols_ = n;
+            ld_ = std::max(ld_, Layout::leading_dimension(0, n));
+            data_.resize(Layout::storage_size(0, n, ld_), value_type());
+        }
+
+        du_check(Check::indices, n == cols_);
+
+        // When the storage has to grow, the new row is written into the new
+        // storage before the old one is released, so that the range may
+        // refer to the matrix itself.
+        storage_type grown(data_.get_allocator());
+        storage_type* target = &data_;
+        size_type ld = ld_;
+
+        if (rows_ == row_capacity())
+        {
+            size_type capacity = std::max<size_type>(2 * rows_, 1);
+
+            if constexpr (rows_are_lines)
+                grown = relayout(ld, rows_, capacity, value_type());
+            else
+                grown = relayout(ld = capacity, cols_, cols_, value_type());
+
+            target = &grown;
+        }
+
+        if constexpr (rows_are_lines)
+        {
+            for (; first != last; ++first)
+                target->push_back(*first);
+            target->resize(target->size() + (ld - cols_), value_type());
+        }
+        else
+        {
+            for (size_type j = 0; first != last; ++first, ++j)
+                (*target)[j * ld + rows_] = *first;
+        }
+
+        if (target != &data_)
+            data_.swap(grown);
+
+        ld_ = ld;
+        ++rows_;
+    }
+
+    void append_row(std::initializer_list<value_type> values)
+    {
+        append_row<std::initializer_list<value_type> >(values);
+    }
+
+    template <typename L, typename A, typename C>
+    void append_rows(const matrix<T, L, A, C>& other)
+    {
+        size_type n = other.rows().size();
+        if (n == 0)
+            return;
+
+        if (rows_ + n > row_capacity())
+            reserve_rows(std::max(rows_ + n, 2 * rows_));
+
+        // Rows are fetched one at a time, other may be *this.
+        for (size_type i = 0; i < n; ++i)
+            append_row(other.rows()[i]);
+    }
+
+    // New elements are initialized with def. The leading dimension only
+    // changes when the new rows (columns for column_major) do not fit into
+    // it.
+    void resize(size_type rows, size_type cols, const value_type& def = value_type())
+    {
+        size_type lines = rows_are_lines ? rows : cols;
+        size_type old_lines = rows_are_lines ? rows_ : cols_;
+        size_type length = rows_are_lines ? cols : rows;
+        size_type old_length = rows_are_lines ? cols_ : rows_;
+
+        if (length <= ld_)
+        {
+            if (length > old_length)
+                for (size_type k = 0, end = std::min(lines, old_lines); k < end; ++k)
+                    std::fill_n(data_.begin() + k * ld_ + old_length, length - old_length, def);
+
+            data_.resize(lines * ld_, def);
+        }
+        else
+        {
+            size_type ld = padded() ? padded_leading_dimension(rows, cols, padding::automatic())
+                                    : Layout::leading_dimension(rows, cols);
+
+            storage_type grown = relayout(ld, lines, lines, def, length);
+            data_.swap(grown);
+            ld_ = ld;
+        }
+
+        rows_ = rows;
+        cols_ = cols;
+    }
+
+    // Zero-copy reinterpretation of an unpadded matrix.
+    void reshape(size_type rows, size_type cols)
+    {
+        du_check(Check::indices, rows * cols == rows_ * cols_ && !padded());
+
+        rows_ = rows;
+        cols_ = cols;
+        ld_ = Layout::leading_dimension(rows, cols);
+    }
+
+    // Access profile, see du1profile.hpp. Without DU1_PROFILE the report
+    // only says so.
+    du1_profile::report profile() const
+    {
+        return du1_profile::make_report<T>(profile_.get(), rows_are_lines, rows_, cols_);
+    }
+
+    void reset_profile()
+    {
+        profile_.reset();
+    }
 
 private:
-    std::vector<value_type> data_;
+    // Views count into the access counters of the matrix.
+    template <typename, typename>
+    friend class matrix_view;
+
+    typedef std::vector<value_type, du1_detail::default_init_allocator<allocator_type> > storage_type;
+
+    // Whether the contiguous storage lines are rows (as opposed to columns).
+    static constexpr bool rows_are_lines = std::is_same<Layout, row_major>::value;
+
+    // Used by the generator constructor without a policy.
+    struct matrix_sequential
+    { };
+
+    // Fills the (empty) storage with the elements of other, which has the
+    // same shape, in storage order so that the writes are sequential.
+    template <typename M>
+    void copy_lines(const M& other)
+    {
+        data_.reserve(rows_ * cols_);
+
+        if (col_step() == 1)
+        {
+            for (auto row : other.rows())
+                data_.insert(data_.end(), row.begin(), row.end());
+        }
+        else
+        {
+            for (auto col : other.cols())
+                data_.insert(data_.end(), col.begin(), col.end());
+        }
+    }
+
+    // Calls f(first, last) for ranges of storage lines (rows or columns,
+    // whichever is contiguous), in parallel when the policy provides a pool.
+    template <typename Policy, typename F>
+    void for_storage_lines(const Policy& policy, F f)
+    {
+        size_type lines = ld_ > 0 ? data_.size() / ld_ : 0;
+
+        if constexpr (requires { policy.get_pool(); })
+        {
+            // Chunks start on page boundaries (of a page-aligned buffer).
+            size_type bytes = ld_ * sizeof(T);
+            size_type grain = bytes > 0 ? 4096 / std::gcd<size_type>(4096, bytes) : 1;
+
+            policy.get_pool().parallel_for(lines, grain, f);
+        }
+        else
+        {
+            (void)policy;
+            f(0, lines);
+        }
+    }
+
+    // Copies the storage into a new buffer with leading dimension ld and
+    // the given number of lines (room is reserved for capacity lines). Each
+    // line keeps up to length of its elements, everything else is def.
+    storage_type relayout(size_type ld, size_type lines, size_type capacity,
+                          const value_type& def, size_type length = size_type(-1)) const
+    {
+        size_type old_lines = rows_are_lines ? rows_ : cols_;
+        size_type keep = std::min({ length, ld, rows_are_lines ? cols_ : rows_ });
+
+        storage_type result(data_.get_allocator());
+        result.reserve(std::max(lines, capacity) * ld);
+
+        for (size_type k = 0; k < lines; ++k)
+        {
+            size_type n = 0;
+            if (k < old_lines)
+            {
+                n = keep;
+                result.insert(result.end(), data_.begin() + k * ld_, data_.begin() + k * ld_ + n);
+            }
+            result.resize(result.size() + (ld - n), def);
+        }
+
+        return result;
+    }
+
+    static size_type padded_leading_dimension(size_type rows, size_type cols, padding pad)
+    {
+        size_type ld = Layout::leading_dimension(rows, cols);
+
+        if (pad.leading_dimension != 0)
+        {
+            du_check(Check::indices, pad.leading_dimension >= ld);
+            return pad.leading_dimension;
+        }
+
+        // Number of elements that make up a whole number of cache lines.
+        size_type unit = cache_line_size / std::gcd(cache_line_size, sizeof(T));
+
+        ld = (ld + unit - 1) / unit * unit;
+        if (ld * sizeof(T) % 4096 == 0)
+            ld += unit;
+
+        return ld;
+    }
+
+    // Transposition helpers.
+    //
+    //   transpose_copy writes the transpose of a rows * cols block of src into
+    // dst, i.e. dst(j, i) = src(i, j), where (i, j) of a block is found at
+    // i * row step + j * col step. The block is split recursively along its
+    // larger side until it fits into transpose_block elements on each side,
+    // which keeps both the reads and the strided writes inside L1 regardless
+    // of the cache size (a cache-oblivious scheme).
+    //
+    //   The leaf kernel handles register tiles with SSE2 shuffles when both
+    // src and dst have unit col steps and T is a 4 or 8 byte arithmetic type.
+    static constexpr size_type transpose_block = 32;
+
+    static void transpose_copy(const T* src, difference_type srs, difference_type scs,
+                               T* dst, difference_type drs, difference_type dcs,
+                               size_type rows, size_type cols)
+    {
+        // Transposing with unit row steps is the same problem as transposing
+        // the mirrored block with unit col steps.
+        if (srs == 1 && drs == 1 && scs != 1)
+        {
+            std::swap(srs, scs);
+            std::swap(drs, dcs);
+            std::swap(rows, cols);
+        }
+
+        if (rows > transpose_block && rows >= cols)
+        {
+            size_type half = rows / 2;
+            transpose_copy(src, srs, scs, dst, drs, dcs, half, cols);
+            transpose_copy(src + static_cast<difference_type>(half) * srs, srs, scs,
+                           dst + static_cast<difference_type>(half) * dcs, drs, dcs,
+                           rows - half, cols);
+        }
+        else if (cols > transpose_block)
+        {
+            size_type half = cols / 2;
+            transpose_copy(src, srs, scs, dst, drs, dcs, rows, half);
+            transpose_copy(src + static_cast<difference_type>(half) * scs, srs, scs,
+                           dst + static_cast<difference_type>(half) * drs, drs, dcs,
+                           rows, cols - half);
+        }
+        else
+        {
+            transpose_kernel(src, srs, scs, dst, drs, dcs, rows, cols);
+        }
+    }
+
+    static void transpose_kernel(const T* src, difference_type srs, difference_type scs,
+                                 T* dst, difference_type drs, difference_type dcs,
+                                 size_type rows, size_type cols)
+    {
+        size_type i0 = 0;
+        size_type j0 = 0;
+
+#if defined(__SSE2__)
+        if constexpr (std::is_arithmetic<T>::value && (sizeof(T) == 4 || sizeof(T) == 8))
+        {
+            constexpr size_type n = 16 / sizeof(T);
+
+            if (scs == 1 && dcs == 1)
+            {
+                i0 = rows - rows % n;
+                j0 = cols - cols % n;
+
+                for (size_type i = 0; i < i0; i += n)
+                    for (size_type j = 0; j < j0; j += n)
+                        transpose_simd(src + static_cast<difference_type>(i) * srs
+                                           + static_cast<difference_type>(j), srs,
+                                       dst + static_cast<difference_type>(j) * drs
+                                           + static_cast<difference_type>(i), drs);
+            }
+        }
+#endif
+
+        // Scalar remainder: the right strip of every row, then the bottom
+        // strip (or everything when no SIMD tile was used).
+        for (size_type i = 0; i < rows; ++i)
+            for (size_type j = i < i0 ? j0 : 0; j < cols; ++j)
+                dst[static_cast<difference_type>(j) * drs + static_cast<difference_type>(i) * dcs] =
+                    src[static_cast<difference_type>(i) * srs + static_cast<difference_type>(j) * scs];
+    }
+
+#if defined(__SSE2__)
+    // Transposes a single 16-byte register tile (4x4 or 2x2 elements) between
+    // two blocks with unit col steps. Only the bit patterns are moved.
+    static void transpose_simd(const T* src, difference_type srs, T* dst, difference_type drs)
+    {
+        if constexpr (sizeof(T) == 4)
+        {
+            __m128 r0 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+            __m128 r1 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + srs)));
+            __m128 r2 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * srs)));
+            __m128 r3 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * srs)));
+
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_castps_si128(r0));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + drs), _mm_castps_si128(r1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * drs), _mm_castps_si128(r2));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 3 * drs), _mm_castps_si128(r3));
+        }
+        else
+        {
+            __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+            __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + srs));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi64(r0, r1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + drs), _mm_unpackhi_epi64(r0, r1));
+        }
+    }
+#endif
+
+    // In-place transposition of a square matrix, block by block. Diagonal
+    // blocks are transposed by swapping within themselves, every other block
+    // is swapped with its mirror image.
+    static void transpose_square(T* data, difference_type rs, difference_type cs, size_type n)
+    {
+        using std::swap;
+
+        for (size_type bi = 0; bi < n; bi += transpose_block)
+        {
+            size_type ei = std::min(n, bi + transpose_block);
+
+            for (size_type bj = bi; bj < n; bj += transpose_block)
+            {
+                size_type ej = std::min(n, bj + transpose_block);
+
+                for (size_type i = bi; i < ei; ++i)
+                    for (size_type j = bi == bj ? i + 1 : bj; j < ej; ++j)
+                        swap(data[static_cast<difference_type>(i) * rs + static_cast<difference_type>(j) * cs],
+                             data[static_cast<difference_type>(j) * rs + static_cast<difference_type>(i) * cs]);
+            }
+        }
+    }
+
+    // In-place transposition of a non-square outer * inner array by
+    // following the cycles of the permutation k -> k * outer mod (N - 1).
+    // Only a bit per element is needed to remember the visited positions.
+    static void transpose_cycles(T* data, size_type outer, size_type inner)
+    {
+        size_type n = outer * inner;
+        if (n < 3)
+            return;
+
+        std::vector<bool> visited(n);
+
+        // Below 2^32 elements, k * outer cannot overflow.
+        bool wide = n - 1 > 0xffffffffu;
+
+        for (size_type start = 1; start < n - 1; ++start)
+        {
+            if (visited[start])
+                continue;
+
+            T carried = std::move(data[start]);
+            size_type k = start;
+
+            do
+            {
+                size_type next = wide ? du1_detail::mul_mod(k, outer, n - 1) : k * outer % (n - 1);
+
+                using std::swap;
+                swap(carried, data[next]);
+                visited[next] = true;
+                k = next;
+            }
+            while (k != start);
+        }
+    }
+
+    storage_type data_;
     size_type rows_;
     size_type cols_;
+    size_type ld_;
+
+    // Access counters, see du1profile.hpp; empty without DU1_PROFILE.
+    [[no_unique_address]] du1_profile::holder profile_;
+};
+
+//   matrix_view class template
+//   ==========================
+//
+//   A non-owning view of a two dimensional block of elements, described by
+// a pointer to the top left element, the extents and the distances between
+// vertically and horizontally adjacent elements. matrix_view<T> allows
+// modification of the elements, matrix_view<const T> does not; a matrix
+// converts to either implicitly, and a view to its const variant.
+//
+//   Views are created by:
+//
+//   block(row, col, height, width) - a height * width submatrix
+//   transposed()                   - the transposition, steps swapped
+//   every(row_stride, col_stride)  - every row_stride-th row and
+//                                    col_stride-th column
+//   diagonal()                     - the main diagonal as a single column
+//
+// all of which are available on matrices and on views, so views of views
+// compose (m.block(...).transposed().every(2, 1) is still a pointer and two
+// steps). A view offers the same rows(), cols(), tiles() and operator[] as
+// a matrix, together with data(), row_step() and col_step(), so the
+// algorithms of du1parallel.hpp, du1expr.hpp and du1multiply.hpp accept it
+// in place of a matrix. matrix(view) makes an owning copy.
+//
+//   The view does not keep the matrix alive and is invalidated by anything
+// that reallocates its storage. Like std::span, a view is shallow const: the
+// constness of the view itself does not restrict access to the elements.
+//
+//   Implementation details
+//   ----------------------
+//
+//   The proxies only depend on the element type and the check policy, so
+// the view reuses the proxy types of matrix<T, row_major, std::allocator<T>,
+// Check> (the non-const or const variants, depending on the constness of T)
+// no matter which layout or allocator the viewed matrix has.
+//
+template <typename T, typename Check>
+class matrix_view
+{
+    // Friend declaration to allow conversion operations.
+    template <typename, typename>
+    friend class matrix_view;
+
+    typedef typename std::remove_const<T>::type element_type;
+
+    typedef matrix<element_type, row_major, std::allocator<element_type>, Check> owner;
+
+    static constexpr bool is_const = std::is_const<T>::value;
+
+    template <typename Mutable, typename Const>
+    using select = typename std::conditional<is_const, Const, Mutable>::type;
+
+public:
+    typedef typename std::remove_const<T>::type value_type;
+    typedef T&                                  reference;
+    typedef T*                                  pointer;
+    typedef const value_type&                   const_reference;
+    typedef const value_type*                   const_pointer;
+    typedef std::ptrdiff_t                      difference_type;
+    typedef std::size_t                         size_type;
+    typedef Check                               check_type;
+
+    typedef select<typename owner::col_t,   typename owner::ccol_t>   col_t;
+    typedef select<typename owner::row_t,   typename owner::crow_t>   row_t;
+    typedef select<typename owner::cols_t,  typename owner::ccols_t>  cols_t;
+    typedef select<typename owner::rows_t,  typename owner::crows_t>  rows_t;
+    typedef select<typename owner::tile_t,  typename owner::ctile_t>  tile_t;
+    typedef select<typename owner::tiles_t, typename owner::ctiles_t> tiles_t;
+
+    typedef typename owner::ccol_t   ccol_t;
+    typedef typename owner::crow_t   crow_t;
+    typedef typename owner::ccols_t  ccols_t;
+    typedef typename owner::crows_t  crows_t;
+    typedef typename owner::ctile_t  ctile_t;
+    typedef typename owner::ctiles_t ctiles_t;
+
+    static constexpr size_type default_tile_width = owner::default_tile_width;
+    static constexpr size_type default_tile_height = owner::default_tile_height;
+
+    // Constructors.
+    matrix_view()
+        : first_(nullptr)
+        , height_()
+        , width_()
+        , row_step_()
+        , col_step_()
+        , probe_()
+    { }
+
+    // Element (i, j) is first[i * row_step + j * col_step]. Both steps must
+    // be positive, except that row_step may be 0 when there are no columns
+    // and col_step may be 0 when there are no rows (as with the leading
+    // dimension of an empty matrix).
+    matrix_view(pointer first, size_type height, size_type width,
+                difference_type row_step, difference_type col_step)
+        : first_(first)
+        , height_(height)
+        , width_(width)
+        , row_step_(row_step)
+        , col_step_(col_step)
+        , probe_()
+    {
+        du_check(Check::indices, (row_step > 0 || (row_step == 0 && width == 0))
+                              && (col_step > 0 || (col_step == 0 && height == 0)));
+    }
+
+    template <typename Layout, typename Alloc, typename MatrixCheck>
+    matrix_view(matrix<value_type, Layout, Alloc, MatrixCheck>& m)
+        : matrix_view(m.data(), m.rows().size(), m.cols().size(), m.row_step(), m.col_step(),
+                      m.profile_.probe())
+    { }
+
+    template <typename Layout, typename Alloc, typename MatrixCheck, bool C = is_const,
+              typename = typename std::enable_if<C>::type>
+    matrix_view(const matrix<value_type, Layout, Alloc, MatrixCheck>& m)
+        : matrix_view(m.data(), m.rows().size(), m.cols().size(), m.row_step(), m.col_step(),
+                      m.profile_.probe())
+    { }
+
+    // Copy and conversion constructor, also between check policies.
+    template <typename U, typename OtherCheck,
+              typename = typename std::enable_if<std::is_convertible<U*, T*>::value>::type>
+    matrix_view(const matrix_view<U, OtherCheck>& other)
+        : first_(other.first_)
+        , height_(other.height_)
+        , width_(other.width_)
+        , row_step_(other.row_step_)
+        , col_step_(other.col_step_)
+        , probe_(other.probe_)
+    { }
+
+    // Column views.
+    cols_t cols() const
+    {
+        return cols_t(first_, width_, col_step_, height_, row_step_, probe_.cols());
+    }
+
+    ccols_t ccols() const
+    {
+        return cols();
+    }
+
+    // Row views.
+    rows_t rows() const
+    {
+        return rows_t(first_, height_, row_step_, width_, col_step_, probe_.rows());
+    }
+
+    crows_t crows() const
+    {
+        return rows();
+    }
+
+    // Tile views, see matrix::tiles().
+    tiles_t tiles(size_type height = default_tile_height,
+                  size_type width = default_tile_width) const
+    {
+        return tiles_t(first_, height_, width_, row_step_, col_step_, height, width, probe_);
+    }
+
+    ctiles_t ctiles(size_type height = default_tile_height,
+                    size_type width = default_tile_width) const
+    {
+        return tiles(height, width);
+    }
+
+    // Element access via proxy container.
+    row_t operator[](size_type n) const
+    {
+        return rows()[n];
+    }
+
+    // Raw access, see matrix::data().
+    pointer data() const
+    {
+        return first_;
+    }
+
+    size_type height() const
+    {
+        return height_;
+    }
+
+    size_type width() const
+    {
+        return width_;
+    }
+
+    difference_type row_step() const
+    {
+        return row_step_;
+    }
+
+    difference_type col_step() const
+    {
+        return col_step_;
+    }
+
+    // Derived views.
+    matrix_view block(size_type row, size_type col, size_type height, size_type width) const
+    {
+        du_check(Check::indices, row <= height_ && height <= height_ - row
+                                 && col <= width_ && width <= width_ - col);
+
+        return matrix_view(first_ + static_cast<difference_type>(row) * row_step_
+                                  + static_cast<difference_type>(col) * col_step_,
+                           height, width, row_step_, col_step_, probe_);
+    }
+
+    matrix_view transposed() const
+    {
+        return matrix_view(first_, width_, height_, col_step_, row_step_, probe_.transposed());
+    }
+
+    matrix_view every(size_type row_stride, size_type col_stride) const
+    {
+        du_check(Check::indices, row_stride > 0 && col_stride > 0);
+
+        return matrix_view(first_,
+                           (height_ + row_stride - 1) / row_stride,
+                           (width_ + col_stride - 1) / col_stride,
+                           row_step_ * static_cast<difference_type>(row_stride),
+                           col_step_ * static_cast<difference_type>(col_stride), probe_);
+    }
+
+    matrix_view diagonal() const
+    {
+        return matrix_view(first_, std::min(height_, width_), 1,
+                           row_step_ + col_step_, col_step_, probe_);
+    }
+
+private:
+    matrix_view(pointer first, size_type height, size_type width,
+                difference_type row_step, difference_type col_step,
+                du1_profile::matrix_probe probe)
+        : matrix_view(first, height, width, row_step, col_step)
+    {
+        probe_ = probe;
+    }
+
+    pointer         first_;
+    size_type       height_;
+    size_type       width_;
+    difference_type row_step_;
+    difference_type col_step_;
+
+    // The counters of the viewed matrix, see du1profile.hpp.
+    [[no_unique_address]] du1_profile::matrix_probe probe_;
 };
 
 #endif // DU1_MATRIX_HPP
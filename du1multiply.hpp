@@ -0,0 +1,282 @@
+#ifndef DU1_MULTIPLY_HPP
+#define DU1_MULTIPLY_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "du1debug.hpp"
+#include "du1matrix.hpp"
+
+//   Matrix multiplication
+//   =====================
+//
+//   multiply(a, b) (and operator*) computes the matrix product of two
+// matrices with the same element type. The storage layouts of a and b may
+// differ; the result uses the layout, the allocator and the check policy of
+// a. T only needs to be value initializable and to support binary + and *.
+// Either operand may also be a matrix_view (a block, a transposition, ...),
+// the product is then a row_major matrix with the default allocator.
+//
+//   Implementation details
+//   ----------------------
+//
+//   The product is computed the way optimized BLAS libraries do it. With
+// C = A * B, A being m * k and B being k * n:
+//
+//   for each panel of kc rows of B                      (kc * nc fits in L3)
+//     for each panel of nc columns of B
+//       pack the kc * nc block of B into nr wide slivers
+//       for each block of mc rows of A                  (mc * kc fits in L2)
+//         pack the mc * kc block of A into mr tall slivers
+//         for each sliver pair: micro-kernel            (kc * nr fits in L1)
+//
+//   Packing copies the blocks into contiguous buffers in exactly the order in
+// which the micro-kernel reads them, so the kernel streams through memory
+// with unit stride no matter what layout the operands have. Edge slivers are
+// padded with value-initialized elements.
+//
+//   The micro-kernel keeps an mr * nr block of C in local accumulators
+// (registers, for arithmetic types) and performs kc rank-1 updates on it. The
+// innermost loop runs over nr consecutive elements of both the B sliver and
+// the accumulators, which the compiler turns into SIMD multiply-adds for the
+// instruction set it targets (SSE, AVX2 or AVX-512 for float, double and
+// int32). Block sizes are chosen per element type by gemm_traits; types that
+// are not arithmetic get a small generic kernel.
+//
+template <typename T, typename = void>
+struct gemm_traits
+{
+    static constexpr std::size_t mr = 2;
+    static constexpr std::size_t nr = 2;
+    static constexpr std::size_t kc = 128;
+    static constexpr std::size_t mc = 64;
+    static constexpr std::size_t nc = 1024;
+};
+
+template <typename T>
+struct gemm_traits<T, typename std::enable_if<std::is_arithmetic<T>::value>::type>
+{
+    // nr spans one 32-byte AVX2 register (two SSE registers), so the mr * nr
+    // accumulators and the operands fit into the 16 vector registers of AVX2.
+    static constexpr std::size_t nr = sizeof(T) >= 16 ? 2 : 32 / sizeof(T);
+    static constexpr std::size_t mr = 6;
+    static constexpr std::size_t kc = 16384 / (nr * sizeof(T)) < 64 ? 64 : 16384 / (nr * sizeof(T));
+    static constexpr std::size_t mc = 131072 / (kc * sizeof(T)) / mr * mr < mr
+                                          ? mr
+                                          : 131072 / (kc * sizeof(T)) / mr * mr;
+    static constexpr std::size_t nc = 4096;
+};
+
+namespace du1_detail
+{
+    // Packs an mc * kc block of A (steps rs, cs) into mr tall slivers:
+    // sliver s holds rows s*mr .. s*mr+mr-1, stored column after column.
+    template <typename T, std::size_t MR>
+    void gemm_pack_a(const T* a, std::ptrdiff_t rs, std::ptrdiff_t cs,
+                     std::size_t mc, std::size_t kc, T* buffer)
+    {
+        for (std::size_t i0 = 0; i0 < mc; i0 += MR)
+        {
+            std::size_t h = std::min(MR, mc - i0);
+
+            for (std::size_t p = 0; p < kc; ++p)
+            {
+                const T* src = a + static_cast<std::ptrdiff_t>(i0) * rs
+                                 + static_cast<std::ptrdiff_t>(p) * cs;
+
+                for (std::size_t i = 0; i < h; ++i)
+                    *buffer++ = src[static_cast<std::ptrdiff_t>(i) * rs];
+                for (std::size_t i = h; i < MR; ++i)
+                    *buffer++ = T();
+            }
+        }
+    }
+
+    // Packs a kc * nc block of B (steps rs, cs) into nr wide slivers:
+    // sliver s holds columns s*nr .. s*nr+nr-1, stored row after row.
+    template <typename T, std::size_t NR>
+    void gemm_pack_b(const T* b, std::ptrdiff_t rs, std::ptrdiff_t cs,
+                     std::size_t kc, std::size_t nc, T* buffer)
+    {
+        for (std::size_t j0 = 0; j0 < nc; j0 += NR)
+        {
+            std::size_t w = std::min(NR, nc - j0);
+
+            for (std::size_t p = 0; p < kc; ++p)
+            {
+                const T* src = b + static_cast<std::ptrdiff_t>(p) * rs
+                                 + static_cast<std::ptrdiff_t>(j0) * cs;
+
+                for (std::size_t j = 0; j < w; ++j)
+                    *buffer++ = src[static_cast<std::ptrdiff_t>(j) * cs];
+                for (std::size_t j = w; j < NR; ++j)
+                    *buffer++ = T();
+            }
+        }
+    }
+
+    // C[0..h, 0..w] += (packed A sliver) * (packed B sliver).
+    template <typename T, std::size_t MR, std::size_t NR>
+    void gemm_micro_kernel(std::size_t kc, const T* a, const T* b,
+                           T* c, std::ptrdiff_t rs, std::ptrdiff_t cs,
+                           std::size_t h, std::size_t w)
+    {
+        T acc[MR][NR];
+        for (std::size_t i = 0; i < MR; ++i)
+            for (std::size_t j = 0; j < NR; ++j)
+                acc[i][j] = T();
+
+        for (std::size_t p = 0; p < kc; ++p, a += MR, b += NR)
+            for (std::size_t i = 0; i < MR; ++i)
+                for (std::size_t j = 0; j < NR; ++j)
+                    acc[i][j] = acc[i][j] + a[i] * b[j];
+
+        for (std::size_t i = 0; i < h; ++i)
+            for (std::size_t j = 0; j < w; ++j)
+            {
+                T& dst = c[static_cast<std::ptrdiff_t>(i) * rs + static_cast<std::ptrdiff_t>(j) * cs];
+                dst = dst + acc[i][j];
+            }
+    }
+
+    // C += A * B on raw blocks; C must already be initialized.
+    template <typename T>
+    void gemm(std::size_t m, std::size_t n, std::size_t k,
+              const T* a, std::ptrdiff_t ars, std::ptrdiff_t acs,
+              const T* b, std::ptrdiff_t brs, std::ptrdiff_t bcs,
+              T* c, std::ptrdiff_t crs, std::ptrdiff_t ccs)
+    {
+        typedef gemm_traits<T> traits;
+
+        constexpr std::size_t mr = traits::mr;
+        constexpr std::size_t nr = traits::nr;
+
+        std::size_t kc_max = std::min(traits::kc, k);
+        std::size_t mc_max = std::min(traits::mc, (m + mr - 1) / mr * mr);
+        std::size_t nc_max = std::min(traits::nc, (n + nr - 1) / nr * nr);
+
+        std::vector<T> packed_a(mc_max * kc_max);
+        std::vector<T> packed_b(kc_max * nc_max);
+
+        for (std::size_t jc = 0; jc < n; jc += traits::nc)
+        {
+            std::size_t nc = std::min(traits::nc, n - jc);
+
+            for (std::size_t pc = 0; pc < k; pc += traits::kc)
+            {
+                std::size_t kc = std::min(traits::kc, k - pc);
+
+                gemm_pack_b<T, nr>(b + static_cast<std::ptrdiff_t>(pc) * brs
+                                     + static_cast<std::ptrdiff_t>(jc) * bcs,
+                                   brs, bcs, kc, nc, packed_b.data());
+
+                for (std::size_t ic = 0; ic < m; ic += traits::mc)
+                {
+                    std::size_t mc = std::min(traits::mc, m - ic);
+
+                    gemm_pack_a<T, mr>(a + static_cast<std::ptrdiff_t>(ic) * ars
+                                         + static_cast<std::ptrdiff_t>(pc) * acs,
+                                       ars, acs, mc, kc, packed_a.data());
+
+                    for (std::size_t jr = 0; jr < nc; jr += nr)
+                        for (std::size_t ir = 0; ir < mc; ir += mr)
+                            gemm_micro_kernel<T, mr, nr>(
+                                kc,
+                                packed_a.data() + ir * kc,
+                                packed_b.data() + jr * kc,
+                                c + static_cast<std::ptrdiff_t>(ic + ir) * crs
+                                  + static_cast<std::ptrdiff_t>(jc + jr) * ccs,
+                                crs, ccs,
+                                std::min(mr, mc - ir), std::min(nr, nc - jr));
+                }
+            }
+        }
+    }
+}
+
+namespace du1_detail
+{
+    // C += A * B for matrices and views of matching shapes.
+    template <typename C, typename A, typename B>
+    void multiply_into(C& c, const A& a, const B& b)
+    {
+        std::size_t m = a.rows().size();
+        std::size_t k = a.cols().size();
+        std::size_t n = b.cols().size();
+
+        if (m == 0 || n == 0 || k == 0)
+            return;
+
+        gemm(m, n, k,
+             a.data(), a.row_step(), a.col_step(),
+             b.data(), b.row_step(), b.col_step(),
+             c.data(), c.row_step(), c.col_step());
+    }
+
+    template <typename M>
+    struct is_view_operand : std::false_type { };
+
+    template <typename T, typename C>
+    struct is_view_operand<matrix_view<T, C> > : std::true_type { };
+
+    template <typename M>
+    struct is_product_operand : is_view_operand<M> { };
+
+    template <typename T, typename L, typename A, typename C>
+    struct is_product_operand<matrix<T, L, A, C> > : std::true_type { };
+
+    // At least one view, the other one a matrix or a view.
+    template <typename A, typename B>
+    struct is_view_product
+        : std::integral_constant<bool, (is_view_operand<A>::value || is_view_operand<B>::value)
+                                    && is_product_operand<A>::value
+                                    && is_product_operand<B>::value>
+    { };
+}
+
+template <typename T, typename LayoutA, typename AllocA, typename CheckA,
+          typename LayoutB, typename AllocB, typename CheckB>
+matrix<T, LayoutA, AllocA, CheckA> multiply(const matrix<T, LayoutA, AllocA, CheckA>& a,
+                                           const matrix<T, LayoutB, AllocB, CheckB>& b)
+{
+    du_check(CheckA::indices || CheckB::indices, a.cols().size() == b.rows().size());
+
+    matrix<T, LayoutA, AllocA, CheckA> c(a.rows().size(), b.cols().size(), T(), a.get_allocator());
+    du1_detail::multiply_into(c, a, b);
+    return c;
+}
+
+// Products involving views (see matrix_view) give a row_major matrix.
+template <typename A, typename B,
+          typename = typename std::enable_if<du1_detail::is_view_product<A, B>::value>::type>
+matrix<typename A::value_type> multiply(const A& a, const B& b)
+{
+    static_assert(std::is_same<typename A::value_type, typename B::value_type>::value,
+                  "the operands must have the same element type");
+
+    du_check(du1_detail::checks_indices<A>::value || du1_detail::checks_indices<B>::value,
+             a.cols().size() == b.rows().size());
+
+    matrix<typename A::value_type> c(a.rows().size(), b.cols().size(), typename A::value_type());
+    du1_detail::multiply_into(c, a, b);
+    return c;
+}
+
+template <typename T, typename LayoutA, typename AllocA, typename CheckA,
+          typename LayoutB, typename AllocB, typename CheckB>
+matrix<T, LayoutA, AllocA, CheckA> operator*(const matrix<T, LayoutA, AllocA, CheckA>& a,
+                                             const matrix<T, LayoutB, AllocB, CheckB>& b)
+{
+    return multiply(a, b);
+}
+
+template <typename A, typename B,
+          typename = typename std::enable_if<du1_detail::is_view_product<A, B>::value>::type>
+matrix<typename A::value_type> operator*(const A& a, const B& b)
+{
+    return multiply(a, b);
+}
+
+#endif // DU1_MULTIPLY_HPP
@@ -0,0 +1,460 @@
+#ifndef DU1_PARALLEL_HPP
+#define DU1_PARALLEL_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "du1debug.hpp"
+#include "du1matrix.hpp"
+
+//   Parallel algorithms
+//   ===================
+//
+//   Overview
+//   --------
+//
+//   for_each_row(policy, m, f), for_each_col(policy, m, f),
+// for_each_tile(policy, m, f[, height, width]) and transform(policy, in, out,
+// f) (also with two inputs) run f over the lines, tiles or elements of
+// a matrix either sequentially (matrix_execution::seq) or split across the
+// threads of a thread_pool (matrix_execution::par, which uses the global
+// pool, or matrix_execution::par.on(pool)). f receives the same proxies as
+// the ones obtained through rows(), cols() and tiles(), as an lvalue, so it
+// may take them by reference. Views (matrix_view)
+// are accepted wherever a matrix is, temporaries included.
+//
+//   Lines are split into chunks of as many lines as it takes for their
+// distance to be a multiple of 64 bytes, so chunk boundaries fall every
+// multiple of 64 bytes from the first element. That keeps two workers off
+// the same cache line only if:
+//
+//   - the first element is 64-byte aligned, which std::allocator does not
+//     guarantee (the allocators of du1alloc.hpp do), and a view does not
+//     start inside a cache line
+//   - for lines across the storage (columns of a row_major matrix), and for
+//     tiles, the stride of the storage lines is a multiple of 64 bytes too,
+//     see 'Padding' in du1matrix.hpp
+//
+// Otherwise neighbouring chunks may share cache lines at their boundaries,
+// which costs time but does not change the results.
+//
+//   Implementation details
+//   ----------------------
+//
+//   thread_pool::parallel_for hands out chunk indices. Every worker (the
+// calling thread included) initially owns a contiguous slice of them, takes
+// chunks from the front of its own slice and, once it runs dry, steals single
+// chunks from the back of the other slices. A slice is protected by its own
+// mutex on its own cache line, so the owner and thieves only contend when
+// they meet at the same slice. Only one parallel_for runs on a pool at
+// a time; a nested call made from inside a chunk runs sequentially.
+//
+class thread_pool
+{
+public:
+    // A pool of 0 threads has 1, the calling thread.
+    explicit thread_pool(std::size_t threads = std::max(1u, std::thread::hardware_concurrency()))
+        : slots_(new slot[std::max<std::size_t>(threads, 1)])
+        , slot_count_(std::max<std::size_t>(threads, 1))
+        , body_(nullptr)
+        , generation_()
+        , busy_()
+        , stop_(false)
+    {
+        for (std::size_t i = 1; i < threads; ++i)
+            threads_.emplace_back(&thread_pool::worker_loop, this, i);
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    ~thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+
+        wake_.notify_all();
+        for (std::thread& t : threads_)
+            t.join();
+    }
+
+    // Number of threads taking part in parallel_for, the caller included.
+    std::size_t concurrency() const
+    {
+        return slot_count_;
+    }
+
+    // Calls f(first, last) for disjoint subranges covering [0, count). Every
+    // subrange except the last one has a length divisible by grain. The
+    // first exception thrown by f is rethrown once all chunks are finished.
+    template <typename F>
+    void parallel_for(std::size_t count, std::size_t grain, const F& f)
+    {
+        if (count == 0)
+            return;
+
+        grain = std::max<std::size_t>(grain, 1);
+
+        // A few chunks per thread leave room for stealing.
+        std::size_t target = slot_count_ * 4;
+        std::size_t chunk = (count + target - 1) / target;
+        chunk = std::max(grain, (chunk + grain - 1) / grain * grain);
+
+        std::size_t chunks = (count + chunk - 1) / chunk;
+        std::function<void(std::size_t)> body = [&](std::size_t c)
+        {
+            f(c * chunk, std::min(count, (c + 1) * chunk));
+        };
+
+        run(chunks, body);
+    }
+
+    // Pool used by matrix_execution::par.
+    static thread_pool& global()
+    {
+        static thread_pool pool;
+        return pool;
+    }
+
+private:
+    struct alignas(64) slot
+    {
+        std::mutex  mutex;
+        std::size_t first = 0;
+        std::size_t last = 0;
+    };
+
+    void run(std::size_t chunks, const std::function<void(std::size_t)>& body)
+    {
+        if (chunks == 1 || threads_.empty() || inside_pool())
+        {
+            for (std::size_t c = 0; c < chunks; ++c)
+                body(c);
+            return;
+        }
+
+        std::lock_guard<std::mutex> submit(submit_);
+
+        for (std::size_t i = 0; i < slot_count_; ++i)
+        {
+            std::lock_guard<std::mutex> lock(slots_[i].mutex);
+            slots_[i].first = chunks * i / slot_count_;
+            slots_[i].last = chunks * (i + 1) / slot_count_;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            body_ = &body;
+            error_ = nullptr;
+            busy_ = threads_.size();
+            ++generation_;
+        }
+
+        wake_.notify_all();
+        work(0);
+
+        std::exception_ptr error;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_.wait(lock, [this] { return busy_ == 0; });
+
+            body_ = nullptr;
+            error = error_;
+        }
+
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    void worker_loop(std::size_t index)
+    {
+        inside_pool() = true;
+        std::size_t seen = 0;
+
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+
+                if (stop_)
+                    return;
+
+                seen = generation_;
+            }
+
+            work(index);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--busy_ == 0)
+                done_.notify_all();
+        }
+    }
+
+    void work(std::size_t index)
+    {
+        bool outer = inside_pool();
+        inside_pool() = true;
+
+        std::size_t c;
+        while (pop(index, c) || steal(index, c))
+        {
+            try
+            {
+                (*body_)(c);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!error_)
+                    error_ = std::current_exception();
+            }
+        }
+
+        inside_pool() = outer;
+    }
+
+    bool pop(std::size_t index, std::size_t& c)
+    {
+        slot& s = slots_[index];
+        std::lock_guard<std::mutex> lock(s.mutex);
+
+        if (s.first == s.last)
+            return false;
+
+        c = s.first++;
+        return true;
+    }
+
+    bool steal(std::size_t index, std::size_t& c)
+    {
+        for (std::size_t k = 1; k < slot_count_; ++k)
+        {
+            slot& s = slots_[(index + k) % slot_count_];
+            std::lock_guard<std::mutex> lock(s.mutex);
+
+            if (s.first != s.last)
+            {
+                c = --s.last;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    static bool& inside_pool()
+    {
+        thread_local bool inside = false;
+        return inside;
+    }
+
+    std::unique_ptr<slot[]>  slots_;
+    std::size_t              slot_count_;
+    std::vector<std::thread> threads_;
+
+    std::mutex              submit_;
+    std::mutex              mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+
+    const std::function<void(std::size_t)>* body_;
+    std::size_t                             generation_;
+    std::size_t                             busy_;
+    bool                                    stop_;
+    std::exception_ptr                      error_;
+};
+
+namespace matrix_execution
+{
+    struct sequenced_policy
+    { };
+
+    struct parallel_policy
+    {
+        thread_pool* pool;
+
+        // The same policy running on a specific pool.
+        parallel_policy on(thread_pool& p) const
+        {
+            parallel_policy result = { &p };
+            return result;
+        }
+
+        thread_pool& get_pool() const
+        {
+            return pool ? *pool : thread_pool::global();
+        }
+    };
+
+    constexpr sequenced_policy seq = { };
+    constexpr parallel_policy  par = { nullptr };
+
+    template <typename P>
+    struct is_execution_policy
+        : std::integral_constant<bool, std::is_same<P, sequenced_policy>::value
+                                    || std::is_same<P, parallel_policy>::value>
+    { };
+}
+
+namespace du1_detail
+{
+    // Smallest number of consecutive lines whose total size is a multiple
+    // of a cache line, given the distance between two lines in elements.
+    template <typename T>
+    std::size_t line_granule(std::ptrdiff_t step)
+    {
+        std::size_t line = 64;
+        std::size_t bytes = static_cast<std::size_t>(step < 0 ? -step : step) * sizeof(T);
+
+        return bytes == 0 ? 1 : line / std::gcd(bytes, line);
+    }
+}
+
+// Sequential versions.
+template <typename M, typename F>
+void for_each_row(const matrix_execution::sequenced_policy&, M&& m, F f)
+{
+    for (auto row : m.rows())
+        f(row);
+}
+
+template <typename M, typename F>
+void for_each_col(const matrix_execution::sequenced_policy&, M&& m, F f)
+{
+    for (auto col : m.cols())
+        f(col);
+}
+
+template <typename M, typename F>
+void for_each_tile(const matrix_execution::sequenced_policy&, M&& m, F f,
+                   std::size_t height = std::remove_reference<M>::type::default_tile_height,
+                   std::size_t width = std::remove_reference<M>::type::default_tile_width)
+{
+    for (auto tile : m.tiles(height, width))
+        f(tile);
+}
+
+// Parallel versions.
+template <typename M, typename F>
+void for_each_row(const matrix_execution::parallel_policy& policy, M&& m, F f)
+{
+    auto rows = m.rows();
+    std::size_t grain = du1_detail::line_granule<typename std::remove_reference<M>::type::value_type>(m.row_step());
+
+    policy.get_pool().parallel_for(rows.size(), grain, [&](std::size_t first, std::size_t last)
+    {
+        for (auto it = rows.begin() + first, end = rows.begin() + last; it != end; ++it)
+        {
+            auto row = *it;
+            f(row);
+        }
+    });
+}
+
+template <typename M, typename F>
+void for_each_col(const matrix_execution::parallel_policy& policy, M&& m, F f)
+{
+    auto cols = m.cols();
+    std::size_t grain = du1_detail::line_granule<typename std::remove_reference<M>::type::value_type>(m.col_step());
+
+    policy.get_pool().parallel_for(cols.size(), grain, [&](std::size_t first, std::size_t last)
+    {
+        for (auto it = cols.begin() + first, end = cols.begin() + last; it != end; ++it)
+        {
+            auto col = *it;
+            f(col);
+        }
+    });
+}
+
+template <typename M, typename F>
+void for_each_tile(const matrix_execution::parallel_policy& policy, M&& m, F f,
+                   std::size_t height = std::remove_reference<M>::type::default_tile_height,
+                   std::size_t width = std::remove_reference<M>::type::default_tile_width)
+{
+    auto tiles = m.tiles(height, width);
+
+    policy.get_pool().parallel_for(tiles.size(), 1, [&](std::size_t first, std::size_t last)
+    {
+        for (auto it = tiles.begin() + first, end = tiles.begin() + last; it != end; ++it)
+        {
+            auto tile = *it;
+            f(tile);
+        }
+    });
+}
+
+namespace du1_detail
+{
+    // Applies f element by element, rows [first, last) of the output.
+    template <typename Out, typename F, typename... In>
+    void transform_rows(std::size_t first, std::size_t last, Out& out, F& f, const In&... in)
+    {
+        std::size_t cols = out.cols().size();
+
+        for (std::size_t i = first; i < last; ++i)
+        {
+            auto* dst = out.data() + static_cast<std::ptrdiff_t>(i) * out.row_step();
+
+            for (std::size_t j = 0; j < cols; ++j)
+                dst[static_cast<std::ptrdiff_t>(j) * out.col_step()] =
+                    f(in.data()[static_cast<std::ptrdiff_t>(i) * in.row_step()
+                              + static_cast<std::ptrdiff_t>(j) * in.col_step()]...);
+        }
+    }
+
+    template <typename Policy, typename Out, typename F, typename... In>
+    void transform(const Policy& policy, Out& out, F f, const In&... in)
+    {
+        std::size_t rows = out.rows().size();
+        std::size_t cols = out.cols().size();
+
+        du_check(checks_indices<Out>::value || (checks_indices<In>::value || ...),
+                 ((in.rows().size() == rows && in.cols().size() == cols) && ...));
+        (void)cols;
+
+        if constexpr (std::is_same<Policy, matrix_execution::sequenced_policy>::value)
+        {
+            transform_rows(0, rows, out, f, in...);
+        }
+        else
+        {
+            std::size_t grain = line_granule<typename Out::value_type>(out.row_step());
+
+            policy.get_pool().parallel_for(rows, grain, [&](std::size_t first, std::size_t last)
+            {
+                transform_rows(first, last, out, f, in...);
+            });
+        }
+    }
+}
+
+// out(i, j) = f(in(i, j))
+template <typename Policy, typename In, typename Out, typename F,
+          typename = typename std::enable_if<matrix_execution::is_execution_policy<Policy>::value>::type>
+void transform(const Policy& policy, const In& in, Out&& out, F f)
+{
+    du1_detail::transform(policy, out, f, in);
+}
+
+// out(i, j) = f(in1(i, j), in2(i, j))
+template <typename Policy, typename In1, typename In2, typename Out, typename F,
+          typename = typename std::enable_if<matrix_execution::is_execution_policy<Policy>::value>::type>
+void transform(const Policy& policy, const In1& in1, const In2& in2, Out&& out, F f)
+{
+    du1_detail::transform(policy, out, f, in1, in2);
+}
+
+#endif // DU1_PARALLEL_HPP
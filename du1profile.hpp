@@ -0,0 +1,408 @@
+#ifndef DU1_PROFILE_HPP
+#define DU1_PROFILE_HPP
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+
+//   Access profiling
+//   ================
+//
+//   Overview
+//   --------
+//
+//   Compiling with DU1_PROFILE defined makes every matrix count how it is
+// accessed through its proxies:
+//
+//   - line proxies (row_t, col_t, ...) handed out by operator[] of the line
+//     containers and by their iterators, and tiles handed out by the tile
+//     grids,
+//   - element accesses through line proxies and their iterators, separately
+//     for rows and columns of the matrix, with the distribution of the
+//     distances between consecutive elements (the stride, in bytes, bucketed
+//     by powers of two),
+//   - and derived from those, the bytes accessed and an estimate of the
+//     memory traffic (a stride of a cache line or more costs a whole line per
+//     element).
+//
+//   matrix::profile() returns a report of the counters, including
+// a recommendation of a storage layout or of tiled traversal; the report can
+// be written to a std::ostream. matrix::reset_profile() clears the counters.
+// Views created from a matrix count into the counters of the matrix (the
+// rows of a transposed view are columns of the matrix); accesses through
+// data() are not seen.
+//
+//   Without DU1_PROFILE, the counters are never allocated, the probes that the
+// proxies carry are empty members ([[no_unique_address]]) whose functions do
+// nothing, and profile() reports that profiling is disabled: proxies,
+// iterators and matrices have the same size and code as without the
+// instrumentation. DU1_PROFILE must be defined consistently in every
+// translation unit of a program.
+//
+//   Implementation details
+//   ----------------------
+//
+//   A matrix owns its counters through a holder. Copies get fresh counters,
+// a move constructed matrix takes over those of the source (a matrix returned
+// from a function keeps its history), and assignment keeps the counters of
+// the target. The counters are relaxed atomics, so parallel algorithms can
+// count concurrently; each access costs a single increment of the bucket of
+// its stride, everything else is computed when the report is made.
+//
+namespace du1_profile
+{
+#ifdef DU1_PROFILE
+    constexpr bool enabled = true;
+#else
+    constexpr bool enabled = false;
+#endif
+
+    // Bucket k counts the accesses with a stride of [2^k, 2^(k+1)) bytes.
+    constexpr std::size_t stride_buckets = 32;
+
+    constexpr std::size_t cache_line_size = 64;
+
+    constexpr std::size_t stride_bucket(std::ptrdiff_t stride_bytes)
+    {
+        std::uint64_t s = static_cast<std::uint64_t>(stride_bytes < 0 ? -stride_bytes : stride_bytes);
+        std::size_t k = static_cast<std::size_t>(std::bit_width(s | 1)) - 1;
+
+        return k < stride_buckets ? k : stride_buckets - 1;
+    }
+
+    struct line_counters
+    {
+        line_counters()
+            : proxies()
+            , strides()
+        { }
+
+        void reset()
+        {
+            proxies.store(0, std::memory_order_relaxed);
+            for (std::atomic<std::uint64_t>& s : strides)
+                s.store(0, std::memory_order_relaxed);
+        }
+
+        std::atomic<std::uint64_t>                              proxies;
+        std::array<std::atomic<std::uint64_t>, stride_buckets> strides;
+    };
+
+    struct counters
+    {
+        counters()
+            : rows()
+            , cols()
+            , tiles()
+        { }
+
+        void reset()
+        {
+            rows.reset();
+            cols.reset();
+            tiles.store(0, std::memory_order_relaxed);
+        }
+
+        line_counters              rows;
+        line_counters              cols;
+        std::atomic<std::uint64_t> tiles;
+    };
+
+#ifdef DU1_PROFILE
+    // Carried by line proxies and their iterators.
+    class line_probe
+    {
+    public:
+        constexpr line_probe()
+            : counters_(nullptr)
+        { }
+
+        explicit constexpr line_probe(line_counters* c)
+            : counters_(c)
+        { }
+
+        constexpr void proxy() const
+        {
+            if (counters_)
+                counters_->proxies.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        constexpr void access(std::ptrdiff_t stride_bytes) const
+        {
+            if (counters_)
+                counters_->strides[stride_bucket(stride_bytes)].fetch_add(1, std::memory_order_relaxed);
+        }
+
+    private:
+        line_counters* counters_;
+    };
+
+    // Carried by line containers, tiles, tile grids and views; knows which
+    // direction of the matrix their rows are.
+    class matrix_probe
+    {
+    public:
+        constexpr matrix_probe()
+            : counters_(nullptr)
+            , transposed_(false)
+        { }
+
+        explicit constexpr matrix_probe(counters* c, bool transposed = false)
+            : counters_(c)
+            , transposed_(transposed)
+        { }
+
+        constexpr line_probe rows() const
+        {
+            return counters_ ? line_probe(transposed_ ? &counters_->cols : &counters_->rows) : line_probe();
+        }
+
+        constexpr line_probe cols() const
+        {
+            return counters_ ? line_probe(transposed_ ? &counters_->rows : &counters_->cols) : line_probe();
+        }
+
+        constexpr matrix_probe transposed() const
+        {
+            return matrix_probe(counters_, !transposed_);
+        }
+
+        constexpr void tile() const
+        {
+            if (counters_)
+                counters_->tiles.fetch_add(1, std::memory_order_relaxed);
+        }
+
+    private:
+        counters* counters_;
+        bool      transposed_;
+    };
+
+    class holder
+    {
+    public:
+        holder()
+            : counters_(new counters())
+        { }
+
+        holder(const holder&)
+            : counters_(new counters())
+        { }
+
+        holder(holder&& other) noexcept
+            : counters_(std::move(other.counters_))
+        { }
+
+        holder& operator=(const holder&)
+        {
+            if (!counters_)
+                counters_.reset(new counters());
+            return *this;
+        }
+
+        holder& operator=(holder&&)
+        {
+            if (!counters_)
+                counters_.reset(new counters());
+            return *this;
+        }
+
+        matrix_probe probe() const
+        {
+            return matrix_probe(counters_.get());
+        }
+
+        const counters* get() const
+        {
+            return counters_.get();
+        }
+
+        void reset()
+        {
+            if (counters_)
+                counters_->reset();
+        }
+
+    private:
+        std::unique_ptr<counters> counters_;
+    };
+#else
+    struct line_probe
+    {
+        constexpr void proxy() const
+        { }
+
+        constexpr void access(std::ptrdiff_t) const
+        { }
+    };
+
+    struct matrix_probe
+    {
+        constexpr line_probe rows() const
+        {
+            return line_probe();
+        }
+
+        constexpr line_probe cols() const
+        {
+            return line_probe();
+        }
+
+        constexpr matrix_probe transposed() const
+        {
+            return matrix_probe();
+        }
+
+        constexpr void tile() const
+        { }
+    };
+
+    struct holder
+    {
+        matrix_probe probe() const
+        {
+            return matrix_probe();
+        }
+
+        const counters* get() const
+        {
+            return nullptr;
+        }
+
+        void reset()
+        { }
+    };
+#endif
+
+    // Snapshot of the counters of one direction.
+    struct line_report
+    {
+        std::uint64_t                              proxies;
+        std::uint64_t                              accesses;
+        std::uint64_t                              bytes;
+        std::uint64_t                              traffic;
+        std::array<std::uint64_t, stride_buckets> strides;
+    };
+
+    struct report
+    {
+        bool          enabled;
+        bool          row_major;
+        std::size_t   height;
+        std::size_t   width;
+        std::size_t   element_size;
+        line_report   rows;
+        line_report   cols;
+        std::uint64_t tiles;
+        std::string   recommendation;
+    };
+
+    inline line_report make_line_report(const line_counters* c, std::size_t element_size)
+    {
+        line_report r = { 0, 0, 0, 0, { } };
+        if (!c)
+            return r;
+
+        r.proxies = c->proxies.load(std::memory_order_relaxed);
+
+        for (std::size_t k = 0; k < stride_buckets; ++k)
+        {
+            std::uint64_t n = c->strides[k].load(std::memory_order_relaxed);
+            std::uint64_t stride = std::uint64_t(1) << k;
+
+            // Up to a cache line, consecutive elements share the lines.
+            std::uint64_t per_access = stride < element_size ? element_size
+                                     : stride < cache_line_size ? stride
+                                     : cache_line_size;
+
+            r.strides[k] = n;
+            r.accesses += n;
+            r.bytes += n * element_size;
+            r.traffic += n * per_access;
+        }
+
+        return r;
+    }
+
+    inline std::string recommend(const report& r)
+    {
+        if (!r.enabled)
+            return "profiling is disabled, define DU1_PROFILE";
+
+        const line_report& along = r.row_major ? r.rows : r.cols;
+        const line_report& across = r.row_major ? r.cols : r.rows;
+        const char* across_name = r.row_major ? "columns" : "rows";
+
+        std::uint64_t total = along.accesses + across.accesses;
+        if (total == 0)
+            return "no accesses through proxies recorded";
+
+        bool large = r.height * r.width * r.element_size > 256 * 1024;
+        bool strided = across.traffic > across.bytes;
+
+        if (across.accesses > 4 * along.accesses && strided)
+            return std::string("use ") + (r.row_major ? "column_major" : "row_major")
+                 + ": most accesses walk the " + across_name + ", which are strided in this layout";
+
+        if (4 * across.accesses > total && strided && large)
+            return std::string("walk the ") + across_name
+                 + " tile by tile (tiles()): a large share of the accesses is strided"
+                   " and the matrix does not fit into L2";
+
+        return "the layout matches the access pattern";
+    }
+
+    template <typename T>
+    report make_report(const counters* c, bool row_major, std::size_t height, std::size_t width)
+    {
+        report r;
+        r.enabled = enabled;
+        r.row_major = row_major;
+        r.height = height;
+        r.width = width;
+        r.element_size = sizeof(T);
+        r.rows = make_line_report(c ? &c->rows : nullptr, sizeof(T));
+        r.cols = make_line_report(c ? &c->cols : nullptr, sizeof(T));
+        r.tiles = c ? c->tiles.load(std::memory_order_relaxed) : 0;
+        r.recommendation = recommend(r);
+        return r;
+    }
+
+    inline void print_line_report(std::ostream& out, const char* name, const line_report& r)
+    {
+        out << "  " << name << ": " << r.proxies << " proxies, " << r.accesses << " accesses, "
+            << r.bytes << " bytes, ~" << r.traffic << " bytes of memory traffic\n";
+
+        if (r.accesses == 0)
+            return;
+
+        out << "    strides:";
+        for (std::size_t k = 0; k < stride_buckets; ++k)
+            if (r.strides[k] != 0)
+                out << ' ' << (std::uint64_t(1) << k) << "B+ x" << r.strides[k];
+        out << '\n';
+    }
+
+    inline std::ostream& operator<<(std::ostream& out, const report& r)
+    {
+        out << "matrix " << r.height << " x " << r.width << " of " << r.element_size
+            << "-byte elements, " << (r.row_major ? "row_major" : "column_major") << '\n';
+
+        if (r.enabled)
+        {
+            print_line_report(out, "rows", r.rows);
+            print_line_report(out, "cols", r.cols);
+            out << "  tiles: " << r.tiles << '\n';
+        }
+
+        return out << "  recommendation: " << r.recommendation << '\n';
+    }
+}
+
+#endif // DU1_PROFILE_HPP
@@ -0,0 +1,657 @@
+#ifndef DU1_REDUCE_HPP
+#define DU1_REDUCE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "du1debug.hpp"
+#include "du1matrix.hpp"
+#include "du1parallel.hpp"
+
+//   Reductions
+//   ==========
+//
+//   Overview
+//   --------
+//
+//   sum(x), min(x), max(x), mean(x), dot(x, y) and norm(x) reduce a line
+// (row_t, col_t and their const variants), a matrix, a matrix_view or a tile
+// to a single value; col_sums(x) and row_sums(x) return the sums of all
+// columns or rows as a std::vector. Every function optionally takes an
+// execution policy of du1parallel.hpp as its first argument.
+//
+//   The sums (sum, mean, dot, norm, col_sums, row_sums) take a summation mode
+// as their last argument:
+//
+//   summation::pairwise - several independent accumulators combined in
+//                         a tree, error grows with log(n) (the default)
+//   summation::kahan    - compensated summation per accumulator; only
+//                         applies to floating point types, others are summed
+//                         pairwise
+//
+//   In both modes the result is deterministic: it depends on the shape and
+// the storage of x, never on the policy or the number of threads, so
+// sequential and parallel runs agree to the last bit.
+//
+//   T only needs binary + (and * for dot and norm, < for min and max);
+// min and max require a non-empty x, mean divides by the element count
+// converted to T and norm is sqrt(dot(x, x)), found by argument dependent
+// lookup or in std.
+//
+//   Implementation details
+//   ----------------------
+//
+//   The elements are visited in storage order: along the storage lines of
+// the matrix (rows of a row_major matrix, columns of a column_major one),
+// whatever direction the reduction has. The sequence is split into chunks of
+// reduce_chunk elements, which is what the threads get; the chunk size is
+// fixed, which makes the results independent of the thread count. Inside
+// a chunk, reduce_lanes accumulators take every reduce_lanes-th element, so
+// the inner loop has no dependency between iterations and the compiler turns
+// it into SIMD additions (or minimum/maximum instructions). The partial
+// results of the chunks are combined in a fixed tree (or, with Kahan
+// summation, by compensated summation in order).
+//
+//   Sums across the storage lines (col_sums of a row_major matrix) are
+// computed in a single sweep: each row is added element-wise into a vector of
+// column accumulators, which again vectorizes. The rows are split into at
+// most reduce_blocks blocks with their own accumulator vectors, combined in
+// a fixed tree at the end. Sums along the storage lines reduce every line on
+// its own.
+//
+enum class summation
+{
+    pairwise,
+    kahan
+};
+
+namespace du1_detail
+{
+    constexpr std::size_t reduce_lanes = 8;
+    constexpr std::size_t reduce_chunk = 4096;
+    constexpr std::size_t reduce_blocks = 64;
+
+    // The elements first[i * row_step + j * col_step] of a height * width
+    // block; lines have a height of one.
+    template <typename T>
+    struct reduce_block
+    {
+        // Whether adjacent elements of a row are closer to each other than
+        // adjacent elements of a column.
+        bool rows_inner() const
+        {
+            return height <= 1 || (width > 1 && col_step <= row_step);
+        }
+
+        reduce_block transposed() const
+        {
+            reduce_block result = { first, width, height, col_step, row_step };
+            return result;
+        }
+
+        // The same block with the storage lines as its rows.
+        reduce_block storage_order() const
+        {
+            return rows_inner() ? *this : transposed();
+        }
+
+        std::size_t size() const
+        {
+            return height * width;
+        }
+
+        const T*       first;
+        std::size_t    height;
+        std::size_t    width;
+        std::ptrdiff_t row_step;
+        std::ptrdiff_t col_step;
+    };
+
+    template <typename X>
+    using reduce_value = typename std::remove_cv<
+        typename std::remove_pointer<decltype(std::declval<const X&>().data())>::type>::type;
+
+    template <typename X>
+        requires requires (const X& x) { x.size(); x.stride(); }
+    reduce_block<reduce_value<X> > make_reduce_block(const X& x)
+    {
+        reduce_block<reduce_value<X> > result = { x.data(), 1, x.size(), 0, x.stride() };
+        return result;
+    }
+
+    template <typename X>
+        requires requires (const X& x) { x.rows().size(); x.cols().size(); x.row_step(); x.col_step(); }
+    reduce_block<reduce_value<X> > make_reduce_block(const X& x)
+    {
+        reduce_block<reduce_value<X> > result = { x.data(), x.rows().size(), x.cols().size(),
+                                                  x.row_step(), x.col_step() };
+        return result;
+    }
+
+    template <typename X>
+    concept reducible = requires (const X& x) { make_reduce_block(x); };
+
+    template <typename Policy, typename X>
+    concept reducible_with = matrix_execution::is_execution_policy<Policy>::value && reducible<X>;
+
+    template <typename T>
+    constexpr bool compensable = std::is_floating_point<T>::value;
+
+    // acc - comp approximates the exact sum of the values added so far.
+    template <bool Kahan, typename T>
+    void accumulate(T& acc, T& comp, const T& x)
+    {
+        if constexpr (Kahan)
+        {
+            T y = x - comp;
+            T t = acc + y;
+            comp = (t - acc) - y;
+            acc = t;
+        }
+        else
+        {
+            (void)comp;
+            acc = acc + x;
+        }
+    }
+
+    template <typename T, typename Op>
+    T combine_tree(const T* values, std::size_t n, Op op)
+    {
+        if (n == 1)
+            return values[0];
+
+        std::size_t half = n / 2;
+        return op(combine_tree(values, half, op), combine_tree(values + half, n - half, op));
+    }
+
+    template <typename T>
+    T combine_compensated(const T* acc, const T* comp, std::size_t n)
+    {
+        T sum = T();
+        T c = T();
+        for (std::size_t i = 0; i < n; ++i)
+            accumulate<true>(sum, c, comp ? T(acc[i] - comp[i]) : acc[i]);
+        return sum - c;
+    }
+
+    // Runs body(first, last) over [0, count), in parallel with par.
+    template <typename Policy, typename F>
+    void reduce_for(const Policy& policy, std::size_t count, std::size_t grain, const F& body)
+    {
+        if constexpr (std::is_same<Policy, matrix_execution::sequenced_policy>::value)
+        {
+            (void)policy;
+            (void)grain;
+            body(0, count);
+        }
+        else
+        {
+            policy.get_pool().parallel_for(count, grain, body);
+        }
+    }
+
+    // Calls seg(line, pos, n) for the elements [first, last) of a block with
+    // lines of the given width, in storage order.
+    template <typename F>
+    void for_segments(std::size_t width, std::size_t first, std::size_t last, F seg)
+    {
+        while (first < last)
+        {
+            std::size_t line = first / width;
+            std::size_t pos = first % width;
+            std::size_t n = std::min(width - pos, last - first);
+
+            seg(line, pos, n);
+            first += n;
+        }
+    }
+
+    // Adds load(0) ... load(n - 1) into the lanes, element i into lane
+    // i % reduce_lanes.
+    template <bool Kahan, typename T, typename Load>
+    void add_lanes(T (&acc)[reduce_lanes], T (&comp)[reduce_lanes], std::size_t n, Load load)
+    {
+        // Local copies, which the compiler keeps in registers: the loads
+        // could alias the caller's arrays.
+        T a[reduce_lanes];
+        T c[reduce_lanes];
+        std::copy(std::begin(acc), std::end(acc), a);
+        std::copy(std::begin(comp), std::end(comp), c);
+
+        std::size_t i = 0;
+        for (; i + reduce_lanes <= n; i += reduce_lanes)
+            for (std::size_t k = 0; k < reduce_lanes; ++k)
+                accumulate<Kahan>(a[k], c[k], load(i + k));
+
+        for (std::size_t k = 0; i < n; ++i, ++k)
+            accumulate<Kahan>(a[k], c[k], load(i));
+
+        std::copy(a, a + reduce_lanes, acc);
+        std::copy(c, c + reduce_lanes, comp);
+    }
+
+    // Sum of term(line, pos, n, acc, comp) over the chunks of a count
+    // element sequence of lines of the given width.
+    template <bool Kahan, typename T, typename Policy, typename Segment>
+    T chunked_sum(const Policy& policy, std::size_t count, std::size_t width, const Segment& segment)
+    {
+        if (count == 0)
+            return T();
+
+        std::size_t chunks = (count + reduce_chunk - 1) / reduce_chunk;
+        std::vector<T> partial(chunks);
+
+        reduce_for(policy, chunks, 1, [&](std::size_t first, std::size_t last)
+        {
+            for (std::size_t c = first; c < last; ++c)
+            {
+                T acc[reduce_lanes] = { };
+                T comp[reduce_lanes] = { };
+
+                for_segments(width, c * reduce_chunk, std::min(count, (c + 1) * reduce_chunk),
+                             [&](std::size_t line, std::size_t pos, std::size_t n)
+                             {
+                                 segment(line, pos, n, acc, comp);
+                             });
+
+                if constexpr (Kahan)
+                    partial[c] = combine_compensated(acc, comp, reduce_lanes);
+                else
+                    partial[c] = combine_tree(acc, reduce_lanes, std::plus<T>());
+            }
+        });
+
+        if constexpr (Kahan)
+            return combine_compensated(partial.data(), static_cast<const T*>(nullptr), chunks);
+        else
+            return combine_tree(partial.data(), chunks, std::plus<T>());
+    }
+
+    template <bool Kahan, typename Policy, typename T>
+    T block_sum(const Policy& policy, reduce_block<T> b)
+    {
+        b = b.storage_order();
+
+        return chunked_sum<Kahan, T>(policy, b.size(), b.width,
+            [&](std::size_t line, std::size_t pos, std::size_t n,
+                T (&acc)[reduce_lanes], T (&comp)[reduce_lanes])
+            {
+                const T* p = b.first + static_cast<std::ptrdiff_t>(line) * b.row_step
+                                     + static_cast<std::ptrdiff_t>(pos) * b.col_step;
+                std::ptrdiff_t s = b.col_step;
+
+                if (s == 1)
+                    add_lanes<Kahan>(acc, comp, n, [p](std::size_t i) { return p[i]; });
+                else
+                    add_lanes<Kahan>(acc, comp, n,
+                                     [p, s](std::size_t i) { return p[static_cast<std::ptrdiff_t>(i) * s]; });
+            });
+    }
+
+    // y is visited in the order of x.
+    template <bool Kahan, typename Policy, typename T>
+    T block_dot(const Policy& policy, reduce_block<T> x, reduce_block<T> y)
+    {
+        if (!x.rows_inner())
+        {
+            x = x.transposed();
+            y = y.transposed();
+        }
+
+        return chunked_sum<Kahan, T>(policy, x.size(), x.width,
+            [&](std::size_t line, std::size_t pos, std::size_t n,
+                T (&acc)[reduce_lanes], T (&comp)[reduce_lanes])
+            {
+                const T* p = x.first + static_cast<std::ptrdiff_t>(line) * x.row_step
+                                     + static_cast<std::ptrdiff_t>(pos) * x.col_step;
+                const T* q = y.first + static_cast<std::ptrdiff_t>(line) * y.row_step
+                                     + static_cast<std::ptrdiff_t>(pos) * y.col_step;
+                std::ptrdiff_t s = x.col_step;
+                std::ptrdiff_t t = y.col_step;
+
+                if (s == 1 && t == 1)
+                    add_lanes<Kahan>(acc, comp, n, [p, q](std::size_t i) { return p[i] * q[i]; });
+                else
+                    add_lanes<Kahan>(acc, comp, n, [p, q, s, t](std::size_t i)
+                    {
+                        return p[static_cast<std::ptrdiff_t>(i) * s] * q[static_cast<std::ptrdiff_t>(i) * t];
+                    });
+            });
+    }
+
+    template <typename T>
+    struct min_op
+    {
+        T operator()(const T& a, const T& b) const
+        {
+            return b < a ? b : a;
+        }
+    };
+
+    template <typename T>
+    struct max_op
+    {
+        T operator()(const T& a, const T& b) const
+        {
+            return a < b ? b : a;
+        }
+    };
+
+    template <typename Policy, typename T, typename Op>
+    T block_extremum(const Policy& policy, reduce_block<T> b, Op op)
+    {
+        du_assert(b.size() > 0);
+
+        b = b.storage_order();
+
+        std::size_t count = b.size();
+        std::size_t chunks = (count + reduce_chunk - 1) / reduce_chunk;
+        std::vector<T> partial(chunks);
+
+        reduce_for(policy, chunks, 1, [&](std::size_t first, std::size_t last)
+        {
+            for (std::size_t c = first; c < last; ++c)
+            {
+                std::size_t begin = c * reduce_chunk;
+                T lanes[reduce_lanes];
+                std::fill(std::begin(lanes), std::end(lanes),
+                          b.first[static_cast<std::ptrdiff_t>(begin / b.width) * b.row_step
+                                  + static_cast<std::ptrdiff_t>(begin % b.width) * b.col_step]);
+
+                for_segments(b.width, begin, std::min(count, begin + reduce_chunk),
+                             [&](std::size_t line, std::size_t pos, std::size_t n)
+                             {
+                                 const T* p = b.first + static_cast<std::ptrdiff_t>(line) * b.row_step
+                                                      + static_cast<std::ptrdiff_t>(pos) * b.col_step;
+                                 std::ptrdiff_t s = b.col_step;
+
+                                 std::size_t i = 0;
+                                 if (s == 1)
+                                     for (; i + reduce_lanes <= n; i += reduce_lanes)
+                                         for (std::size_t k = 0; k < reduce_lanes; ++k)
+                                             lanes[k] = op(lanes[k], p[i + k]);
+
+                                 for (; i < n; ++i)
+                                     lanes[i % reduce_lanes] = op(lanes[i % reduce_lanes],
+                                                                  p[static_cast<std::ptrdiff_t>(i) * s]);
+                             });
+
+                partial[c] = combine_tree(lanes, reduce_lanes, op);
+            }
+        });
+
+        return combine_tree(partial.data(), chunks, op);
+    }
+
+    // Sums of the columns of a block whose rows are its storage lines, in
+    // one sweep over the rows.
+    template <bool Kahan, typename Policy, typename T>
+    std::vector<T> sums_across(const Policy& policy, const reduce_block<T>& b)
+    {
+        std::vector<T> result(b.width);
+        if (b.height == 0 || b.width == 0)
+            return result;
+
+        std::size_t rows = std::max<std::size_t>((b.height + reduce_blocks - 1) / reduce_blocks, 128);
+        std::size_t blocks = (b.height + rows - 1) / rows;
+
+        std::vector<T> acc(blocks * b.width);
+        std::vector<T> comp(Kahan ? blocks * b.width : 0);
+
+        reduce_for(policy, blocks, 1, [&](std::size_t first, std::size_t last)
+        {
+            for (std::size_t k = first; k < last; ++k)
+            {
+                T* a = acc.data() + k * b.width;
+                T* c = Kahan ? comp.data() + k * b.width : a;
+
+                for (std::size_t i = k * rows, end = std::min(b.height, (k + 1) * rows); i < end; ++i)
+                {
+                    const T* row = b.first + static_cast<std::ptrdiff_t>(i) * b.row_step;
+
+                    if (b.col_step == 1)
+                        for (std::size_t j = 0; j < b.width; ++j)
+                            accumulate<Kahan>(a[j], c[j], row[j]);
+                    else
+                        for (std::size_t j = 0; j < b.width; ++j)
+                            accumulate<Kahan>(a[j], c[j], row[static_cast<std::ptrdiff_t>(j) * b.col_step]);
+                }
+            }
+        });
+
+        if constexpr (Kahan)
+        {
+            std::vector<T> column(blocks);
+            std::vector<T> column_comp(blocks);
+
+            for (std::size_t j = 0; j < b.width; ++j)
+            {
+                for (std::size_t k = 0; k < blocks; ++k)
+                {
+                    column[k] = acc[k * b.width + j];
+                    column_comp[k] = comp[k * b.width + j];
+                }
+
+                result[j] = combine_compensated(column.data(), column_comp.data(), blocks);
+            }
+        }
+        else
+        {
+            // Tree over the blocks, element-wise on whole vectors.
+            auto combine = [&](auto& self, std::size_t lo, std::size_t hi) -> void
+            {
+                if (hi - lo == 1)
+                    return;
+
+                std::size_t mid = lo + (hi - lo) / 2;
+                self(self, lo, mid);
+                self(self, mid, hi);
+
+                T* a = acc.data() + lo * b.width;
+                const T* c = acc.data() + mid * b.width;
+                for (std::size_t j = 0; j < b.width; ++j)
+                    a[j] = a[j] + c[j];
+            };
+
+            combine(combine, 0, blocks);
+            std::copy(acc.begin(), acc.begin() + static_cast<std::ptrdiff_t>(b.width), result.begin());
+        }
+
+        return result;
+    }
+
+    // Sums of the columns of a block, each one on its own when they are the
+    // storage lines.
+    template <bool Kahan, typename Policy, typename T>
+    std::vector<T> column_sums(const Policy& policy, const reduce_block<T>& b)
+    {
+        if (b.rows_inner())
+            return sums_across<Kahan>(policy, b);
+
+        std::vector<T> result(b.width);
+
+        reduce_for(policy, b.width, 16, [&](std::size_t first, std::size_t last)
+        {
+            for (std::size_t j = first; j < last; ++j)
+            {
+                reduce_block<T> column = { b.first + static_cast<std::ptrdiff_t>(j) * b.col_step,
+                                           1, b.height, 0, b.row_step };
+                result[j] = block_sum<Kahan>(matrix_execution::seq, column);
+            }
+        });
+
+        return result;
+    }
+
+    template <typename T, typename F>
+    decltype(auto) with_summation(summation mode, F f)
+    {
+        if constexpr (compensable<T>)
+            if (mode == summation::kahan)
+                return f(std::true_type());
+
+        return f(std::false_type());
+    }
+}
+
+template <typename Policy, typename X>
+    requires du1_detail::reducible_with<Policy, X>
+du1_detail::reduce_value<X> sum(const Policy& policy, const X& x, summation mode = summation::pairwise)
+{
+    auto b = du1_detail::make_reduce_block(x);
+
+    return du1_detail::with_summation<du1_detail::reduce_value<X> >(mode, [&](auto kahan)
+    {
+        return du1_detail::block_sum<decltype(kahan)::value>(policy, b);
+    });
+}
+
+template <typename X>
+    requires du1_detail::reducible<X>
+du1_detail::reduce_value<X> sum(const X& x, summation mode = summation::pairwise)
+{
+    return sum(matrix_execution::seq, x, mode);
+}
+
+template <typename Policy, typename X>
+    requires du1_detail::reducible_with<Policy, X>
+du1_detail::reduce_value<X> mean(const Policy& policy, const X& x, summation mode = summation::pairwise)
+{
+    typedef du1_detail::reduce_value<X> value_type;
+
+    std::size_t n = du1_detail::make_reduce_block(x).size();
+    du_assert(n > 0);
+
+    return sum(policy, x, mode) / static_cast<value_type>(n);
+}
+
+template <typename X>
+    requires du1_detail::reducible<X>
+du1_detail::reduce_value<X> mean(const X& x, summation mode = summation::pairwise)
+{
+    return mean(matrix_execution::seq, x, mode);
+}
+
+template <typename Policy, typename X>
+    requires du1_detail::reducible_with<Policy, X>
+du1_detail::reduce_value<X> min(const Policy& policy, const X& x)
+{
+    return du1_detail::block_extremum(policy, du1_detail::make_reduce_block(x),
+                                      du1_detail::min_op<du1_detail::reduce_value<X> >());
+}
+
+template <typename X>
+    requires du1_detail::reducible<X>
+du1_detail::reduce_value<X> min(const X& x)
+{
+    return min(matrix_execution::seq, x);
+}
+
+template <typename Policy, typename X>
+    requires du1_detail::reducible_with<Policy, X>
+du1_detail::reduce_value<X> max(const Policy& policy, const X& x)
+{
+    return du1_detail::block_extremum(policy, du1_detail::make_reduce_block(x),
+                                      du1_detail::max_op<du1_detail::reduce_value<X> >());
+}
+
+template <typename X>
+    requires du1_detail::reducible<X>
+du1_detail::reduce_value<X> max(const X& x)
+{
+    return max(matrix_execution::seq, x);
+}
+
+// Sum of the element-wise products; x and y have the same shape and element
+// type.
+template <typename Policy, typename X, typename Y>
+    requires du1_detail::reducible_with<Policy, X> && du1_detail::reducible<Y>
+du1_detail::reduce_value<X> dot(const Policy& policy, const X& x, const Y& y,
+                                summation mode = summation::pairwise)
+{
+    static_assert(std::is_same<du1_detail::reduce_value<X>, du1_detail::reduce_value<Y> >::value,
+                  "dot requires the same element type");
+
+    auto bx = du1_detail::make_reduce_block(x);
+    auto by = du1_detail::make_reduce_block(y);
+    du_check(du1_detail::checks_indices<X>::value || du1_detail::checks_indices<Y>::value,
+             bx.height == by.height && bx.width == by.width);
+
+    return du1_detail::with_summation<du1_detail::reduce_value<X> >(mode, [&](auto kahan)
+    {
+        return du1_detail::block_dot<decltype(kahan)::value>(policy, bx, by);
+    });
+}
+
+template <typename X, typename Y>
+    requires du1_detail::reducible<X> && du1_detail::reducible<Y>
+du1_detail::reduce_value<X> dot(const X& x, const Y& y, summation mode = summation::pairwise)
+{
+    return dot(matrix_execution::seq, x, y, mode);
+}
+
+// Euclidean norm of a line, Frobenius norm of a matrix.
+template <typename Policy, typename X>
+    requires du1_detail::reducible_with<Policy, X>
+auto norm(const Policy& policy, const X& x, summation mode = summation::pairwise)
+{
+    using std::sqrt;
+    return sqrt(dot(policy, x, x, mode));
+}
+
+template <typename X>
+    requires du1_detail::reducible<X>
+auto norm(const X& x, summation mode = summation::pairwise)
+{
+    return norm(matrix_execution::seq, x, mode);
+}
+
+// Element j is the sum of column j.
+template <typename Policy, typename X>
+    requires du1_detail::reducible_with<Policy, X>
+std::vector<du1_detail::reduce_value<X> > col_sums(const Policy& policy, const X& x,
+                                                   summation mode = summation::pairwise)
+{
+    auto b = du1_detail::make_reduce_block(x);
+
+    return du1_detail::with_summation<du1_detail::reduce_value<X> >(mode, [&](auto kahan)
+    {
+        return du1_detail::column_sums<decltype(kahan)::value>(policy, b);
+    });
+}
+
+template <typename X>
+    requires du1_detail::reducible<X>
+std::vector<du1_detail::reduce_value<X> > col_sums(const X& x, summation mode = summation::pairwise)
+{
+    return col_sums(matrix_execution::seq, x, mode);
+}
+
+// Element i is the sum of row i.
+template <typename Policy, typename X>
+    requires du1_detail::reducible_with<Policy, X>
+std::vector<du1_detail::reduce_value<X> > row_sums(const Policy& policy, const X& x,
+                                                   summation mode = summation::pairwise)
+{
+    auto b = du1_detail::make_reduce_block(x).transposed();
+
+    return du1_detail::with_summation<du1_detail::reduce_value<X> >(mode, [&](auto kahan)
+    {
+        return du1_detail::column_sums<decltype(kahan)::value>(policy, b);
+    });
+}
+
+template <typename X>
+    requires du1_detail::reducible<X>
+std::vector<du1_detail::reduce_value<X> > row_sums(const X& x, summation mode = summation::pairwise)
+{
+    return row_sums(matrix_execution::seq, x, mode);
+}
+
+#endif // DU1_REDUCE_HPP
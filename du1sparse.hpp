@@ -0,0 +1,1096 @@
+#ifndef DU1_SPARSE_HPP
+#define DU1_SPARSE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <numeric>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "du1debug.hpp"
+#include "du1matrix.hpp"
+#include "du1parallel.hpp"
+
+//   sparse_matrix class template
+//   ============================
+//
+//   Overview
+//   --------
+//
+//   sparse_matrix<T, Format> only stores the nonzero elements, in one of
+// two compressed formats:
+//
+//   csr - compressed sparse rows (the default): the nonzeros of every row
+//         are stored together, ordered by column
+//   csc - compressed sparse columns: the same with rows and columns swapped
+//
+//   A sparse matrix is built from a dense matrix or view (elements equal to
+// T() are dropped), from (row, col, value) entries given in any order
+// (duplicates are summed), or from a sparse matrix in the other format.
+// to_dense() converts it back. The nonzero pattern is fixed after
+// construction; the stored values can be modified.
+//
+//   rows(), cols() and operator[] mirror the dense interface: they return
+// proxy containers of lines (row_t, col_t; row and column lines are the
+// same type here), and a line can be iterated with begin() and end(). Unlike
+// the dense lines, these iterators only visit the stored elements (in
+// increasing order); their index() member tells the position of the current
+// element within the line. size() of a line is still its full length,
+// nonzeros() the number of stored elements, and operator[] returns the
+// value (T() for elements that are not stored) rather than a reference.
+// As in the dense case, lines and line containers are views borrowing the
+// storage (std::ranges::view and borrowed_range, see 'Ranges' in
+// du1matrix.hpp); line containers are random access ranges whose iterators
+// return the lines by value, lines are forward ranges.
+//
+//   Lines along the compressed direction (rows of csr, columns of csc) are
+// contiguous slices of the storage. Lines along the other direction have to
+// binary search every compressed line, so iterating them costs
+// O(lines * log(nonzeros per line)); convert to the other format when that
+// direction is the hot one.
+//
+//   values(), indices() and offsets() expose the raw compressed storage:
+// the nonzeros of compressed line k are values()[offsets()[k] ..
+// offsets()[k + 1]], at positions indices()[offsets()[k] .. offsets()[k + 1]].
+//
+//   Kernels
+//   -------
+//
+//   spmv(policy, a, x, y) computes y = a * x for contiguous vectors, and
+// spmm(policy, a, b) (or multiply(a, b), a * b) the product with a dense
+// matrix. With a parallel policy (see du1parallel.hpp) csr splits the rows
+// of the result between the threads and csc the columns of the result (for
+// spmm); spmv on a csc matrix scatters into y and runs sequentially.
+// Shapes are checked by the policy of the dense operand of spmm, and by
+// default_checks for spmv (neither a sparse matrix nor a span has a policy).
+//
+struct csr
+{ };
+
+struct csc
+{ };
+
+template <typename T>
+struct sparse_entry
+{
+    std::size_t row;
+    std::size_t col;
+    T           value;
+};
+
+template <typename T, typename Format = csr>
+class sparse_matrix
+{
+    typedef sparse_matrix<T, Format> self;
+
+    // Friend declaration to allow conversion operations.
+    template <typename, typename>
+    friend class sparse_matrix;
+
+    // Whether the compressed lines are rows (as opposed to columns).
+    static constexpr bool rows_are_lines = std::is_same<Format, csr>::value;
+
+public:
+    typedef T              value_type;
+    typedef T&             reference;
+    typedef T*             pointer;
+    typedef const T&       const_reference;
+    typedef const T*       const_pointer;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::size_t    size_type;
+
+    // Constructors.
+    sparse_matrix()
+        : values_()
+        , indices_()
+        , offsets_(1, 0)
+        , rows_()
+        , cols_()
+    { }
+
+    // A rows * cols matrix of zeros.
+    sparse_matrix(size_type rows, size_type cols)
+        : values_()
+        , indices_()
+        , offsets_((rows_are_lines ? rows : cols) + 1, 0)
+        , rows_(rows)
+        , cols_(cols)
+    { }
+
+    // From (row, col, value) entries in any order; duplicates are summed.
+    template <typename InputIt>
+    sparse_matrix(size_type rows, size_type cols, InputIt first, InputIt last)
+        : sparse_matrix(rows, cols)
+    {
+        std::vector<sparse_entry<T> > entries(first, last);
+
+        // Counting sort by line, then sort every line by position.
+        for (const sparse_entry<T>& e : entries)
+        {
+            du_assert(e.row < rows_ && e.col < cols_);
+
+            ++offsets_[outer(e.row, e.col) + 1];
+        }
+
+        std::partial_sum(offsets_.begin(), offsets_.end(), offsets_.begin());
+
+        std::vector<size_type> next(offsets_.begin(), offsets_.end() - 1);
+        std::vector<std::pair<size_type, T> > sorted(entries.size());
+
+        for (const sparse_entry<T>& e : entries)
+            sorted[next[outer(e.row, e.col)]++] = std::make_pair(inner(e.row, e.col), e.value);
+
+        values_.reserve(sorted.size());
+        indices_.reserve(sorted.size());
+
+        size_type begin = 0;
+        for (size_type k = 0; k + 1 < offsets_.size(); ++k)
+        {
+            size_type end = offsets_[k + 1];
+
+            std::sort(sorted.begin() + begin, sorted.begin() + end,
+                      [](const std::pair<size_type, T>& a, const std::pair<size_type, T>& b)
+                      {
+                          return a.first < b.first;
+                      });
+
+            for (size_type p = begin; p < end; ++p)
+            {
+                if (p > begin && sorted[p].first == indices_.back())
+                {
+                    values_.back() = values_.back() + sorted[p].second;
+                }
+                else
+                {
+                    indices_.push_back(sorted[p].first);
+                    values_.push_back(sorted[p].second);
+                }
+            }
+
+            begin = end;
+            offsets_[k + 1] = values_.size();
+        }
+    }
+
+    // From a dense matrix or view; elements equal to T() are not stored.
+    template <typename Layout, typename Alloc, typename Check>
+    explicit sparse_matrix(const matrix<T, Layout, Alloc, Check>& dense)
+        : sparse_matrix(dense.rows().size(), dense.cols().size())
+    {
+        compress(matrix_view<const T>(dense));
+    }
+
+    template <typename U, typename Check,
+              typename = typename std::enable_if<std::is_same<typename std::remove_const<U>::type, T>::value>::type>
+    explicit sparse_matrix(const matrix_view<U, Check>& dense)
+        : sparse_matrix(dense.height(), dense.width())
+    {
+        compress(matrix_view<const T>(dense));
+    }
+
+    // Conversion between csr and csc.
+    template <typename OtherFormat>
+    explicit sparse_matrix(const sparse_matrix<T, OtherFormat>& other)
+        : sparse_matrix(other.rows_, other.cols_)
+    {
+        if constexpr (std::is_same<Format, OtherFormat>::value)
+        {
+            values_ = other.values_;
+            indices_ = other.indices_;
+            offsets_ = other.offsets_;
+        }
+        else
+        {
+            // Transposition of the compressed structure by counting sort.
+            for (size_type index : other.indices_)
+                ++offsets_[index + 1];
+
+            std::partial_sum(offsets_.begin(), offsets_.end(), offsets_.begin());
+
+            std::vector<size_type> next(offsets_.begin(), offsets_.end() - 1);
+            values_.resize(other.values_.size());
+            indices_.resize(other.indices_.size());
+
+            for (size_type k = 0; k + 1 < other.offsets_.size(); ++k)
+                for (size_type p = other.offsets_[k]; p < other.offsets_[k + 1]; ++p)
+                {
+                    size_type q = next[other.indices_[p]]++;
+                    values_[q] = other.values_[p];
+                    indices_[q] = k;
+                }
+        }
+    }
+
+    template <typename Layout = row_major, typename Alloc = std::allocator<T> >
+    matrix<T, Layout, Alloc> to_dense(const Alloc& alloc = Alloc()) const
+    {
+        matrix<T, Layout, Alloc> result(rows_, cols_, T(), alloc);
+
+        for (size_type k = 0; k + 1 < offsets_.size(); ++k)
+            for (size_type p = offsets_[k]; p < offsets_[k + 1]; ++p)
+            {
+                if (rows_are_lines)
+                    result[k][indices_[p]] = values_[p];
+                else
+                    result[indices_[p]][k] = values_[p];
+            }
+
+        return result;
+    }
+
+    // Forward declaration of helper class templates.
+    template <typename Base>
+    class line_t_iterator_base;
+
+    template <typename Base>
+    class line_t_base;
+
+    template <typename Base>
+    class lines_t_iterator_base;
+
+    template <typename Base>
+    class lines_t_base;
+
+    // Structs containing proxy container and iterator type definitions.
+private:
+    struct element_base
+    {
+        typedef T        value_type;
+        typedef T&       reference;
+        typedef T*       pointer;
+        typedef const T& const_reference;
+        typedef const T* const_pointer;
+
+        typedef T* element_pointer;
+    };
+
+    struct const_element_base
+    {
+        typedef const T  value_type;
+        typedef const T& reference;
+        typedef const T* pointer;
+        typedef const T& const_reference;
+        typedef const T* const_pointer;
+
+        typedef const T* element_pointer;
+    };
+
+public:
+    typedef line_t_iterator_base<element_base>       row_t_iterator;
+    typedef line_t_iterator_base<const_element_base> crow_t_iterator;
+
+    typedef line_t_iterator_base<element_base>       col_t_iterator;
+    typedef line_t_iterator_base<const_element_base> ccol_t_iterator;
+
+    typedef line_t_base<element_base>       row_t;
+    typedef line_t_base<const_element_base> crow_t;
+
+    typedef line_t_base<element_base>       col_t;
+    typedef line_t_base<const_element_base> ccol_t;
+
+    typedef lines_t_iterator_base<row_t>  rows_t_iterator;
+    typedef lines_t_iterator_base<crow_t> crows_t_iterator;
+
+    typedef lines_t_iterator_base<col_t>  cols_t_iterator;
+    typedef lines_t_iterator_base<ccol_t> ccols_t_iterator;
+
+    typedef lines_t_base<row_t>  rows_t;
+    typedef lines_t_base<crow_t> crows_t;
+
+    typedef lines_t_base<col_t>  cols_t;
+    typedef lines_t_base<ccol_t> ccols_t;
+
+private:
+    // What a line needs to know about the storage. For a compressed line,
+    // line is the index of the compressed line; otherwise it is the position
+    // searched for in each of the count compressed lines.
+    template <typename ElementPointer>
+    struct line_data
+    {
+        ElementPointer   values;
+        const size_type* indices;
+        const size_type* offsets;
+        size_type        count;
+        bool             compressed;
+    };
+
+public:
+    template <typename Base>
+    class line_t_iterator_base : public Base
+    {
+        template <typename>
+        friend class line_t_base;
+
+        // Friend declaration to allow conversion operations.
+        template <typename>
+        friend class line_t_iterator_base;
+
+        using typename Base::element_pointer;
+
+    public:
+        using typename Base::value_type;
+        using typename Base::reference;
+        using typename Base::pointer;
+
+        typedef std::ptrdiff_t            difference_type;
+        typedef std::forward_iterator_tag iterator_category;
+
+        line_t_iterator_base()
+            : data_()
+            , line_()
+            , pos_()
+            , outer_()
+        { }
+
+        // Copy and conversion constructor.
+        template <typename U>
+        line_t_iterator_base(const line_t_iterator_base<U>& other)
+            : data_{ other.data_.values, other.data_.indices, other.data_.offsets,
+                     other.data_.count, other.data_.compressed }
+            , line_(other.line_)
+            , pos_(other.pos_)
+            , outer_(other.outer_)
+        { }
+
+        bool operator==(const line_t_iterator_base& other) const
+        {
+            return pos_ == other.pos_ && outer_ == other.outer_;
+        }
+
+        bool operator!=(const line_t_iterator_base& other) const
+        {
+            return !(*this == other);
+        }
+
+        reference operator*() const
+        {
+            du_assert(data_.values && outer_ < data_.count);
+
+            return data_.values[pos_];
+        }
+
+        pointer operator->() const
+        {
+            return &**this;
+        }
+
+        // Position of the current element within the line.
+        size_type index() const
+        {
+            du_assert(data_.values && outer_ < data_.count);
+
+            return data_.compressed ? data_.indices[pos_] : outer_;
+        }
+
+        line_t_iterator_base& operator++()
+        {
+            du_assert(data_.values && outer_ < data_.count);
+
+            if (data_.compressed)
+            {
+                if (++pos_ == data_.offsets[line_ + 1])
+                    outer_ = data_.count;
+            }
+            else
+            {
+                ++outer_;
+                seek();
+            }
+
+            return *this;
+        }
+
+        line_t_iterator_base operator++(int)
+        {
+            line_t_iterator_base copy(*this);
+            ++*this;
+            return copy;
+        }
+
+    private:
+        line_t_iterator_base(const line_data<element_pointer>& data, size_type line, bool end)
+            : data_(data)
+            , line_(line)
+            , pos_()
+            , outer_(data.count)
+        {
+            if (end)
+            {
+                if (data_.compressed)
+                    pos_ = data_.offsets[line_ + 1];
+                return;
+            }
+
+            if (data_.compressed)
+            {
+                pos_ = data_.offsets[line_];
+                outer_ = pos_ < data_.offsets[line_ + 1] ? line_ : data_.count;
+            }
+            else
+            {
+                outer_ = 0;
+                seek();
+            }
+        }
+
+        // Finds the next compressed line (starting with outer_) which
+        // stores an element at position line_.
+        void seek()
+        {
+            pos_ = 0;
+
+            for (; outer_ < data_.count; ++outer_)
+            {
+                const size_type* first = data_.indices + data_.offsets[outer_];
+                const size_type* last = data_.indices + data_.offsets[outer_ + 1];
+                const size_type* it = std::lower_bound(first, last, line_);
+
+                if (it != last && *it == line_)
+                {
+                    pos_ = static_cast<size_type>(it - data_.indices);
+                    return;
+                }
+            }
+        }
+
+        // pos_ is the position of the current element in the storage. outer_
+        // is the current compressed line, or count at the end; a compressed
+        // line iterator keeps it equal to line_ until then, and its end has
+        // pos_ just past the slice of the line.
+        line_data<element_pointer> data_;
+        size_type                  line_;
+        size_type                  pos_;
+        size_type                  outer_;
+    };
+
+    template <typename Base>
+    class line_t_base : public Base, public du1_detail::proxy_range
+    {
+        friend self;
+
+        template <typename>
+        friend class lines_t_base;
+
+        // Friend declaration to allow conversion operations.
+        template <typename>
+        friend class line_t_base;
+
+        using typename Base::element_pointer;
+
+    public:
+        typedef typename std::remove_const<typename Base::value_type>::type value_type;
+        using typename Base::reference;
+        using typename Base::pointer;
+        using typename Base::const_reference;
+        using typename Base::const_pointer;
+
+        typedef std::ptrdiff_t difference_type;
+        typedef std::size_t    size_type;
+
+        typedef line_t_iterator_base<Base>               iterator;
+        typedef line_t_iterator_base<const_element_base> const_iterator;
+
+        line_t_base()
+            : data_()
+            , line_()
+            , length_()
+        { }
+
+        // Copy and conversion constructor.
+        template <typename U>
+        line_t_base(const line_t_base<U>& other)
+            : data_{ other.data_.values, other.data_.indices, other.data_.offsets,
+                     other.data_.count, other.data_.compressed }
+            , line_(other.line_)
+            , length_(other.length_)
+        { }
+
+        // Iteration visits the stored elements only.
+        iterator begin() const
+        {
+            return iterator(data_, line_, false);
+        }
+
+        const_iterator cbegin() const
+        {
+            return begin();
+        }
+
+        iterator end() const
+        {
+            return iterator(data_, line_, true);
+        }
+
+        const_iterator cend() const
+        {
+            return end();
+        }
+
+        // Length of the line, including the elements which are not stored.
+        size_type size() const
+        {
+            return length_;
+        }
+
+        size_type nonzeros() const
+        {
+            if (data_.compressed)
+                return data_.offsets[line_ + 1] - data_.offsets[line_];
+
+            return static_cast<size_type>(std::distance(begin(), end()));
+        }
+
+        // The value of element n, T() if it is not stored.
+        value_type operator[](size_type n) const
+        {
+            du_assert(n < length_);
+
+            size_type outer = data_.compressed ? line_ : n;
+            size_type inner = data_.compressed ? n : line_;
+
+            const size_type* first = data_.indices + data_.offsets[outer];
+            const size_type* last = data_.indices + data_.offsets[outer + 1];
+            const size_type* it = std::lower_bound(first, last, inner);
+
+            return it != last && *it == inner ? data_.values[it - data_.indices] : value_type();
+        }
+
+    private:
+        line_t_base(const line_data<element_pointer>& data, size_type line, size_type length)
+            : data_(data)
+            , line_(line)
+            , length_(length)
+        { }
+
+        line_data<element_pointer> data_;
+        size_type                  line_;
+        size_type                  length_;
+    };
+
+    template <typename Line>
+    class lines_t_iterator_base
+    {
+        template <typename>
+        friend class lines_t_base;
+
+        // Friend declaration to allow conversion operations.
+        template <typename>
+        friend class lines_t_iterator_base;
+
+    public:
+        typedef Line                            value_type;
+        typedef Line                            reference;
+        typedef Line*                           pointer;
+        typedef std::ptrdiff_t                  difference_type;
+        typedef std::random_access_iterator_tag iterator_category;
+
+        lines_t_iterator_base()
+            : lines_()
+            , index_()
+            , line_()
+        { }
+
+        // Copy and conversion constructor.
+        template <typename U>
+        lines_t_iterator_base(const lines_t_iterator_base<U>& other)
+            : lines_(other.lines_)
+            , index_(other.index_)
+            , line_(other.line_)
+        { }
+
+        bool operator==(const lines_t_iterator_base& other) const
+        {
+            return index_ == other.index_;
+        }
+
+        bool operator!=(const lines_t_iterator_base& other) const
+        {
+            return !(*this == other);
+        }
+
+        bool operator<(const lines_t_iterator_base& other) const
+        {
+            return index_ < other.index_;
+        }
+
+        bool operator>(const lines_t_iterator_base& other) const
+        {
+            return other < *this;
+        }
+
+        bool operator<=(const lines_t_iterator_base& other) const
+        {
+            return !(other < *this);
+        }
+
+        bool operator>=(const lines_t_iterator_base& other) const
+        {
+            return !(*this < other);
+        }
+
+        // The line is only materialized on dereference, and returned by
+        // value like the dense lines, see the dense tiles_t_iterator.
+        reference operator*() const
+        {
+            return lines_[static_cast<size_type>(index_)];
+        }
+
+        // See the dense matrix 'Implementation details'.
+        pointer operator->() const
+        {
+            line_ = **this;
+            return &line_;
+        }
+
+        value_type operator[](difference_type n) const
+        {
+            return *(*this + n);
+        }
+
+        lines_t_iterator_base& operator++()
+        {
+            return *this += 1;
+        }
+
+        lines_t_iterator_base operator++(int)
+        {
+            lines_t_iterator_base copy(*this);
+            ++*this;
+            return copy;
+        }
+
+        lines_t_iterator_base& operator--()
+        {
+            return *this -= 1;
+        }
+
+        lines_t_iterator_base operator--(int)
+        {
+            lines_t_iterator_base copy(*this);
+            --*this;
+            return copy;
+        }
+
+        lines_t_iterator_base& operator+=(difference_type n)
+        {
+            du_assert(index_ + n >= 0 && static_cast<size_type>(index_ + n) <= lines_.size());
+
+            index_ += n;
+            return *this;
+        }
+
+        lines_t_iterator_base& operator-=(difference_type n)
+        {
+            return *this += -n;
+        }
+
+        lines_t_iterator_base operator+(difference_type n) const
+        {
+            lines_t_iterator_base copy(*this);
+            return copy += n;
+        }
+
+        friend lines_t_iterator_base operator+(difference_type n, const lines_t_iterator_base& it)
+        {
+            return it + n;
+        }
+
+        lines_t_iterator_base operator-(difference_type n) const
+        {
+            lines_t_iterator_base copy(*this);
+            return copy -= n;
+        }
+
+        difference_type operator-(const lines_t_iterator_base& other) const
+        {
+            return index_ - other.index_;
+        }
+
+    private:
+        lines_t_iterator_base(const lines_t_base<Line>& lines, size_type index)
+            : lines_(lines)
+            , index_(static_cast<difference_type>(index))
+            , line_()
+        { }
+
+        lines_t_base<Line> lines_;
+        difference_type    index_;
+
+        // See the dense matrix 'Implementation details'.
+        mutable Line line_;
+    };
+
+    template <typename Line>
+    class lines_t_base : public du1_detail::proxy_range
+    {
+        friend self;
+
+        template <typename>
+        friend class lines_t_iterator_base;
+
+        // Friend declaration to allow conversion operations.
+        template <typename>
+        friend class lines_t_base;
+
+        typedef typename Line::element_pointer element_pointer;
+
+    public:
+        typedef Line                            value_type;
+        typedef std::size_t                     size_type;
+        typedef std::ptrdiff_t                  difference_type;
+        typedef lines_t_iterator_base<Line>     iterator;
+        typedef lines_t_iterator_base<
+            line_t_base<const_element_base> >   const_iterator;
+
+        lines_t_base()
+            : data_()
+            , size_()
+            , length_()
+        { }
+
+        // Copy and conversion constructor.
+        template <typename U>
+        lines_t_base(const lines_t_base<U>& other)
+            : data_{ other.data_.values, other.data_.indices, other.data_.offsets,
+                     other.data_.count, other.data_.compressed }
+            , size_(other.size_)
+            , length_(other.length_)
+        { }
+
+        iterator begin() const
+        {
+            return iterator(*this, 0);
+        }
+
+        const_iterator cbegin() const
+        {
+            return begin();
+        }
+
+        iterator end() const
+        {
+            return iterator(*this, size_);
+        }
+
+        const_iterator cend() const
+        {
+            return end();
+        }
+
+        size_type size() const
+        {
+            return size_;
+        }
+
+        value_type operator[](size_type n) const
+        {
+            du_assert(n < size_);
+
+            return value_type(data_, n, length_);
+        }
+
+    private:
+        lines_t_base(const line_data<element_pointer>& data, size_type size, size_type length)
+            : data_(data)
+            , size_(size)
+            , length_(length)
+        { }
+
+        line_data<element_pointer> data_;
+        size_type                  size_;
+        size_type                  length_;
+    };
+
+    // Row views.
+    rows_t rows()
+    {
+        return rows_t(data(rows_are_lines), rows_, cols_);
+    }
+
+    crows_t rows() const
+    {
+        return crows_t(data(rows_are_lines), rows_, cols_);
+    }
+
+    crows_t crows() const
+    {
+        return rows();
+    }
+
+    // Column views.
+    cols_t cols()
+    {
+        return cols_t(data(!rows_are_lines), cols_, rows_);
+    }
+
+    ccols_t cols() const
+    {
+        return ccols_t(data(!rows_are_lines), cols_, rows_);
+    }
+
+    ccols_t ccols() const
+    {
+        return cols();
+    }
+
+    // Element access via proxy container.
+    row_t operator[](size_type n)
+    {
+        return rows()[n];
+    }
+
+    crow_t operator[](size_type n) const
+    {
+        return rows()[n];
+    }
+
+    size_type nonzeros() const
+    {
+        return values_.size();
+    }
+
+    // Raw access to the compressed storage, see 'Overview'.
+    std::span<T> values()
+    {
+        return values_;
+    }
+
+    std::span<const T> values() const
+    {
+        return values_;
+    }
+
+    std::span<const size_type> indices() const
+    {
+        return indices_;
+    }
+
+    std::span<const size_type> offsets() const
+    {
+        return offsets_;
+    }
+
+private:
+    static size_type outer(size_type row, size_type col)
+    {
+        return rows_are_lines ? row : col;
+    }
+
+    static size_type inner(size_type row, size_type col)
+    {
+        return rows_are_lines ? col : row;
+    }
+
+    line_data<T*> data(bool compressed)
+    {
+        return line_data<T*>{ values_.data(), indices_.data(), offsets_.data(),
+                              offsets_.size() - 1, compressed };
+    }
+
+    line_data<const T*> data(bool compressed) const
+    {
+        return line_data<const T*>{ values_.data(), indices_.data(), offsets_.data(),
+                                    offsets_.size() - 1, compressed };
+    }
+
+    void compress(const matrix_view<const T>& dense)
+    {
+        size_type lines = rows_are_lines ? rows_ : cols_;
+        size_type length = rows_are_lines ? cols_ : rows_;
+
+        for (size_type k = 0; k < lines; ++k)
+        {
+            for (size_type n = 0; n < length; ++n)
+            {
+                const T& x = rows_are_lines ? dense[k][n] : dense[n][k];
+
+                if (!(x == T()))
+                {
+                    values_.push_back(x);
+                    indices_.push_back(n);
+                }
+            }
+
+            offsets_[k + 1] = values_.size();
+        }
+    }
+
+    std::vector<T>         values_;
+    std::vector<size_type> indices_;
+    std::vector<size_type> offsets_;
+    size_type              rows_;
+    size_type              cols_;
+};
+
+namespace du1_detail
+{
+    // Calls f(first, last) for the whole range or, with a parallel policy,
+    // for chunks of it on the pool.
+    template <typename Policy, typename F>
+    void sparse_for(const Policy& policy, std::size_t count, std::size_t grain, F f)
+    {
+        if constexpr (std::is_same<Policy, matrix_execution::sequenced_policy>::value)
+        {
+            (void)policy;
+            (void)grain;
+            f(std::size_t(0), count);
+        }
+        else
+        {
+            policy.get_pool().parallel_for(count, grain, f);
+        }
+    }
+}
+
+// y = a * x
+template <typename Policy, typename T, typename Format,
+          typename = typename std::enable_if<matrix_execution::is_execution_policy<Policy>::value>::type>
+void spmv(const Policy& policy, const sparse_matrix<T, Format>& a,
+          std::type_identity_t<std::span<const T> > x, std::type_identity_t<std::span<T> > y)
+{
+    std::size_t rows = a.rows().size();
+
+    // Neither operand has a check policy; they follow default_checks.
+    du_check(default_checks::indices, x.size() == a.cols().size() && y.size() == rows);
+
+    const T* values = a.values().data();
+    const std::size_t* indices = a.indices().data();
+    const std::size_t* offsets = a.offsets().data();
+
+    if constexpr (std::is_same<Format, csr>::value)
+    {
+        du1_detail::sparse_for(policy, rows, du1_detail::line_granule<T>(1),
+                               [&](std::size_t first, std::size_t last)
+        {
+            for (std::size_t i = first; i < last; ++i)
+            {
+                T sum = T();
+                for (std::size_t p = offsets[i]; p < offsets[i + 1]; ++p)
+                    sum = sum + values[p] * x[indices[p]];
+                y[i] = sum;
+            }
+        });
+    }
+    else
+    {
+        std::fill(y.begin(), y.end(), T());
+
+        for (std::size_t j = 0; j + 1 < a.offsets().size(); ++j)
+            for (std::size_t p = offsets[j]; p < offsets[j + 1]; ++p)
+                y[indices[p]] = y[indices[p]] + values[p] * x[j];
+    }
+}
+
+namespace du1_detail
+{
+    // c += a * b for a dense matrix or view b.
+    template <typename Policy, typename T, typename Format, typename B, typename C>
+    void spmm(const Policy& policy, const sparse_matrix<T, Format>& a, const B& b, C& c)
+    {
+        std::size_t m = a.rows().size();
+        std::size_t n = b.cols().size();
+
+        // The sparse operand has no check policy, the dense ones decide.
+        constexpr bool checked = checks_indices<B>::value || checks_indices<C>::value;
+
+        du_check(checked, a.cols().size() == b.rows().size());
+        du_check(checked, c.rows().size() == m && c.cols().size() == n);
+
+        const T* values = a.values().data();
+        const std::size_t* indices = a.indices().data();
+        const std::size_t* offsets = a.offsets().data();
+        std::size_t lines = a.offsets().size() - 1;
+
+        const T* bd = b.data();
+        T* cd = c.data();
+        std::ptrdiff_t brs = b.row_step(), bcs = b.col_step();
+        std::ptrdiff_t crs = c.row_step(), ccs = c.col_step();
+
+        if constexpr (std::is_same<Format, csr>::value)
+        {
+            // c(i, :) += a(i, k) * b(k, :) over the nonzeros of row i.
+            sparse_for(policy, m, line_granule<T>(crs), [&](std::size_t first, std::size_t last)
+            {
+                for (std::size_t i = first; i < last; ++i)
+                {
+                    T* ci = cd + static_cast<std::ptrdiff_t>(i) * crs;
+
+                    for (std::size_t p = offsets[i]; p < offsets[i + 1]; ++p)
+                    {
+                        const T* bk = bd + static_cast<std::ptrdiff_t>(indices[p]) * brs;
+
+                        for (std::size_t j = 0; j < n; ++j)
+                        {
+                            T& dst = ci[static_cast<std::ptrdiff_t>(j) * ccs];
+                            dst = dst + values[p] * bk[static_cast<std::ptrdiff_t>(j) * bcs];
+                        }
+                    }
+                }
+            });
+        }
+        else
+        {
+            // c(:, j) += a(:, k) * b(k, j) over the columns k of a.
+            sparse_for(policy, n, line_granule<T>(ccs), [&](std::size_t first, std::size_t last)
+            {
+                for (std::size_t j = first; j < last; ++j)
+                {
+                    T* cj = cd + static_cast<std::ptrdiff_t>(j) * ccs;
+
+                    for (std::size_t k = 0; k < lines; ++k)
+                    {
+                        T bkj = bd[static_cast<std::ptrdiff_t>(k) * brs
+                                 + static_cast<std::ptrdiff_t>(j) * bcs];
+
+                        for (std::size_t p = offsets[k]; p < offsets[k + 1]; ++p)
+                        {
+                            T& dst = cj[static_cast<std::ptrdiff_t>(indices[p]) * crs];
+                            dst = dst + values[p] * bkj;
+                        }
+                    }
+                }
+            });
+        }
+    }
+}
+
+// a * b for a dense b; the result has the layout and allocator of b (or is
+// a row_major matrix for a view).
+template <typename Policy, typename T, typename Format, typename Layout, typename Alloc, typename Check,
+          typename = typename std::enable_if<matrix_execution::is_execution_policy<Policy>::value>::type>
+matrix<T, Layout, Alloc, Check> spmm(const Policy& policy, const sparse_matrix<T, Format>& a,
+                                     const matrix<T, Layout, Alloc, Check>& b)
+{
+    matrix<T, Layout, Alloc, Check> c(a.rows().size(), b.cols().size(), T(), b.get_allocator());
+    du1_detail::spmm(policy, a, b, c);
+    return c;
+}
+
+template <typename Policy, typename T, typename Format, typename U, typename Check,
+          typename = typename std::enable_if<matrix_execution::is_execution_policy<Policy>::value
+                                          && std::is_same<typename std::remove_const<U>::type, T>::value>::type>
+matrix<T> spmm(const Policy& policy, const sparse_matrix<T, Format>& a, const matrix_view<U, Check>& b)
+{
+    matrix<T> c(a.rows().size(), b.width(), T());
+    du1_detail::spmm(policy, a, b, c);
+    return c;
+}
+
+template <typename T, typename Format, typename B>
+auto multiply(const sparse_matrix<T, Format>& a, const B& b)
+    -> decltype(spmm(matrix_execution::seq, a, b))
+{
+    return spmm(matrix_execution::seq, a, b);
+}
+
+template <typename T, typename Format, typename B>
+auto operator*(const sparse_matrix<T, Format>& a, const B& b)
+    -> decltype(spmm(matrix_execution::seq, a, b))
+{
+    return spmm(matrix_execution::seq, a, b);
+}
+
+#endif // DU1_SPARSE_HPP
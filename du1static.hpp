@@ -0,0 +1,412 @@
+#ifndef DU1_STATIC_HPP
+#define DU1_STATIC_HPP
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "du1debug.hpp"
+#include "du1matrix.hpp"
+
+//   static_matrix class template
+//   ============================
+//
+//   Overview
+//   --------
+//
+//   A Rows * Cols matrix whose extents are template arguments, for the small
+// matrices (3 * 3, 4 * 4 transformations and the like) that are created far
+// too often to pay for a heap allocation each. The elements live in
+// a std::array inside the object, so a static_matrix is exactly
+// Rows * Cols * sizeof(T) bytes, trivially copyable when T is, and everything
+// about it is constexpr:
+//
+//   constexpr static_matrix<int, 2, 2> r(0, -1,
+//                                        1,  0);
+//   static_assert((r * r)[0][0] == -1);
+//
+//   rows(), cols(), operator[] and their const variants return the same line
+// proxies as a matrix<T> with the same check policy (row_t, col_t, ...), with
+// data(), stride(), as_span() and random access iterators; tiles() is not
+// offered. data(), row_step() and col_step() describe the storage, so the
+// reductions of du1reduce.hpp and everything else that accepts a view take
+// a static_matrix too, and view() makes a matrix_view of it (from which
+// a matrix can be constructed).
+//
+//   Everything whose extents are known at compile time is checked at compile
+// time: the constructor from values takes exactly Rows * Cols of them, the
+// product only exists for matching inner extents, get<I, J>() and
+// block<Row, Col, Height, Width>() reject positions outside of the matrix and
+// identity() needs a square matrix. Runtime indices passed to the proxies are
+// checked by the check policy as usual; in a constant expression, a failing
+// check is a compile error.
+//
+//   The element-wise operations, the product and the transposition are
+// fully unrolled (static_for expands the loops into a sequence of
+// statements), which for these sizes beats a loop the compiler may or may not
+// unroll, and keeps the operations usable in constant expressions.
+//
+namespace du1_detail
+{
+    template <typename F, std::size_t... I>
+    constexpr void static_for(F& f, std::index_sequence<I...>)
+    {
+        (f(std::integral_constant<std::size_t, I>()), ...);
+    }
+
+    // Calls f(integral_constant<size_t, i>) for i = 0 .. N - 1.
+    template <std::size_t N, typename F>
+    constexpr void static_for(F f)
+    {
+        static_for(f, std::make_index_sequence<N>());
+    }
+}
+
+template <typename T, std::size_t Rows, std::size_t Cols, typename Layout = row_major,
+          typename Check = default_checks>
+class static_matrix
+{
+    typedef static_matrix<T, Rows, Cols, Layout, Check> self;
+
+    // Source of the proxy types, see matrix_view.
+    typedef matrix<T, row_major, std::allocator<T>, Check> owner;
+
+public:
+    typedef T              value_type;
+    typedef T&             reference;
+    typedef T*             pointer;
+    typedef const T&       const_reference;
+    typedef const T*       const_pointer;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::size_t    size_type;
+    typedef Check          check_type;
+
+    typedef typename owner::col_t   col_t;
+    typedef typename owner::ccol_t  ccol_t;
+    typedef typename owner::row_t   row_t;
+    typedef typename owner::crow_t  crow_t;
+    typedef typename owner::cols_t  cols_t;
+    typedef typename owner::ccols_t ccols_t;
+    typedef typename owner::rows_t  rows_t;
+    typedef typename owner::crows_t crows_t;
+
+    // Constructors. The elements are value initialized (zero for arithmetic
+    // types), set to def, or given in row order.
+    constexpr static_matrix()
+        : data_()
+    { }
+
+    constexpr explicit static_matrix(const value_type& def)
+        : data_()
+    {
+        fill(def);
+    }
+
+    template <typename... U>
+        requires (sizeof...(U) == Rows * Cols && sizeof...(U) > 1
+                  && (std::convertible_to<U, value_type> && ...))
+    constexpr static_matrix(const U&... values)
+        : data_()
+    {
+        const value_type in[] = { static_cast<value_type>(values)... };
+
+        du1_detail::static_for<Rows * Cols>([&](auto k)
+        {
+            at(k / Cols, k % Cols) = in[k];
+        });
+    }
+
+    // Element (i, j) is f(i, j).
+    template <typename F>
+        requires std::invocable<F&, size_type, size_type>
+    constexpr explicit static_matrix(F f)
+        : data_()
+    {
+        du1_detail::static_for<Rows * Cols>([&](auto k)
+        {
+            at(k / Cols, k % Cols) = f(size_type(k / Cols), size_type(k % Cols));
+        });
+    }
+
+    // Copy of a Rows * Cols matrix or view, checked at runtime.
+    template <typename U, typename ViewCheck>
+    explicit static_matrix(const matrix_view<U, ViewCheck>& view)
+        : data_()
+    {
+        du_check(Check::indices, view.height() == Rows && view.width() == Cols);
+
+        for (size_type i = 0; i < Rows; ++i)
+            for (size_type j = 0; j < Cols; ++j)
+                at(i, j) = view.data()[static_cast<difference_type>(i) * view.row_step()
+                                     + static_cast<difference_type>(j) * view.col_step()];
+    }
+
+    // Conversion from a static_matrix with a different layout or check
+    // policy.
+    template <typename OtherLayout, typename OtherCheck>
+    constexpr explicit static_matrix(const static_matrix<T, Rows, Cols, OtherLayout, OtherCheck>& other)
+        : data_()
+    {
+        du1_detail::static_for<Rows * Cols>([&](auto k)
+        {
+            at(k / Cols, k % Cols) = other.template get<k / Cols, k % Cols>();
+        });
+    }
+
+    static constexpr self identity()
+    {
+        static_assert(Rows == Cols, "identity() requires a square matrix");
+
+        self result;
+        du1_detail::static_for<Rows>([&](auto i)
+        {
+            result.at(i, i) = value_type(1);
+        });
+        return result;
+    }
+
+    // Extents.
+    static constexpr size_type height()
+    {
+        return Rows;
+    }
+
+    static constexpr size_type width()
+    {
+        return Cols;
+    }
+
+    // Column views.
+    constexpr cols_t cols()
+    {
+        return cols_t(data_.data(), Cols, col_step(), Rows, row_step());
+    }
+
+    constexpr ccols_t cols() const
+    {
+        return ccols_t(data_.data(), Cols, col_step(), Rows, row_step());
+    }
+
+    constexpr ccols_t ccols() const
+    {
+        return cols();
+    }
+
+    // Row views.
+    constexpr rows_t rows()
+    {
+        return rows_t(data_.data(), Rows, row_step(), Cols, col_step());
+    }
+
+    constexpr crows_t rows() const
+    {
+        return crows_t(data_.data(), Rows, row_step(), Cols, col_step());
+    }
+
+    constexpr crows_t crows() const
+    {
+        return rows();
+    }
+
+    // Element access via proxy container.
+    constexpr row_t operator[](size_type n)
+    {
+        return rows()[n];
+    }
+
+    constexpr crow_t operator[](size_type n) const
+    {
+        return rows()[n];
+    }
+
+    // Element access with compile-time checked indices.
+    template <size_type I, size_type J>
+    constexpr reference get()
+    {
+        static_assert(I < Rows && J < Cols, "index out of range");
+
+        return at(I, J);
+    }
+
+    template <size_type I, size_type J>
+    constexpr const_reference get() const
+    {
+        static_assert(I < Rows && J < Cols, "index out of range");
+
+        return at(I, J);
+    }
+
+    // Raw access to the storage, see matrix::data().
+    constexpr pointer data()
+    {
+        return data_.data();
+    }
+
+    constexpr const_pointer data() const
+    {
+        return data_.data();
+    }
+
+    static constexpr size_type leading_dimension()
+    {
+        return Layout::leading_dimension(Rows, Cols);
+    }
+
+    static constexpr difference_type row_step()
+    {
+        return Layout::row_step(leading_dimension());
+    }
+
+    static constexpr difference_type col_step()
+    {
+        return Layout::col_step(leading_dimension());
+    }
+
+    // Non-owning views, see matrix_view.
+    matrix_view<T, Check> view()
+    {
+        return matrix_view<T, Check>(data(), Rows, Cols, row_step(), col_step());
+    }
+
+    matrix_view<const T, Check> view() const
+    {
+        return matrix_view<const T, Check>(data(), Rows, Cols, row_step(), col_step());
+    }
+
+    constexpr void fill(const value_type& value)
+    {
+        du1_detail::static_for<Rows * Cols>([&](auto k)
+        {
+            data_[k] = value;
+        });
+    }
+
+    // Copies of parts of the matrix.
+    constexpr static_matrix<T, Cols, Rows, Layout, Check> transpose() const
+    {
+        static_matrix<T, Cols, Rows, Layout, Check> result;
+        du1_detail::static_for<Rows * Cols>([&](auto k)
+        {
+            result.template get<k % Cols, k / Cols>() = at(k / Cols, k % Cols);
+        });
+        return result;
+    }
+
+    template <size_type Row, size_type Col, size_type Height, size_type Width>
+    constexpr static_matrix<T, Height, Width, Layout, Check> block() const
+    {
+        static_assert(Row + Height <= Rows && Col + Width <= Cols, "block out of range");
+
+        static_matrix<T, Height, Width, Layout, Check> result;
+        du1_detail::static_for<Height * Width>([&](auto k)
+        {
+            result.template get<k / Width, k % Width>() = at(Row + k / Width, Col + k % Width);
+        });
+        return result;
+    }
+
+    // Element-wise arithmetic.
+    constexpr self& operator+=(const self& other)
+    {
+        du1_detail::static_for<Rows * Cols>([&](auto k)
+        {
+            data_[k] = data_[k] + other.data_[k];
+        });
+        return *this;
+    }
+
+    constexpr self& operator-=(const self& other)
+    {
+        du1_detail::static_for<Rows * Cols>([&](auto k)
+        {
+            data_[k] = data_[k] - other.data_[k];
+        });
+        return *this;
+    }
+
+    constexpr self& operator*=(const value_type& factor)
+    {
+        du1_detail::static_for<Rows * Cols>([&](auto k)
+        {
+            data_[k] = data_[k] * factor;
+        });
+        return *this;
+    }
+
+    friend constexpr self operator+(self a, const self& b)
+    {
+        return a += b;
+    }
+
+    friend constexpr self operator-(self a, const self& b)
+    {
+        return a -= b;
+    }
+
+    friend constexpr self operator*(self a, const value_type& factor)
+    {
+        return a *= factor;
+    }
+
+    friend constexpr self operator*(const value_type& factor, self a)
+    {
+        return a *= factor;
+    }
+
+    friend constexpr bool operator==(const self& a, const self& b)
+    {
+        bool equal = true;
+        du1_detail::static_for<Rows * Cols>([&](auto k)
+        {
+            equal = equal && a.data_[k] == b.data_[k];
+        });
+        return equal;
+    }
+
+private:
+    template <typename, std::size_t, std::size_t, typename, typename>
+    friend class static_matrix;
+
+    constexpr reference at(size_type i, size_type j)
+    {
+        return data_[static_cast<difference_type>(i) * row_step() + static_cast<difference_type>(j) * col_step()];
+    }
+
+    constexpr const_reference at(size_type i, size_type j) const
+    {
+        return data_[static_cast<difference_type>(i) * row_step() + static_cast<difference_type>(j) * col_step()];
+    }
+
+    std::array<T, Rows * Cols> data_;
+};
+
+// Matrix product; the inner extents have to match at compile time. The
+// result has the layout and the check policy of a.
+template <typename T, std::size_t Rows, std::size_t Inner, std::size_t OtherInner, std::size_t Cols,
+          typename Layout, typename Check, typename OtherLayout, typename OtherCheck>
+constexpr static_matrix<T, Rows, Cols, Layout, Check>
+operator*(const static_matrix<T, Rows, Inner, Layout, Check>& a,
+          const static_matrix<T, OtherInner, Cols, OtherLayout, OtherCheck>& b)
+{
+    static_assert(Inner == OtherInner, "the columns of a must match the rows of b");
+
+    static_matrix<T, Rows, Cols, Layout, Check> result;
+    du1_detail::static_for<Rows * Cols>([&](auto k)
+    {
+        constexpr std::size_t i = k / Cols;
+        constexpr std::size_t j = k % Cols;
+
+        T sum = T();
+        du1_detail::static_for<Inner>([&](auto p)
+        {
+            sum = sum + a.template get<i, p>() * b.template get<p, j>();
+        });
+        result.template get<i, j>() = sum;
+    });
+    return result;
+}
+
+#endif // DU1_STATIC_HPP
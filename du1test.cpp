@@ -1,8 +1,32 @@
 #include "du1matrix.hpp"
+#include "du1multiply.hpp"
+#include "du1expr.hpp"
+#include "du1parallel.hpp"
+#include "du1reduce.hpp"
+#include "du1static.hpp"
+#include "du1batch.hpp"
+#include "du1tracked.hpp"
+#include "du1alloc.hpp"
+#include "du1io.hpp"
+#include "du1sparse.hpp"
+#include "du1cow.hpp"
 #include "du1debug.hpp"
 
 #include <iostream>
+#include <limits>
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <numeric>
+#include <ranges>
+#include <sstream>
+#include <span>
+#include <stdexcept>
+#include <utility>
 
 typedef matrix< int> my_matrix;
 
@@ -105,6 +129,40 @@ struct Complex
     double im;
 };
 
+Complex operator+(const Complex& a, const Complex& b)
+{
+    Complex r = { a.re + b.re, a.im + b.im };
+    return r;
+}
+
+Complex operator*(const Complex& a, const Complex& b)
+{
+    Complex r = { a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re };
+    return r;
+}
+
+bool operator==(const Complex& a, const Complex& b)
+{
+    return a.re == b.re && a.im == b.im;
+}
+
+// Reference product for the multiplication tests.
+template <typename M1, typename M2>
+bool equals_naive_product(const M1& a, const M2& b, const M1& c)
+{
+    for (std::size_t i = 0; i < a.rows().size(); ++i)
+        for (std::size_t j = 0; j < b.cols().size(); ++j)
+        {
+            auto sum = typename M1::value_type();
+            for (std::size_t p = 0; p < a.cols().size(); ++p)
+                sum = sum + a[i][p] * b[p][j];
+            if (!(c[i][j] == sum))
+                return false;
+        }
+
+    return true;
+}
+
 int main( int, char * *)
 {
 #ifdef SILENT_TEST
@@ -131,6 +189,879 @@ int main( int, char * *)
   auto it2 = it1++;
   *it2 = 14;
 
+  // random access iterators
+  std::sort(c.cols()[1].begin(), c.cols()[1].end(), std::greater<int>());
+  du_assert(c.cols()[1].end() - c.cols()[1].begin() == 3);
+  du_assert(c.cols()[1].begin()[2] == c[2][1] && c[2][1] < c[0][1]);
+  std::sort(c[2].begin(), c[2].end());
+  du_assert(std::binary_search(c[2].cbegin(), c[2].cend(), c[2][3]));
+  du_assert(c.rows().end() - c.rows().begin() == 3);
+  du_assert((c.cols().begin() + 3)->begin()[0] == c[0][3]);
+  du_assert(c.cols().cbegin() < c.cols().end() - 1);
+
+  // raw storage access
+  du_assert(c.data() == &c[0][0] && c.leading_dimension() == 4);
+  du_assert(c[1].data() == c.data() + c.leading_dimension());
+  du_assert(c.cols()[2].data() == &c[0][2] && c.cols()[2].stride() == 4);
+  std::span<int> sp = c[2].as_span();
+  du_assert(sp.size() == 4 && &sp[3] == &c[2][3]);
+  std::span<const int> csp = c.crows()[2].as_span();
+  du_assert(csp.data() == sp.data());
+
+  // tiles
+  my_matrix t(5, 7, 0);
+  int tcnt = 0;
+  for (auto tile : t.tiles(2, 3))
+  {
+      std::for_each(tile.cols().begin(), tile.cols().end(),
+          [&](my_matrix::cols_t::reference col)
+          {
+              for (auto& el : col) el = tcnt++;
+          });
+  }
+  du_assert(t.tiles(2, 3).size() == 9 && t.tiles(2, 3).tile_cols() == 3);
+  du_assert(t[0][0] == 0 && t[1][0] == 1 && t[0][1] == 2 && t[1][2] == 5);
+  du_assert(t[0][3] == 6 && t[4][6] == tcnt - 1);
+  my_matrix::ctile_t corner = t.ctiles(2, 3)[8];
+  du_assert(corner.height() == 1 && corner.width() == 1 && corner[0][0] == t[4][6]);
+  du_assert(corner.first_row() == 4 && corner.first_col() == 6);
+  du_assert((t.tiles().end() - t.tiles().begin()) == 1);
+  du_assert(t.tiles(2, 3).begin()[4].cols()[1][1] == t[3][4]);
+  my_matrix::ctiles_t_iterator ctit = t.tiles(2, 3).begin() + 1;
+  du_assert(ctit->data() == &t[0][3]);
+
+  // storage layouts
+  matrix<int, column_major> cm(t);
+  du_assert(cm.col_step() == 5 && cm.row_step() == 1 && cm.leading_dimension() == 5);
+  du_assert(cm.cols()[2].as_span().size() == 5 && cm.cols()[2].data()[1] == t[1][2]);
+  du_assert(std::equal(cm.rows()[3].begin(), cm.rows()[3].end(), t[3].begin()));
+  du_assert(cm.tiles(2, 3)[4].cols()[1][1] == t[3][4]);
+  std::sort(cm[1].begin(), cm[1].end());
+  du_assert(std::is_sorted(cm.crows()[1].cbegin(), cm.crows()[1].cend()));
+  du_assert(my_matrix(cm)[2][6] == t[2][6]);
+
+  // transposition
+  for (std::size_t rr : {1, 3, 4, 37, 70})
+      for (std::size_t cc : {1, 2, 8, 37, 65})
+      {
+          my_matrix src(rr, cc, 0);
+          matrix<float, column_major> fsrc(rr, cc, 0.0f);
+          matrix<double> dsrc(rr, cc, 0.0);
+          for (std::size_t i = 0; i < rr; ++i)
+              for (std::size_t j = 0; j < cc; ++j)
+              {
+                  src[i][j] = static_cast<int>(i * 1000 + j);
+                  fsrc[i][j] = static_cast<float>(i * 1000 + j);
+                  dsrc[i][j] = static_cast<double>(i * 1000 + j);
+              }
+
+          my_matrix tr = src.transpose();
+          auto ftr = fsrc.transpose();
+          auto dtr = dsrc;
+          dtr.transpose_inplace();
+          auto fin = fsrc;
+          fin.transpose_inplace();
+          du_assert(tr.rows().size() == cc && tr.cols().size() == rr);
+          for (std::size_t i = 0; i < rr; ++i)
+              for (std::size_t j = 0; j < cc; ++j)
+              {
+                  du_assert(tr[j][i] == src[i][j]);
+                  du_assert(ftr[j][i] == fsrc[i][j] && fin[j][i] == fsrc[i][j]);
+                  du_assert(dtr[j][i] == dsrc[i][j]);
+              }
+          tr.transpose_inplace();
+          du_assert(std::equal(tr.data(), tr.data() + rr * cc, src.data()));
+      }
+  std::size_t mod_max = std::numeric_limits<std::size_t>::max();
+  du_assert(du1_detail::mul_mod(mod_max - 1, 3, mod_max) == mod_max - 3);
+  du_assert(du1_detail::mul_mod(std::size_t(1) << 40, std::size_t(1) << 40, (std::size_t(1) << 61) - 1) == std::size_t(1) << 19);
+
+  // multiplication
+  for (std::size_t mm : {1, 7, 130})
+      for (std::size_t kk : {1, 5, 300})
+      {
+          std::size_t nn = mm + 3;
+          my_matrix ia(mm, kk, 0);
+          matrix<int, column_major> ib(kk, nn, 0);
+          matrix<double> da(mm, kk, 0.0);
+          matrix<double> db(kk, nn, 0.0);
+          for (std::size_t i = 0; i < mm; ++i)
+              for (std::size_t p = 0; p < kk; ++p)
+              {
+                  ia[i][p] = static_cast<int>((i * 7 + p) % 13) - 6;
+                  da[i][p] = ia[i][p] * 0.5;
+              }
+          for (std::size_t p = 0; p < kk; ++p)
+              for (std::size_t j = 0; j < nn; ++j)
+              {
+                  ib[p][j] = static_cast<int>((p * 3 + j * 5) % 11) - 5;
+                  db[p][j] = ib[p][j] * 0.25;
+              }
+
+          du_assert(equals_naive_product(ia, ib, ia * ib));
+          du_assert(equals_naive_product(da, db, multiply(da, db)));
+      }
+
+  Complex unit = { 0.0, 1.0 };
+  matrix<Complex> cpa(3, 2, unit);
+  matrix<Complex> cpb(2, 5, unit);
+  cpb[1][4].re = 2.0;
+  matrix<Complex> cpc = cpa * cpb;
+  du_assert(equals_naive_product(cpa, cpb, cpc) && cpc[0][0].re == -2.0);
+
+  // element-wise expressions
+  matrix<double> ea(3, 4, 1.5);
+  matrix<double, column_major> eb(3, 4, 2.0);
+  matrix<double> ec(3, 4, 0.0);
+  ec[1][2] = 4.0;
+  matrix<double> er = ea * 2 + eb - ec;
+  du_assert(er[0][0] == 5.0 && er[1][2] == 1.0);
+  er = -(er / eb) + 1.0;
+  du_assert(er[0][0] == -1.5 && er[1][2] == 0.5);
+  er = sqrt(abs(hadamard(ea, eb) - 7.0));
+  du_assert(er[2][3] == 2.0);
+  er = select(ea < ec, ec, ea * 0.0);
+  du_assert(er[1][2] == 4.0 && er[0][0] == 0.0);
+  my_matrix mask = ec != 0.0;
+  du_assert(mask[1][2] == 1 && mask[2][2] == 0);
+  assign(er[2], ea[0] + eb.cols()[1].size() + ec.rows()[1]);
+  du_assert(er[2][2] == 8.5 && er[2][0] == 4.5);
+  assign(er.cols()[0], zip_transform([](double x, double y, double z) { return x * y + z; },
+                                     ea.cols()[0], eb.cols()[3], 1.0));
+  du_assert(er[0][0] == 4.0 && er[2][0] == 4.0);
+  assign(er.tiles(2, 2)[1], er.tiles(2, 2)[0] * 10);
+  du_assert(er[0][2] == 40.0 && er[1][3] == 0.0);
+  matrix<double, column_major> ecm = ea + eb;
+  du_assert(ecm[2][3] == 3.5);
+
+  // parallel algorithms
+  thread_pool pool(4);
+  my_matrix pa(37, 29, 0);
+  my_matrix pb(37, 29, 0);
+  for_each_col(matrix_execution::par.on(pool), pa, [](my_matrix::cols_t::reference col)
+      {
+          for (std::size_t i = 0; i < col.size(); ++i)
+              col[i] = static_cast<int>(i * 100);
+      });
+  for_each_col(matrix_execution::seq, pb, [](my_matrix::cols_t::reference col)
+      {
+          for (std::size_t i = 0; i < col.size(); ++i)
+              col[i] = static_cast<int>(i * 100);
+      });
+  du_assert(std::equal(pa.data(), pa.data() + 37 * 29, pb.data()));
+  for_each_row(matrix_execution::par, pa, [](my_matrix::rows_t::reference row)
+      {
+          std::sort(row.begin(), row.end(), std::greater<int>());
+      });
+  for_each_tile(matrix_execution::par.on(pool), pb, [](my_matrix::tile_t& tile)
+      {
+          for (auto row : tile.rows())
+              for (auto& el : row)
+                  el += 1;
+      }, 8, 16);
+  transform(matrix_execution::par.on(pool), pa, pb, pa, [](int x, int y) { return y - x; });
+  du_assert(std::all_of(pa.data(), pa.data() + 37 * 29, [](int x) { return x == 1; }));
+  std::atomic<std::size_t> visited(0);
+  for_each_row(matrix_execution::par.on(pool), std::as_const(pa), [&](my_matrix::crows_t::reference row)
+      {
+          for_each_col(matrix_execution::par.on(pool), pb, [](my_matrix::cols_t::reference) { });
+          visited += row.size();
+      });
+  du_assert(visited == 37 * 29);
+  thread_pool pool0(0);
+  visited = 0;
+  for_each_row(matrix_execution::par.on(pool0), std::as_const(pa), [&](my_matrix::crows_t::reference row)
+      {
+          visited += row.size();
+      });
+  du_assert(pool0.concurrency() == 1 && visited == 37 * 29);
+  bool thrown = false;
+  try
+  {
+      for_each_row(matrix_execution::par.on(pool), pa, [](my_matrix::rows_t::reference row)
+          {
+              if (row.data()[0] == 1)
+                  throw std::runtime_error("worker");
+          });
+  }
+  catch (const std::runtime_error&)
+  {
+      thrown = true;
+  }
+  du_assert(thrown);
+
+  // allocators
+  typedef matrix<double, row_major, aligned_allocator<double> > aligned_matrix;
+  aligned_matrix am(3, 5, 1.0);
+  aligned_matrix am2 = am * 2.0;
+  du_assert(reinterpret_cast<std::uintptr_t>(am.data()) % 64 == 0);
+  du_assert(reinterpret_cast<std::uintptr_t>(am2.transpose().data()) % 64 == 0);
+  du_assert(reinterpret_cast<std::uintptr_t>(multiply(am2, am.transpose()).data()) % 64 == 0);
+
+  monotonic_arena arena(256);
+  typedef matrix<int, row_major, arena_allocator<int> > arena_matrix;
+  const int* first_buffer;
+  {
+      arena_matrix ar1(4, 4, 7, arena_allocator<int>(arena));
+      arena_matrix ar2 = ar1;
+      arena_matrix ar3 = arena_matrix(arena_allocator<int>(arena));
+      ar3 = ar1.transpose();
+      du_assert(&ar2.get_allocator().arena() == &arena && ar3[3][0] == 7);
+      first_buffer = ar1.data();
+  }
+  arena.reset();
+  arena_matrix ar4(4, 4, 0, arena_allocator<int>(arena));
+  du_assert(ar4.data() == first_buffer);
+
+  buffer_pool bpool;
+  typedef matrix<float, column_major, pool_allocator<float> > pool_matrix;
+  const float* pooled = nullptr;
+  for (int iter = 0; iter < 3; ++iter)
+  {
+      pool_matrix pm(10, 10, 1.0f, pool_allocator<float>(bpool));
+      du_assert(pooled == nullptr || pm.data() == pooled);
+      pooled = pm.data();
+  }
+  du_assert(bpool.cached() >= 400);
+
+  // padded leading dimension
+  matrix<int, row_major, aligned_allocator<int> > pd(3, 5, 0, padding::automatic());
+  du_assert(pd.padded() && pd.leading_dimension() == 16 && pd.row_step() == 16);
+  du_assert(reinterpret_cast<std::uintptr_t>(pd[2].data()) % 64 == 0);
+  matrix<double> wide(2, 1024, 0.0, padding::automatic());
+  du_assert(wide.leading_dimension() == 1032);
+  matrix<int, column_major> pdc(3, 5, 0, padding(7));
+  du_assert(pdc.col_step() == 7);
+  for (std::size_t i = 0; i < 3; ++i)
+      for (std::size_t j = 0; j < 5; ++j)
+      {
+          pd[i][j] = static_cast<int>(i * 10 + j);
+          pdc[i][j] = pd[i][j];
+      }
+  du_assert(std::equal(pd.cols()[3].begin(), pd.cols()[3].end(), pdc.cols()[3].begin()));
+  du_assert(pd.tiles(2, 2)[5].cols()[0][0] == 24 && pdc.tiles(2, 2)[5].cols()[0][0] == 24);
+  auto pdt = pd.transpose();
+  du_assert(pdt.padded() && pdt.rows().size() == 5 && pdt[4][2] == 24);
+  pdc.transpose_inplace();
+  du_assert(pdc[4][2] == 24 && pdc.cols().size() == 3);
+  pd.transpose_inplace();
+  du_assert(pd[3][1] == 13 && pd.cols().size() == 3);
+  du_assert(equals_naive_product(pdt, pdc.transpose(), pdt * pdc.transpose()));
+  pdt = pdt * 2 - pdt;
+  du_assert(pdt.padded() && pdt[4][2] == 24);
+
+  // uninitialized and generated construction
+  matrix<double> dflt(2, 2, 0);
+  du_assert(dflt[1][1] == 0.0);
+  my_matrix un(300, 700, uninitialized);
+  du_assert(un.rows().size() == 300 && un.leading_dimension() == 700);
+  matrix<float, row_major, page_aligned_allocator<float> > unp(300, 700, uninitialized,
+                                                                matrix_execution::par.on(pool));
+  std::fill(unp.data(), unp.data() + 300 * 700, 1.0f);
+  du_assert(unp[299][699] == 1.0f);
+  auto gen = [](std::size_t i, std::size_t j) { return static_cast<int>(i * 1000 + j); };
+  my_matrix gm(50, 70, gen);
+  matrix<int, column_major> gmc(50, 70, gen, matrix_execution::par.on(pool));
+  my_matrix gmp(50, 70, gen, matrix_execution::seq);
+  du_assert(gm[49][69] == 49069 && gmc[49][69] == 49069 && gmc[3][7] == 3007);
+  du_assert(std::equal(gm.data(), gm.data() + 50 * 70, gmp.data()));
+  du_assert(std::equal(gm.cols()[5].begin(), gm.cols()[5].end(), gmc.cols()[5].begin()));
+  matrix<int, column_major> gmc_row(1, 5, gen), gmc_col(5, 1, gen, matrix_execution::par.on(pool));
+  du_assert(gmc_row[0][4] == 4 && gmc_row[0][1] == 1 && gmc_col[4][0] == 4000 && gmc_col[1][0] == 1000);
+  matrix<Complex> gcx(2, 2, [](std::size_t i, std::size_t j)
+      {
+          Complex c = { static_cast<double>(i), static_cast<double>(j) };
+          return c;
+      });
+  du_assert(gcx[1][0].re == 1.0 && gcx[1][0].im == 0.0);
+
+  // growing and reshaping
+  my_matrix gr;
+  gr.append_row(std::vector<int>{ 1, 2, 3 });
+  gr.reserve_rows(8);
+  du_assert(gr.row_capacity() >= 8 && gr.cols().size() == 3);
+  const int* grdata = gr.data();
+  auto gr0 = gr[0];
+  gr.append_row({ 4, 5, 6 });
+  gr.append_row(gr[1]);
+  du_assert(gr.data() == grdata && gr0[2] == 3 && gr[2][0] == 4);
+  for (int k = 0; k < 20; ++k)
+      gr.append_row(gr[0]);
+  du_assert(gr.rows().size() == 23 && gr[22][1] == 2 && gr[1][2] == 6);
+  gr.append_rows(gr);
+  du_assert(gr.rows().size() == 46 && gr[24][0] == 4);
+  matrix<int, column_major> grc(2, 3, 0);
+  grc.append_rows(gr);
+  grc.append_row(grc[3]);
+  du_assert(grc.rows().size() == 49 && grc[2][1] == 2 && grc[48][2] == 6);
+  du_assert(grc.row_capacity() >= 49 && grc.col_step() == static_cast<std::ptrdiff_t>(grc.leading_dimension()));
+  grc.resize(4, 5, 7);
+  du_assert(grc[3][2] == 6 && grc[3][4] == 7 && grc[0][3] == 7);
+  gr.resize(2, 5, -1);
+  du_assert(gr[1][2] == 6 && gr[1][3] == -1 && !gr.padded());
+  gr.resize(4, 5, 9);
+  du_assert(gr[3][0] == 9 && gr[1][1] == 5);
+  gr.reshape(5, 4);
+  du_assert(gr[1][0] == -1 && gr[1][1] == 4 && gr.leading_dimension() == 4);
+
+  // views
+  my_matrix vm(6, 8, gen);
+  matrix_view<int> vb = vm.block(1, 2, 4, 5);
+  du_assert(vb[0][0] == 1002 && vb.height() == 4 && vb.cols().size() == 5);
+  vb[3][4] = -1;
+  du_assert(vm[4][6] == -1);
+  auto vt = vb.transposed();
+  du_assert(vt[4][3] == -1 && vt.rows().size() == 5 && vt.row_step() == 1);
+  auto ve = vm.every(2, 3);
+  du_assert(ve.height() == 3 && ve.width() == 3 && ve[2][1] == 4003);
+  du_assert(vm.block(2, 2, 4, 4).every(2, 2).transposed()[1][0] == 2004);
+  matrix_view<const int> vd = static_cast<const my_matrix&>(vm).diagonal();
+  du_assert(vd.height() == 6 && vd[5][0] == 5005 && vd.cols()[0][3] == 3003);
+  du_assert(vb.diagonal()[2][0] == 3004);
+  matrix<int, column_major> vmc(vm);
+  du_assert(vmc.block(1, 2, 4, 5).transposed()[4][3] == -1);
+  my_matrix vcopy(vt);
+  du_assert(vcopy.rows().size() == 5 && vcopy[4][3] == -1 && vcopy[0][0] == 1002);
+  du_assert(equals_naive_product(my_matrix(vb), vcopy, vb * vt));
+  du_assert(equals_naive_product(vcopy, my_matrix(vb), multiply(vt, vm.block(1, 2, 4, 5))));
+  for_each_row(matrix_execution::par.on(pool), vm.block(0, 0, 6, 2), [](my_matrix::row_t row)
+      {
+          row[1] = row[0];
+      });
+  du_assert(vm[5][1] == 5000 && vm[5][2] == 5002);
+  for_each_tile(matrix_execution::seq, vb, [](my_matrix::tile_t tile)
+      {
+          tile.rows()[0][0] += 1;
+      }, 2, 2);
+  du_assert(vm[1][2] == 1003 && vm[3][4] == 3005);
+  transform(matrix_execution::seq, vm.block(0, 0, 2, 2), vm.block(4, 6, 2, 2), [](int x) { return -x; });
+  du_assert(vm[5][7] == -1000);
+  assign(vm.block(0, 0, 2, 8).every(1, 2), vm.block(2, 0, 2, 8).every(1, 2) * 2);
+  du_assert(vm[1][6] == 6014 && vm[1][7] == 1007);
+  my_matrix vx = vmc.transposed() + 0;
+  du_assert(vx.rows().size() == 8 && vx[7][1] == 1007);
+  my_matrix va(3, 3, [](std::size_t i, std::size_t j) { return int(i * 3 + j); });
+  va = va.transposed() + 0;
+  du_assert(va[0][1] == 3 && va[1][0] == 1 && va[2][1] == 5 && va[1][2] == 7);
+  va = va * 2 + va;
+  du_assert(va[0][1] == 9 && va[2][2] == 24);
+  assign(va.block(1, 0, 2, 3), va.block(0, 0, 2, 3) + 1);
+  du_assert(va[1][0] == 1 && va[2][0] == 4 && va[2][2] == 22);
+  assign(va[0], va.cols()[2]);
+  du_assert(va[0][0] == 18 && va[0][1] == 19 && va[0][2] == 22);
+  du_assert(my_matrix().transposed().height() == 0 && my_matrix(3, 0, 0).transposed().rows().size() == 0);
+  du_assert((matrix<int, column_major>(0, 4, 0).transposed().width() == 0 && my_matrix(3, 0, 0).block(1, 0, 2, 0).height() == 2));
+
+  // binary files and memory mapping
+  std::string fpath = (std::filesystem::temp_directory_path() / "du1test_matrix.bin").string();
+  save_matrix(fpath, vm);
+  {
+      matrix_mmap<int> mm = matrix_mmap<int>::open(fpath);
+      du_assert(mm.rows().size() == 6 && mm.cols().size() == 8 && mm[1][7] == 1007);
+      du_assert(reinterpret_cast<std::uintptr_t>(mm.data()) % 4096 == 0);
+      du_assert(std::equal(mm.cols()[3].begin(), mm.cols()[3].end(), vm.cols()[3].begin()));
+      du_assert(equals_naive_product(my_matrix(mm.view()), vm.transposed(), mm.view() * vm.transposed()));
+  }
+  save_matrix(fpath, pdc);
+  {
+      matrix_mmap<int> mm = matrix_mmap<int>::open(fpath, map_mode::copy_on_write);
+      du_assert(mm.col_step() == static_cast<std::ptrdiff_t>(pdc.leading_dimension()));
+      du_assert(mm[4][2] == 24 && mm.view().block(4, 2, 1, 1)[0][0] == 24);
+      mm.mutable_view()[4][2] = 0;
+      du_assert(mm[4][2] == 0 && matrix_mmap<int>::open(fpath)[4][2] == 24);
+      matrix_mmap<int> moved(std::move(mm));
+      du_assert(moved[4][2] == 0 && mm.view().height() == 0);
+  }
+  bool wrong_type = false;
+  try
+  {
+      matrix_mmap<float>::open(fpath);
+  }
+  catch (const matrix_io_error&)
+  {
+      wrong_type = true;
+  }
+  du_assert(wrong_type);
+  save_matrix(fpath, my_matrix(3, 0, 0));
+  du_assert(matrix_mmap<int>::open(fpath).rows().size() == 3 && matrix_mmap<int>::open(fpath).view().width() == 0);
+  std::filesystem::remove(fpath);
+  bool missing = false;
+  try
+  {
+      matrix_mmap<int>::open(fpath);
+  }
+  catch (const std::system_error&)
+  {
+      missing = true;
+  }
+  du_assert(missing);
+
+  // matrix streams
+  stream_options sopt;
+  sopt.buffer_size = 3 * 8 * sizeof(int);
+  sopt.checksums = true;
+  std::stringstream ss;
+  write_matrix(ss, vm, sopt);
+  write_matrix(ss, vm.block(1, 1, 4, 3).transposed());
+  my_matrix sr = read_matrix<int>(ss);
+  du_assert(std::equal(sr.data(), sr.data() + 48, vm.data()));
+  matrix<int, column_major> src = read_matrix<int, column_major>(ss);
+  du_assert(src.rows().size() == 3 && src[2][3] == vm[4][3]);
+  std::stringstream sc;
+  write_matrix(sc, vmc, sopt);
+  std::string bytes = sc.str();
+  bytes[64 + 5 * sizeof(int)] ^= 1;
+  std::stringstream corrupt(bytes);
+  bool mismatch = false;
+  try
+  {
+      read_matrix<int>(corrupt);
+  }
+  catch (const matrix_io_error&)
+  {
+      mismatch = true;
+  }
+  du_assert(mismatch);
+  std::stringstream sd;
+  write_matrix(sd, matrix<double>(2, 8, 1.0));
+  auto stream_fails = [&](std::uint64_t rows, std::uint64_t cols, std::uint64_t chunk_rows)
+  {
+      std::string header = sd.str().substr(0, 64);
+      std::memcpy(&header[16], &rows, 8);
+      std::memcpy(&header[24], &cols, 8);
+      std::memcpy(&header[32], &chunk_rows, 8);
+      std::stringstream in1(header + sd.str().substr(64)), in2(in1.str());
+      int failed = 0;
+      try
+      {
+          read_matrix<double>(in1);
+      }
+      catch (const matrix_io_error&)
+      {
+          ++failed;
+      }
+      try
+      {
+          row_reader<double> huge(in2);
+      }
+      catch (const matrix_io_error&)
+      {
+          ++failed;
+      }
+      return failed == 2;
+  };
+  du_assert(!stream_fails(2, 8, 1) && stream_fails(std::uint64_t(1) << 61, 8, 1)
+            && stream_fails(2, 8, std::uint64_t(1) << 62));
+  int fds[2];
+  du_assert(::pipe(fds) == 0);
+  write_matrix(fds[1], vm, sopt);
+  ::close(fds[1]);
+  row_reader<int> reader(fds[0]);
+  std::size_t read_rows = 0;
+  while (reader.next())
+  {
+      du_assert(reader.row().size() == 8 && std::equal(reader.row().begin(), reader.row().end(),
+                                                        vm[reader.index()].begin()));
+      ++read_rows;
+  }
+  ::close(fds[0]);
+  du_assert(read_rows == 6 && reader.rows() == 6);
+
+  // sparse matrices
+  my_matrix dz(5, 7, 0);
+  dz[0][6] = 1;
+  dz[2][1] = 2;
+  dz[2][4] = 3;
+  dz[4][1] = 4;
+  sparse_matrix<int> sm(dz);
+  du_assert(sm.nonzeros() == 4 && sm.rows().size() == 5 && sm.cols().size() == 7);
+  du_assert(sm[2][4] == 3 && sm[2][3] == 0 && sm[2].size() == 7 && sm[2].nonzeros() == 2);
+  int spsum = 0;
+  for (auto row : sm.rows())
+      for (auto& x : row)
+          spsum += x;
+  du_assert(spsum == 10);
+  auto spc = sm.cols()[1];
+  auto spit = spc.begin();
+  du_assert(spc.nonzeros() == 2 && spit.index() == 2 && *spit == 2);
+  ++spit;
+  du_assert(spit.index() == 4 && *spit == 4 && ++spit == spc.end());
+  du_assert(sm.rows()[1].begin() == sm.rows()[1].end() && sm.cols()[0].begin() == sm.cols()[0].end());
+  for (auto& x : sm[2])
+      x *= 10;
+  du_assert(sm[2][1] == 20 && sm.cols()[4][2] == 30);
+  static_assert(std::ranges::random_access_range<sparse_matrix<int>::rows_t>
+             && std::ranges::random_access_range<sparse_matrix<int, csc>::ccols_t>
+             && std::ranges::forward_range<sparse_matrix<int>::crow_t>);
+  static_assert(std::ranges::view<sparse_matrix<int>::cols_t> && std::ranges::view<sparse_matrix<int>::row_t>
+             && std::ranges::borrowed_range<sparse_matrix<int>::crows_t>
+             && std::ranges::borrowed_range<sparse_matrix<int>::ccol_t>);
+  static_assert(std::ranges::sized_range<sparse_matrix<int>::rows_t>
+             && std::ranges::common_range<sparse_matrix<int>::rows_t>);
+  static_assert(std::random_access_iterator<sparse_matrix<int>::crows_t_iterator>
+             && std::same_as<std::iter_reference_t<sparse_matrix<int>::rows_t_iterator>,
+                             sparse_matrix<int>::row_t>);
+  auto sp_rows = sm.rows().begin();
+  auto sp_row2 = sp_rows[2];
+  ++sp_rows;
+  du_assert(sp_row2[1] == 20 && (*sp_rows).nonzeros() == 0 && sp_rows->size() == 7);
+  du_assert(std::ranges::count_if(sm.crows(), [](auto row) { return row.nonzeros() > 0; }) == 3);
+  sparse_matrix<int, csc> spcsc(sm);
+  du_assert(spcsc.nonzeros() == 4 && spcsc.cols()[1].nonzeros() == 2 && spcsc[2][4] == 30);
+  du_assert(spcsc.rows()[2].begin().index() == 1);
+  my_matrix spd = spcsc.to_dense();
+  du_assert(spd[2][1] == 20 && spd[0][6] == 1 && spd[1][1] == 0);
+  std::vector<sparse_entry<int> > entries = { { 1, 2, 5 }, { 0, 0, 1 }, { 1, 2, 2 }, { 1, 0, 3 } };
+  sparse_matrix<int, csc> spe(2, 3, entries.begin(), entries.end());
+  du_assert(spe.nonzeros() == 3 && spe[1][2] == 7 && spe[1][0] == 3 && spe.offsets()[1] == 2);
+  du_assert(sparse_matrix<int>(vm.block(0, 0, 2, 2)).nonzeros() == 3);
+  du_assert(sparse_matrix<double>(matrix<double>()).nonzeros() == 0);
+  du_assert(sparse_matrix<double>(matrix<double>(3, 0, 0.0)).rows().size() == 3);
+  du_assert((sparse_matrix<double, csc>(matrix<double, column_major>(0, 3, 0.0)).cols().size() == 3));
+  std::vector<int> spx = { 1, 2, 3, 4, 5, 6, 7 };
+  std::vector<int> spy(5), spy2(5);
+  spmv(matrix_execution::par.on(pool), sm, spx, spy);
+  spmv(matrix_execution::seq, spcsc, spx, spy2);
+  du_assert(spy == spy2 && spy[2] == 20 * 2 + 30 * 5 && spy[0] == 7);
+  du_assert(equals_naive_product(spd, my_matrix(vm.block(0, 0, 6, 7).transposed()),
+                                 sm * vm.block(0, 0, 6, 7).transposed()));
+  du_assert(equals_naive_product(spd, my_matrix(vmc.block(0, 0, 6, 7).transposed()),
+                                 spmm(matrix_execution::par.on(pool), spcsc,
+                                      my_matrix(vmc.block(0, 0, 6, 7).transposed()))));
+
+  // copy-on-write matrices
+  cow_matrix<int> cw(gm, 8);
+  du_assert(cw.band_count() == 7 && cw.band_rows(6) == 2 && cw.rows().size() == 50);
+  cow_matrix<int> cw2 = cw;
+  cow_matrix<int> cw3(cw);
+  cw3 = cw2;
+  du_assert(cw.shared(0) && cw.band(3).data() == cw3.band(3).data());
+  cw2[17][5] = -7;
+  du_assert(cw2.shared(0) && !cw2.shared(2) && cw.shared(2) && cw.shared(3));
+  du_assert(std::as_const(cw)[17][5] == 17005 && std::as_const(cw2)[17][5] == -7);
+  du_assert(std::as_const(cw2)[16][5] == 16005 && cw.band(0).data() == cw2.band(0).data());
+  my_matrix cwm = cw2.to_matrix();
+  du_assert(cwm[17][5] == -7 && cwm[49][69] == 49069);
+  int cwsum = 0;
+  for (auto row : cw3.rows())
+      cwsum += row[0];
+  du_assert(cwsum == 1225000);
+  cow_matrix<Complex> cwc(2, 3, Complex());
+  cow_matrix<Complex> cwc2 = cwc;
+  cwc2[1][2].re = 1.0;
+  du_assert(cwc.to_matrix()[1][2].re == 0.0 && cwc2.to_matrix()[1][2].re == 1.0);
+  du_assert(cow_matrix<int>(3, 0, 0).band(2).width() == 0);
+  cow_matrix<int> cwa(4, 3, 0, 2);
+  auto cwr = cwa[1];
+  cow_matrix<int> cwb = cwa;
+  cwr[2] = 42;
+  du_assert(std::as_const(cwb)[1][2] == 0 && std::as_const(cwa)[1][2] == 42);
+  du_assert(!cwb.shared(0) && cwb.shared(1));
+  auto cwv = cwa.mutable_band(0);
+  cow_matrix<int> cwd = cwa;
+  cwv.rows()[0][0] = 7;
+  du_assert(std::as_const(cwd)[0][0] == 0 && std::as_const(cwa)[0][0] == 7);
+  cwd = cwa;
+  cwv[1][2] = 8;
+  du_assert(std::as_const(cwd)[1][2] == 42 && std::as_const(cwa)[1][2] == 8 && cwd.shared(1));
+
+  // bounds checking policies
+  typedef matrix<int, row_major, std::allocator<int>, unchecked>    unchecked_matrix;
+  typedef matrix<int, row_major, std::allocator<int>, cheap_checks> cheap_matrix;
+  typedef matrix<int, row_major, std::allocator<int>, full_checks>  full_matrix;
+  cheap_matrix bc(gm);
+  unchecked_matrix bu(gm);
+  full_matrix bf(bu);
+  du_assert(bc[49][69] == 49069 && bu[3][4] == 3004 && bf[7][7] == 7007);
+  du_assert(sizeof(unchecked_matrix::row_t::iterator) == sizeof(my_matrix::row_t::iterator));
+  auto bounds_fail = [](auto f)
+  {
+      try
+      {
+          f();
+      }
+      catch (const du_abort_exception&)
+      {
+          return true;
+      }
+      return false;
+  };
+  du_assert(bounds_fail([&] { return bc[50][0]; }) && bounds_fail([&] { return bc[0][70]; }));
+  du_assert(bounds_fail([&] { return bc.block(40, 0, 11, 1); }));
+  du_assert(bounds_fail([&] { return matrix_view<int>(vm.data(), 2, 1, 0, 1); }));
+  du_assert(bounds_fail([&] { return *bf[0].end(); }));
+  // past the end of row 0 lies row 1: only the full policy checks iterators
+  du_assert(*bc[0].end() == 1000 && bu[0][70] == 1000 && bu.rows()[50].size() == 70);
+  matrix_view<const int, unchecked> bv = bc.block(1, 1, 2, 2);
+  du_assert(bv[1][1] == 2002 && bv[0][5] == 1006);
+  int bsum = 0;
+  for (auto row : bc.rows())
+      for (int x : row)
+          bsum += x % 1000;
+  du_assert(bsum == 50 * (69 * 70 / 2));
+  unchecked_matrix bs(3, 70, [](std::size_t i, std::size_t j) { return int(i + j); });
+  du_assert(my_matrix(bs * bf.transposed().block(0, 0, 70, 2))[2][1]
+            == (my_matrix(bs) * my_matrix(gm.transposed().block(0, 0, 70, 2)))[2][1]);
+  // shapes of combined operands are checked if any operand checks indices
+  static_assert(du1_detail::checks_indices<cheap_matrix>::value && du1_detail::checks_indices<cheap_matrix::crow_t>::value
+             && !du1_detail::checks_indices<unchecked_matrix::tile_t>::value && !du1_detail::checks_indices<int>::value);
+  du_assert(bounds_fail([&] { return bs * bc; }) && bounds_fail([&] { return bs * bc.block(0, 0, 3, 3); }));
+  du_assert(bounds_fail([&] { return my_matrix(bu + bc.block(0, 0, 3, 3)); }) && bounds_fail([&] { assign(bc[0], bu.cols()[1] + 1); }));
+  du_assert(bounds_fail([&] { return dot(bu, bc.block(0, 0, 3, 3)); }));
+  matrix_batch<int, std::allocator<int>, cheap_checks> bba(4, 2, 3), bbb(4, 2, 3);
+  du_assert(bounds_fail([&] { return multiply(bba, bbb); }));
+  du_assert(bounds_fail([&] { transform(matrix_execution::seq, bu, cheap_matrix(3, 3, 0), [](int x) { return x; }); }));
+  du_assert(bounds_fail([&] { return spmm(matrix_execution::seq, sm, cheap_matrix(6, 2, 0)); }));
+  du_assert(bounds_fail([&] { spmv(matrix_execution::seq, sm, spx, std::span<int>(spy.data(), 4)); }));
+
+  // ranges
+  static_assert(std::ranges::random_access_range<my_matrix::row_t>
+             && std::ranges::random_access_range<my_matrix::ccols_t>
+             && std::ranges::random_access_range<my_matrix::ctiles_t>);
+  static_assert(std::ranges::view<my_matrix::crow_t> && std::ranges::view<my_matrix::rows_t>
+             && std::ranges::view<matrix_view<const int>::cols_t>);
+  static_assert(std::ranges::borrowed_range<my_matrix::col_t>
+             && std::ranges::borrowed_range<my_matrix::crows_t>
+             && std::ranges::borrowed_range<my_matrix::tiles_t>);
+  static_assert(std::ranges::sized_range<my_matrix::rows_t> && std::ranges::common_range<my_matrix::rows_t>);
+  static_assert(std::ranges::contiguous_range<decltype(gm[0].as_span())>);
+  static_assert(std::random_access_iterator<my_matrix::crows_t_iterator>
+             && std::random_access_iterator<my_matrix::tiles_t_iterator>);
+  auto rg_found = std::ranges::find(gm.rows()[3], 3017);
+  du_assert(rg_found != gm[3].end() && &*rg_found == &gm[3][17]);
+  auto rg_sums = gm.rows()
+               | std::views::filter([](my_matrix::crow_t row) { return row[0] % 2000 == 0; })
+               | std::views::transform([](my_matrix::crow_t row)
+                     { return std::accumulate(row.begin(), row.end(), 0); });
+  du_assert(std::ranges::distance(rg_sums) == 25 && *rg_sums.begin() == 2415
+            && *std::ranges::next(rg_sums.begin()) == 2000 * 70 + 2415);
+  auto rg_col = vm.cols()[4] | std::views::reverse | std::views::take(3);
+  du_assert(std::ranges::equal(rg_col, std::vector<int>{ vm[5][4], vm[4][4], vm[3][4] }));
+  my_matrix rg(4, 5, [](std::size_t i, std::size_t j) { return int(10 * i + (7 * j) % 5); });
+  std::ranges::sort(rg[2]);
+  du_assert(std::ranges::is_sorted(rg.crows()[2]) && rg[2][0] == 20 && rg[2][4] == 24);
+  std::ranges::fill(rg.cols()[1], -1);
+  du_assert(std::ranges::count(rg.ccols()[1], -1) == 4 && rg[3][1] == -1);
+  auto rg_tiles = rg.ctiles(2, 2) | std::views::transform([](my_matrix::ctile_t t) { return t.width(); });
+  du_assert(std::ranges::count(rg_tiles, 1u) == 2);
+
+  // access profiling
+  my_matrix pm(64, 64, [](std::size_t i, std::size_t j) { return int(i * j); });
+#ifdef DU1_PROFILE
+  long long psum = 0;
+  for (auto col : pm.cols())
+      for (int x : col)
+          psum += x;
+  du1_profile::report pr = pm.profile();
+  du_assert(psum == 2016LL * 2016 && pr.enabled && pr.row_major);
+  du_assert(pr.cols.proxies == 64 && pr.cols.accesses == 4096 && pr.cols.strides[8] == 4096);
+  du_assert(pr.cols.bytes == 4096 * sizeof(int) && pr.cols.traffic == 4096 * 64);
+  du_assert(pr.rows.proxies == 0 && pr.rows.accesses == 0 && pr.tiles == 0);
+  du_assert(pr.recommendation.find("column_major") != std::string::npos);
+  du_assert(pm.transposed()[3][1] == 3 && pm.block(1, 1, 2, 2)[1][1] == 4);
+  pr = pm.profile();
+  du_assert(pr.cols.proxies == 65 && pr.cols.accesses == 4097 && pr.rows.accesses == 1);
+  my_matrix pc(pm);
+  du_assert(pc.profile().cols.accesses == 0 && pm.profile().cols.accesses == 4097);
+  pm.reset_profile();
+  du_assert(pm.profile().cols.accesses == 0);
+  for (auto row : std::as_const(pm).rows())
+      du_assert(std::ranges::count(row, 0) >= 1);
+  pr = pm.profile();
+  du_assert(pr.rows.accesses == 4096 && pr.rows.strides[2] == 4096 && pr.rows.traffic == pr.rows.bytes);
+  du_assert(pr.recommendation.find("matches") != std::string::npos);
+  my_matrix pl(512, 512, 1);
+  long long plsum = 0;
+  for (auto row : pl.rows())
+      plsum += std::accumulate(row.begin(), row.end(), 0LL);
+  for (auto col : pl.cols())
+      plsum += std::accumulate(col.begin(), col.end(), 0LL);
+  for (auto tile : pl.ctiles())
+      plsum += tile[0][0];
+  pr = pl.profile();
+  du_assert(plsum == 2 * 512 * 512 + static_cast<long long>(pl.ctiles().size()) && pr.tiles == pl.ctiles().size());
+  du_assert(pr.recommendation.find("tiles()") != std::string::npos);
+  std::ostringstream pout;
+  pout << pr;
+  du_assert(pout.str().find("strides: 2048B+ x262144") != std::string::npos);
+#else
+  du_assert(!pm.profile().enabled && pm.profile().rows.accesses == 0);
+  static_assert(sizeof(my_matrix::row_t::iterator) == 2 * sizeof(int*) + sizeof(std::ptrdiff_t) + sizeof(std::size_t)
+             && sizeof(my_matrix::rows_t) == sizeof(int*) + 2 * sizeof(std::ptrdiff_t) + 2 * sizeof(std::size_t)
+             && sizeof(matrix_view<int>) == sizeof(int*) + 2 * sizeof(std::ptrdiff_t) + 2 * sizeof(std::size_t)
+             && sizeof(my_matrix) == sizeof(std::vector<int>) + 3 * sizeof(std::size_t));
+#endif
+
+  // reductions
+  my_matrix rd(37, 53, [](std::size_t i, std::size_t j) { return int(i * 53 + j); });
+  du_assert(sum(rd) == 1961 * 1960 / 2 && sum(rd[2]) == 53 * 106 + 53 * 52 / 2);
+  du_assert(min(rd) == 0 && max(rd.cols()[3]) == 36 * 53 + 3 && mean(rd.crows()[1]) == 79);
+  du_assert(sum(rd.block(1, 2, 3, 4)) == 4 * 53 * (1 + 2 + 3) + 3 * (2 + 3 + 4 + 5));
+  du_assert(sum(rd.tiles(8, 8)[5]) == sum(rd.block(0, 40, 8, 8)) && sum(rd.transposed()) == sum(rd));
+  du_assert(dot(rd[1], rd.crows()[2]) == std::inner_product(rd[1].begin(), rd[1].end(), rd[2].begin(), 0));
+  du_assert(norm(rd.cols()[0]) == std::sqrt(double(dot(rd.cols()[0], rd.cols()[0]))));
+  std::vector<int> rd_cols = col_sums(rd);
+  std::vector<int> rd_rows = row_sums(matrix_execution::par, rd);
+  du_assert(rd_cols.size() == 53 && rd_cols[4] == 53 * 36 * 37 / 2 + 37 * 4);
+  du_assert(rd_rows.size() == 37 && rd_rows[5] == sum(rd[5]) && col_sums(rd.transposed()) == rd_rows);
+  du_assert(col_sums(matrix<int, column_major>(rd)) == rd_cols);
+  matrix<double> rf(300, 211, [](std::size_t i, std::size_t j) { return std::sin(double(i * 211 + j)) * 1e3; });
+  matrix<double, column_major> rfc(rf);
+  thread_pool rpool(3);
+  long double rref = 0;
+  for (auto row : rf.crows())
+      for (double x : row)
+          rref += x;
+  for (summation mode : { summation::pairwise, summation::kahan })
+  {
+      double rs = sum(rf, mode);
+      du_assert(rs == sum(matrix_execution::par, rf, mode) && rs == sum(matrix_execution::par.on(rpool), rf, mode));
+      du_assert(std::abs(rs - double(rref)) < 1e-9 && std::abs(sum(rfc, mode) - rs) < 1e-9);
+      du_assert(col_sums(rf, mode) == col_sums(matrix_execution::par.on(rpool), rf, mode));
+      du_assert(row_sums(rfc, mode) == row_sums(matrix_execution::par, rfc, mode));
+      du_assert(dot(rf, rfc, mode) == dot(matrix_execution::par, rf, rfc, mode));
+      du_assert(std::abs(col_sums(rfc, mode)[17] - col_sums(rf, mode)[17]) < 1e-9);
+  }
+  du_assert(std::abs(sum(rf, summation::kahan) - double(rref)) <= 1e-12 * 300 * 211 * 1e3);
+  du_assert(min(matrix_execution::par, rf) == *std::min_element(rf.data(), rf.data() + 300 * 211));
+  du_assert(max(rf.every(2, 3)) <= max(rf) && max(rf) > 999.9);
+  du_assert(std::abs(norm(rf) * norm(rf) - dot(rf, rf)) < 1e-6 * dot(rf, rf));
+  matrix<Complex> rcx(5, 3, unit);
+  du_assert(sum(rcx).im == 15.0 && col_sums(rcx)[1].im == 5.0);
+
+  // static matrices
+  typedef static_matrix<int, 2, 3> static_2x3;
+  static constexpr static_2x3 sa(1, 2, 3,
+                                 4, 5, 6);
+  static_assert(sa[1][2] == 6 && sa.cols()[1][1] == 5 && sa.get<0, 2>() == 3);
+  static_assert((sa * sa.transpose()).get<1, 1>() == 16 + 25 + 36 && (sa * sa.transpose()).width() == 2);
+  static_assert(sa.block<0, 1, 2, 2>() == static_matrix<int, 2, 2>(2, 3, 5, 6));
+  static_assert(sa + sa == 2 * sa && (sa - sa) == static_2x3());
+  static_assert([] {
+      static_2x3 m(sa);
+      int total = 0;
+      for (auto row : m.rows())
+          for (int x : row)
+              total += x;
+      std::ranges::sort(m.cols()[0], std::greater<int>());
+      return total == 21 && m[0][0] == 4 && *std::ranges::max_element(m.crows()[1]) == 6;
+  }());
+  static_assert(sizeof(static_matrix<double, 4, 4>) == 16 * sizeof(double)
+             && std::is_trivially_copyable<static_matrix<double, 4, 4> >::value);
+  static_matrix<double, 3, 3, column_major> rot([](std::size_t i, std::size_t j) { return double(3 * i + j); });
+  du_assert(rot[2][0] == 6.0 && rot.data()[1] == 3.0 && rot.cols()[1].as_span()[2] == 7.0);
+  du_assert((rot * static_matrix<double, 3, 3>::identity() == rot) && rot.transpose()[0][2] == 6.0);
+  du_assert(sum(rot) == 36.0 && col_sums(rot)[2] == 15.0 && max(rot.crows()[1]) == 5.0);
+  my_matrix ssm(static_matrix<int, 3, 2>(sa.transpose()).view());
+  du_assert(ssm.rows().size() == 3 && ssm[2][1] == 6 && static_2x3(my_matrix(sa.view()).block(0, 0, 2, 3)) == sa);
+  du_assert(bounds_fail([&] { return static_2x3(ssm.block(0, 0, 3, 2)); }));
+
+  // matrix batches
+  matrix_batch<int> mba(100, 3, 4, [](std::size_t k, std::size_t i, std::size_t j) { return int(k + 10 * i + j); });
+  matrix_batch<int> mbb(100, 4, 2, [](std::size_t k, std::size_t i, std::size_t j) { return int(k % 7) - int(i * j); });
+  du_assert(mba.size() == 100 && mba.height() == 3 && mba.width() == 4 && mba.lane_stride() == 112);
+  du_assert(mba[7][2][3] == 30 && mba[7].cols()[3][2] == 30 && mba.lane(2, 3)[7] == 30 && mba.get(7)[2][3] == 30);
+  du_assert(std::ranges::equal(mba[9].rows()[1], std::vector<int>{ 19, 20, 21, 22 }));
+  matrix_batch<int> mbc = mba * mbb;
+  matrix_batch<int> mbp = multiply(matrix_execution::par.on(rpool), mba, mbb);
+  du_assert(mbc.height() == 3 && mbc.width() == 2);
+  for (std::size_t k = 0; k < mba.size(); ++k)
+  {
+      my_matrix prod = mba.get(k) * mbb.get(k);
+      my_matrix mck = mbc.get(k);
+      my_matrix mpk = mbp.get(k);
+      du_assert(std::equal(prod.data(), prod.data() + 6, mck.data()) && std::equal(prod.data(), prod.data() + 6, mpk.data()));
+  }
+  matrix_batch<int> mbt = mba.transpose();
+  du_assert(mbt.height() == 4 && mbt.width() == 3 && mbt[42][3][1] == mba[42][1][3] && mbt[42].rows()[2][0] == 44);
+  std::vector<int> mbsums = sums(matrix_execution::par, mba);
+  du_assert(mbsums.size() == 100 && mbsums[5] == sum(mba[5]) && mbsums == sums(mba));
+  du_assert(mins(mba)[3] == 3 && maxs(matrix_execution::par.on(rpool), mba)[3] == 26);
+  mba[1][0][0] = -5;
+  mba.set(2, my_matrix(3, 4, 8));
+  du_assert(mins(mba)[1] == -5 && mba[2][1][1] == 8 && mba[3][1][1] == 14);
+  du_assert(bounds_fail([&] { mba.set(0, my_matrix(4, 3, 0)); }) && bounds_fail([&] { return mba[100]; }));
+  matrix_batch<double> mbe(3, 2, 0);
+  du_assert(mbe[0].height() == 2 && mbe[2].width() == 0 && sums(mbe) == std::vector<double>(3, 0.0));
+  matrix_batch<double> mbd(5000, 4, 4, [](std::size_t k, std::size_t i, std::size_t j) { return std::cos(double(k * 16 + i * 4 + j)); });
+  matrix_batch<double> mbdd = multiply(matrix_execution::par.on(rpool), mbd, mbd);
+  for (std::size_t k : { std::size_t(0), std::size_t(1234), std::size_t(4999) })
+  {
+      matrix<double> prod = mbd.get(k) * mbd.get(k);
+      for (std::size_t i = 0; i < 4; ++i)
+          for (std::size_t j = 0; j < 4; ++j)
+              du_assert(std::abs(mbdd[k][i][j] - prod[i][j]) < 1e-12);
+  }
+
+  // tracked aggregates
+  tracked_matrix<int> ta(rd, 8, 16);
+  du_assert(ta.tile_rows() == 5 && ta.tile_cols() == 4 && ta.dirty_tiles() == 0);
+  ta.set(0, 0, 1);
+  du_assert(ta.dirty_tiles() == 0);
+  ta.track(aggregate::sum);
+  ta.track(aggregate::count);
+  ta.track(aggregate::min);
+  ta.track(aggregate::max);
+  du_assert(ta.dirty_tiles() == 20 && ta.tracking(aggregate::max));
+  du_assert(ta.row_sums()[5] == sum(rd[5]) && ta.dirty_tiles() == 0);
+  du_assert(ta.col_sums()[4] == rd_cols[4] && ta.col_sums()[0] == rd_cols[0] + 1);
+  du_assert(ta.row_counts()[0] == 53 && ta.col_counts()[1] == 37 && ta.row_mins()[0] == 1);
+  du_assert(ta.col_maxs()[52] == 36 * 53 + 52 && ta.row_maxs()[3] == 3 * 53 + 52);
+  ta.set(20, 30, -7);
+  ta.set(21, 31, 0);
+  du_assert(ta.dirty_tiles() == 1);
+  ta.block(32, 48, 5, 5)[4][4] = 100000;
+  du_assert(ta.dirty_tiles() == 2);
+  ta[9][50] += 3;
+  ta.col(2)[35] = 0;
+  du_assert(ta.dirty_tiles() == 10 && std::as_const(ta)[9][50] == 9 * 53 + 53);
+  ta.refresh();
+  du_assert(ta.dirty_tiles() == 0);
+  tracked_matrix<int> tfresh(ta.base(), 8, 16);
+  for (aggregate a : { aggregate::sum, aggregate::count, aggregate::min, aggregate::max })
+      tfresh.track(a);
+  du_assert(ta.row_sums() == tfresh.row_sums() && ta.col_sums() == tfresh.col_sums());
+  du_assert(ta.row_counts() == tfresh.row_counts() && ta.col_counts() == tfresh.col_counts());
+  du_assert(ta.row_mins() == tfresh.row_mins() && ta.col_maxs() == tfresh.col_maxs());
+  du_assert(ta.row_mins()[20] == -7 && ta.col_counts()[31] == 36 && ta.col_counts()[2] == 36);
+  du_assert(ta.row_maxs()[36] == 100000 && ta.col_sums()[52] == rd_cols[52] - (36 * 53 + 52) + 100000);
+  du_assert(ta.row_sums() == row_sums(ta.view()) && ta.col_sums() == col_sums(ta.view()));
+  ta.untrack(aggregate::min);
+  ta.tile(4, 3)[0][0] = 5;
+  du_assert(!ta.tracking(aggregate::min) && ta.dirty_tiles() == 1 && bounds_fail([&] { return ta.row_mins(); }));
+  du_assert(bounds_fail([&] { ta.set(37, 0, 1); }) && bounds_fail([&] { return ta.tile(5, 0); }));
+  tracked_matrix<double, column_major> tb(300, 211, 0.0);
+  tb.track(aggregate::sum);
+  for (std::size_t i = 0; i < 300; ++i)
+      for (std::size_t j = 0; j < 211; ++j)
+          tb.set(i, j, rf[i][j]);
+  tracked_matrix<double, column_major> tbf(rfc);
+  tbf.track(aggregate::sum);
+  du_assert(tb.row_sums() == tbf.row_sums() && tb.col_sums() == tbf.col_sums());
+  du_assert(std::abs(tb.col_sums()[17] - col_sums(rf)[17]) < 1e-9 && tb.dirty_tiles() == 0);
+  tb.set(150, 100, 1e6);
+  du_assert(tb.dirty_tiles() == 1 && std::abs(tb.row_sums()[150] - (sum(rf[150]) - rf[150][100] + 1e6)) < 1e-6);
+  tracked_matrix<int> tc(2, 2, 1, 1, 1);
+  tc.track(aggregate::sum);
+  auto tcr = tc.row(0);
+  du_assert(tc.row_sums()[0] == 2 && tc.dirty_tiles() == 0);
+  tcr[0] = 100;
+  du_assert(tc.row_sums()[0] == 2 && tc.row(0)[1] == 1 && tc.row_sums()[0] == 101);
+  tc.modify_row(0, [&](auto r)
+      {
+          r[0] = 1;
+          du_assert(tc.row_sums()[0] == 2 && tc.dirty_tiles() == 0);
+          r[0] = 100;
+          r[1] = 3;
+      });
+  du_assert(tc.dirty_tiles() == 2 && tc.row_sums()[0] == 103 && tc.col_sums()[1] == 4);
+  tc.modify_col(1, [](auto c) { c[1] = 5; });
+  tc.modify_tile(1, 0, [](auto v) { v[0][0] = 6; });
+  tc.modify_block(0, 0, 0, 2, [](auto v) { du_assert(v.height() == 0); });
+  du_assert(tc.dirty_tiles() == 3 && tc.row_sums()[1] == 11 && tc.col_sums()[0] == 106);
+  du_assert(bounds_fail([&] { tc.modify_block(1, 0, 1, 2, [](auto v) { v[0][1] = 7; throw du_abort_exception(); }); })
+            && tc.dirty_tiles() == 2 && tc.row_sums()[1] == 13);
+
   // const iterators
   std::for_each(c.rows().cbegin(), c.rows().cend(),
       [](my_matrix::crows_t::reference row)
@@ -0,0 +1,707 @@
+#ifndef DU1_TRACKED_HPP
+#define DU1_TRACKED_HPP
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "du1debug.hpp"
+#include "du1matrix.hpp"
+
+//   tracked_matrix class template
+//   =============================
+//
+//   Overview
+//   --------
+//
+//   A matrix that keeps aggregates of its rows and columns up to date
+// without rescanning the whole matrix after every change. The aggregates are
+// registered with track():
+//
+//   aggregate::sum    - row_sums(), col_sums()
+//   aggregate::count  - row_counts(), col_counts(): elements different
+//                       from T()
+//   aggregate::min    - row_mins(), col_mins()
+//   aggregate::max    - row_maxs(), col_maxs()
+//
+// and read through the members listed, which return a std::vector with one
+// value per row or column (the minimum and maximum of an empty line do not
+// exist, those members require a non-empty matrix). min and max can only be
+// tracked for types with operator<.
+//
+//   The matrix is divided into tiles of tile_height() * tile_width() elements
+// (by default those of matrix::tiles()). Every member that hands out mutable
+// access marks the tiles it can reach as dirty:
+//
+//   set(i, j, value)             - the tile of (i, j)
+//   tile(ti, tj)                 - that tile, as a matrix_view
+//   block(row, col, h, w)        - the tiles the block overlaps
+//   operator[](i), row(i)        - the tiles of row i
+//   col(j)                       - the tiles of column j
+//
+// even if nothing is written in the end; reading goes through the const
+// members (operator[] const, rows(), cols(), view(), ...), which mark
+// nothing. The aggregates are brought up to date on demand (or by
+// refresh()), recomputing the dirty tiles only: after changing k elements
+// with set(), a refresh costs O(k * tile size) plus the lines they belong to,
+// instead of O(height() * width()). Writing through row proxies is
+// convenient, but dirties a whole band of tile_height() rows per row.
+//
+//   The marks are set when the proxy or view is handed out, and a refresh
+// (including the implicit one of every aggregate read) clears them, so
+// a mutable proxy is only good until the next aggregate read: writes through
+// it after that are not seen by the aggregates until its tiles are marked
+// again. Get a new proxy after reading aggregates, or use the scoped
+// versions, which mark the tiles when the function returns (or throws):
+//
+//   modify_row(i, f), modify_col(j, f)    - f(row_t), f(col_t)
+//   modify_tile(ti, tj, f)                - f(matrix_view)
+//   modify_block(row, col, h, w, f)       - f(matrix_view)
+//
+//   t.modify_row(0, [&](auto r)
+//   {
+//       if (t.row_sums()[0] < limit)
+//           r[0] = 100;                   // seen by the next row_sums()
+//   });
+//
+//   Implementation details
+//   ----------------------
+//
+//   For every tracked aggregate, each tile keeps the partial aggregate of each
+// of its rows and of each of its columns (about height() * width() /
+// tile_width() + height() * width() / tile_height() values). A refresh
+// recomputes the partials of the dirty tiles, then combines the partials of
+// the rows of the dirty tile rows and of the columns of the dirty tile
+// columns. Elements are combined in order along each line within a tile, and
+// partials in tile order, so the result only depends on the contents of the
+// matrix, not on the history of the changes: a sum is bitwise the same as
+// that of a freshly constructed tracked_matrix.
+//
+//   The dirty tiles are kept in a list, so a refresh does not look at the
+// clean ones. When no aggregate is tracked, nothing is marked. The caches
+// are updated by const members, so like a matrix, a tracked_matrix must not
+// be used by several threads at once, not even for reading the aggregates.
+//
+enum class aggregate
+{
+    sum,
+    count,
+    min,
+    max
+};
+
+namespace du1_detail
+{
+    // Partials and results of one aggregate, see tracked_matrix.
+    template <typename R>
+    struct tracked_values
+    {
+        std::vector<R> row_parts; // [row * tile columns + tile column]
+        std::vector<R> col_parts; // [tile row * width + column]
+        std::vector<R> rows;
+        std::vector<R> cols;
+    };
+
+    template <typename T>
+    struct tracked_sum
+    {
+        T operator()(const T& x) const
+        {
+            return x;
+        }
+
+        T operator()(const T& a, const T& b) const
+        {
+            return a + b;
+        }
+    };
+
+    template <typename T>
+    struct tracked_count
+    {
+        std::size_t operator()(const T& x) const
+        {
+            return x != T() ? 1 : 0;
+        }
+
+        std::size_t operator()(std::size_t a, std::size_t b) const
+        {
+            return a + b;
+        }
+    };
+
+    template <typename T>
+    struct tracked_min
+    {
+        T operator()(const T& x) const
+        {
+            return x;
+        }
+
+        T operator()(const T& a, const T& b) const
+        {
+            return b < a ? b : a;
+        }
+    };
+
+    template <typename T>
+    struct tracked_max
+    {
+        T operator()(const T& x) const
+        {
+            return x;
+        }
+
+        T operator()(const T& a, const T& b) const
+        {
+            return a < b ? b : a;
+        }
+    };
+}
+
+template <typename T, typename Layout = row_major, typename Alloc = std::allocator<T>,
+          typename Check = default_checks>
+class tracked_matrix
+{
+    typedef tracked_matrix<T, Layout, Alloc, Check> self;
+
+public:
+    typedef matrix<T, Layout, Alloc, Check> matrix_type;
+
+    typedef Alloc          allocator_type;
+    typedef T              value_type;
+    typedef T&             reference;
+    typedef T*             pointer;
+    typedef const T&       const_reference;
+    typedef const T*       const_pointer;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::size_t    size_type;
+
+    typedef typename matrix_type::col_t   col_t;
+    typedef typename matrix_type::ccol_t  ccol_t;
+    typedef typename matrix_type::row_t   row_t;
+    typedef typename matrix_type::crow_t  crow_t;
+    typedef typename matrix_type::ccols_t ccols_t;
+    typedef typename matrix_type::crows_t crows_t;
+
+    // Constructors. A tile extent of 0 selects the default.
+    tracked_matrix()
+        : tracked_matrix(matrix_type())
+    { }
+
+    tracked_matrix(size_type rows, size_type cols, const value_type& def,
+                   size_type tile_height = 0, size_type tile_width = 0,
+                   const allocator_type& alloc = allocator_type())
+        : tracked_matrix(matrix_type(rows, cols, def, alloc), tile_height, tile_width)
+    { }
+
+    explicit tracked_matrix(matrix_type m, size_type tile_height = 0, size_type tile_width = 0)
+        : m_(std::move(m))
+        , tile_height_(tile_height > 0 ? tile_height : matrix_type::default_tile_height)
+        , tile_width_(tile_width > 0 ? tile_width : matrix_type::default_tile_width)
+        , dirty_(tile_rows() * tile_cols())
+        , dirty_list_()
+        , sums_()
+        , counts_()
+        , mins_()
+        , maxs_()
+    { }
+
+    // Extents.
+    size_type height() const
+    {
+        return m_.rows().size();
+    }
+
+    size_type width() const
+    {
+        return m_.cols().size();
+    }
+
+    size_type tile_height() const
+    {
+        return tile_height_;
+    }
+
+    size_type tile_width() const
+    {
+        return tile_width_;
+    }
+
+    size_type tile_rows() const
+    {
+        return (height() + tile_height_ - 1) / tile_height_;
+    }
+
+    size_type tile_cols() const
+    {
+        return (width() + tile_width_ - 1) / tile_width_;
+    }
+
+    // Read access, nothing is marked.
+    ccols_t cols() const
+    {
+        return m_.cols();
+    }
+
+    ccols_t ccols() const
+    {
+        return m_.ccols();
+    }
+
+    crows_t rows() const
+    {
+        return m_.rows();
+    }
+
+    crows_t crows() const
+    {
+        return m_.crows();
+    }
+
+    crow_t operator[](size_type n) const
+    {
+        return m_[n];
+    }
+
+    matrix_view<const T, Check> view() const
+    {
+        return matrix_view<const T, Check>(m_);
+    }
+
+    const matrix_type& base() const
+    {
+        return m_;
+    }
+
+    // Mutable access, marks the tiles that can be reached.
+    void set(size_type i, size_type j, const value_type& value)
+    {
+        du_check(Check::indices, i < height() && j < width());
+
+        mark(i / tile_height_, i / tile_height_ + 1, j / tile_width_, j / tile_width_ + 1);
+        m_[i][j] = value;
+    }
+
+    matrix_view<T, Check> tile(size_type ti, size_type tj)
+    {
+        du_check(Check::indices, ti < tile_rows() && tj < tile_cols());
+
+        mark(ti, ti + 1, tj, tj + 1);
+
+        size_type row = ti * tile_height_;
+        size_type col = tj * tile_width_;
+        return m_.block(row, col, std::min(tile_height_, height() - row), std::min(tile_width_, width() - col));
+    }
+
+    matrix_view<T, Check> block(size_type row, size_type col, size_type height, size_type width)
+    {
+        matrix_view<T, Check> result = m_.block(row, col, height, width);
+
+        if (height > 0 && width > 0)
+            mark(row / tile_height_, (row + height - 1) / tile_height_ + 1,
+                 col / tile_width_, (col + width - 1) / tile_width_ + 1);
+
+        return result;
+    }
+
+    row_t operator[](size_type n)
+    {
+        return row(n);
+    }
+
+    row_t row(size_type n)
+    {
+        row_t result = m_[n];
+
+        mark(n / tile_height_, n / tile_height_ + 1, 0, tile_cols());
+        return result;
+    }
+
+    col_t col(size_type n)
+    {
+        col_t result = m_.cols()[n];
+
+        mark(0, tile_rows(), n / tile_width_, n / tile_width_ + 1);
+        return result;
+    }
+
+    // Scoped mutable access: f gets the proxy or view, and the tiles it can
+    // reach are marked after f is done, so f may read aggregates in between.
+    template <typename F>
+    void modify_row(size_type n, F f)
+    {
+        modify(row(n), f, n / tile_height_, n / tile_height_ + 1, 0, tile_cols());
+    }
+
+    template <typename F>
+    void modify_col(size_type n, F f)
+    {
+        modify(col(n), f, 0, tile_rows(), n / tile_width_, n / tile_width_ + 1);
+    }
+
+    template <typename F>
+    void modify_tile(size_type ti, size_type tj, F f)
+    {
+        modify(tile(ti, tj), f, ti, ti + 1, tj, tj + 1);
+    }
+
+    template <typename F>
+    void modify_block(size_type row, size_type col, size_type height, size_type width, F f)
+    {
+        matrix_view<T, Check> view = block(row, col, height, width);
+
+        if (height > 0 && width > 0)
+            modify(view, f, row / tile_height_, (row + height - 1) / tile_height_ + 1,
+                   col / tile_width_, (col + width - 1) / tile_width_ + 1);
+        else
+            f(view);
+    }
+
+    // Aggregates. Registering an aggregate computes it for the whole matrix
+    // on the next refresh.
+    void track(aggregate a)
+    {
+        du_assert(ordered || (a != aggregate::min && a != aggregate::max));
+
+        if (tracking(a))
+            return;
+
+        switch (a)
+        {
+        case aggregate::sum:
+            sums_.emplace(make_values<value_type>());
+            break;
+        case aggregate::count:
+            counts_.emplace(make_values<size_type>());
+            break;
+        case aggregate::min:
+            mins_.emplace(make_values<value_type>());
+            break;
+        case aggregate::max:
+            maxs_.emplace(make_values<value_type>());
+            break;
+        }
+
+        mark(0, tile_rows(), 0, tile_cols());
+    }
+
+    void untrack(aggregate a)
+    {
+        switch (a)
+        {
+        case aggregate::sum:
+            sums_.reset();
+            break;
+        case aggregate::count:
+            counts_.reset();
+            break;
+        case aggregate::min:
+            mins_.reset();
+            break;
+        case aggregate::max:
+            maxs_.reset();
+            break;
+        }
+
+        if (!tracking_any())
+            clear_dirty();
+    }
+
+    bool tracking(aggregate a) const
+    {
+        switch (a)
+        {
+        case aggregate::sum:
+            return sums_.has_value();
+        case aggregate::count:
+            return counts_.has_value();
+        case aggregate::min:
+            return mins_.has_value();
+        case aggregate::max:
+            return maxs_.has_value();
+        }
+        return false;
+    }
+
+    // Number of tiles a refresh would recompute.
+    size_type dirty_tiles() const
+    {
+        return dirty_list_.size();
+    }
+
+    void refresh() const
+    {
+        if (dirty_list_.empty())
+            return;
+
+        for_each_tracked([&](auto op, auto& values)
+        {
+            for (size_type t : dirty_list_)
+                update_tile(op, values, t / tile_cols(), t % tile_cols());
+        });
+
+        // Tile rows and columns containing dirty tiles.
+        std::vector<unsigned char> band(tile_rows());
+        std::vector<unsigned char> stripe(tile_cols());
+        for (size_type t : dirty_list_)
+        {
+            band[t / tile_cols()] = 1;
+            stripe[t % tile_cols()] = 1;
+        }
+
+        for_each_tracked([&](auto op, auto& values)
+        {
+            for (size_type ti = 0; ti < band.size(); ++ti)
+                if (band[ti])
+                    combine_rows(op, values, ti);
+
+            for (size_type tj = 0; tj < stripe.size(); ++tj)
+                if (stripe[tj])
+                    combine_cols(op, values, tj);
+        });
+
+        clear_dirty();
+    }
+
+    const std::vector<value_type>& row_sums() const
+    {
+        return results(sums_).rows;
+    }
+
+    const std::vector<value_type>& col_sums() const
+    {
+        return results(sums_).cols;
+    }
+
+    const std::vector<size_type>& row_counts() const
+    {
+        return results(counts_).rows;
+    }
+
+    const std::vector<size_type>& col_counts() const
+    {
+        return results(counts_).cols;
+    }
+
+    const std::vector<value_type>& row_mins() const
+    {
+        du_assert(width() > 0);
+
+        return results(mins_).rows;
+    }
+
+    const std::vector<value_type>& col_mins() const
+    {
+        du_assert(height() > 0);
+
+        return results(mins_).cols;
+    }
+
+    const std::vector<value_type>& row_maxs() const
+    {
+        du_assert(width() > 0);
+
+        return results(maxs_).rows;
+    }
+
+    const std::vector<value_type>& col_maxs() const
+    {
+        du_assert(height() > 0);
+
+        return results(maxs_).cols;
+    }
+
+private:
+    // Whether min and max can be tracked.
+    static constexpr bool ordered = requires (const T& x) { { x < x } -> std::convertible_to<bool>; };
+
+    template <typename R>
+    du1_detail::tracked_values<R> make_values() const
+    {
+        du1_detail::tracked_values<R> v;
+        v.row_parts.resize(height() * tile_cols());
+        v.col_parts.resize(tile_rows() * width());
+        v.rows.resize(height());
+        v.cols.resize(width());
+        return v;
+    }
+
+    bool tracking_any() const
+    {
+        return sums_ || counts_ || mins_ || maxs_;
+    }
+
+    template <typename F>
+    void for_each_tracked(F f) const
+    {
+        if (sums_)
+            f(du1_detail::tracked_sum<T>(), *sums_);
+        if (counts_)
+            f(du1_detail::tracked_count<T>(), *counts_);
+        if constexpr (ordered)
+        {
+            if (mins_)
+                f(du1_detail::tracked_min<T>(), *mins_);
+            if (maxs_)
+                f(du1_detail::tracked_max<T>(), *maxs_);
+        }
+    }
+
+    template <typename R>
+    const du1_detail::tracked_values<R>& results(const std::optional<du1_detail::tracked_values<R> >& values) const
+    {
+        du_assert(values.has_value());
+
+        refresh();
+        return *values;
+    }
+
+    // Calls f(proxy), then marks the tiles [ti0, ti1) * [tj0, tj1) again,
+    // in case f read an aggregate after the proxy was handed out.
+    template <typename Proxy, typename F>
+    void modify(Proxy proxy, F& f, size_type ti0, size_type ti1, size_type tj0, size_type tj1)
+    {
+        try
+        {
+            f(proxy);
+        }
+        catch (...)
+        {
+            mark(ti0, ti1, tj0, tj1);
+            throw;
+        }
+
+        mark(ti0, ti1, tj0, tj1);
+    }
+
+    // Marks the tiles [ti0, ti1) * [tj0, tj1).
+    void mark(size_type ti0, size_type ti1, size_type tj0, size_type tj1)
+    {
+        if (!tracking_any())
+            return;
+
+        for (size_type ti = ti0; ti < ti1; ++ti)
+            for (size_type tj = tj0; tj < tj1; ++tj)
+            {
+                size_type t = ti * tile_cols() + tj;
+                if (!dirty_[t])
+                {
+                    dirty_[t] = 1;
+                    dirty_list_.push_back(t);
+                }
+            }
+    }
+
+    void clear_dirty() const
+    {
+        for (size_type t : dirty_list_)
+            dirty_[t] = 0;
+        dirty_list_.clear();
+    }
+
+    // Recomputes the partials of tile (ti, tj). The tile is walked along its
+    // storage order; either way, each partial combines its elements in order.
+    template <typename Op, typename R>
+    void update_tile(Op op, du1_detail::tracked_values<R>& values, size_type ti, size_type tj) const
+    {
+        size_type row = ti * tile_height_;
+        size_type col = tj * tile_width_;
+        size_type h = std::min(tile_height_, height() - row);
+        size_type w = std::min(tile_width_, width() - col);
+
+        difference_type rs = m_.row_step();
+        difference_type cs = m_.col_step();
+        const T* first = m_.data() + static_cast<difference_type>(row) * rs + static_cast<difference_type>(col) * cs;
+
+        R* row_parts = values.row_parts.data() + row * tile_cols() + tj;
+        R* col_parts = values.col_parts.data() + ti * width() + col;
+        difference_type row_parts_step = static_cast<difference_type>(tile_cols());
+
+        if (rs >= cs)
+            update_lines(op, first, h, rs, row_parts, row_parts_step, w, cs, col_parts, 1);
+        else
+            update_lines(op, first, w, cs, col_parts, 1, h, rs, row_parts, row_parts_step);
+    }
+
+    // Outer lines of inner elements: out[k] is the partial of outer line k,
+    // across[l] that of element l of all outer lines.
+    template <typename Op, typename R>
+    static void update_lines(Op op, const T* first, size_type outer, difference_type outer_step,
+                             R* out, difference_type out_step, size_type inner, difference_type inner_step,
+                             R* across, difference_type across_step)
+    {
+        for (size_type k = 0; k < outer; ++k)
+        {
+            const T* line = first + static_cast<difference_type>(k) * outer_step;
+
+            R partial = op(line[0]);
+            for (size_type l = 1; l < inner; ++l)
+                partial = op(partial, op(line[static_cast<difference_type>(l) * inner_step]));
+            out[static_cast<difference_type>(k) * out_step] = partial;
+
+            if (k == 0)
+                for (size_type l = 0; l < inner; ++l)
+                    across[static_cast<difference_type>(l) * across_step] = op(line[static_cast<difference_type>(l) * inner_step]);
+            else
+                for (size_type l = 0; l < inner; ++l)
+                {
+                    R& a = across[static_cast<difference_type>(l) * across_step];
+                    a = op(a, op(line[static_cast<difference_type>(l) * inner_step]));
+                }
+        }
+    }
+
+    template <typename Op, typename R>
+    void combine_rows(Op op, du1_detail::tracked_values<R>& values, size_type ti) const
+    {
+        size_type end = std::min(height(), (ti + 1) * tile_height_);
+
+        for (size_type i = ti * tile_height_; i < end; ++i)
+        {
+            const R* parts = values.row_parts.data() + i * tile_cols();
+
+            R result = parts[0];
+            for (size_type tj = 1; tj < tile_cols(); ++tj)
+                result = op(result, parts[tj]);
+            values.rows[i] = result;
+        }
+    }
+
+    template <typename Op, typename R>
+    void combine_cols(Op op, du1_detail::tracked_values<R>& values, size_type tj) const
+    {
+        size_type first = tj * tile_width_;
+        size_type last = std::min(width(), first + tile_width_);
+        R* result = values.cols.data();
+
+        std::copy(values.col_parts.begin() + static_cast<difference_type>(first),
+                  values.col_parts.begin() + static_cast<difference_type>(last), result + first);
+
+        for (size_type ti = 1; ti < tile_rows(); ++ti)
+        {
+            const R* parts = values.col_parts.data() + ti * width();
+            for (size_type j = first; j < last; ++j)
+                result[j] = op(result[j], parts[j]);
+        }
+    }
+
+    matrix_type m_;
+    size_type   tile_height_;
+    size_type   tile_width_;
+
+    // Dirty flags per tile, and the list of the dirty tiles.
+    mutable std::vector<unsigned char> dirty_;
+    mutable std::vector<size_type>     dirty_list_;
+
+    mutable std::optional<du1_detail::tracked_values<value_type> > sums_;
+    mutable std::optional<du1_detail::tracked_values<size_type> >  counts_;
+    mutable std::optional<du1_detail::tracked_values<value_type> > mins_;
+    mutable std::optional<du1_detail::tracked_values<value_type> > maxs_;
+};
+
+#endif // DU1_TRACKED_HPP